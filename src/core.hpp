@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -22,15 +22,32 @@
 #include <chrono>
 #include <thread>
 #include <array>
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdio>
 #include <climits>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // Windows Libraries //
 #ifdef _WIN32
 
 #include <Windows.h>
 #include <shlobj.h>
+#include <io.h>
+
+// POSIX Libraries //
+#else
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #endif
 
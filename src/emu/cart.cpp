@@ -36,22 +36,14 @@ Cartridge::Cartridge(const std::string& rom_path, MMU& mem)
 		throw std::invalid_argument("File is not a .gb Gameboy ROM.");
 	}
 
-	// Assuming file is readable, since it passed exist() check
-	RomFile.open(rom_file_path, std::ios::binary);
-
 	// Load the ROM file. Throws exceptions which are caught above this.
 	loadROM(mem);
-
-	RomFile.close();
 }
 
 
 
 // Destructor
-Cartridge::~Cartridge()
-{
-	RomFile.close();
-}
+Cartridge::~Cartridge() = default;
 
 
 
@@ -86,24 +78,33 @@ int Cartridge::getRAMBankAmount()
 
 
 
-// Loads the RomFile from the rom_file_path
+// Gets the ROM image
+std::shared_ptr<const RomImage> Cartridge::getROMImage()
+{
+	return rom;
+}
+
+
+
+// Loads the ROM image from the rom_file_path into the MMU
 void Cartridge::loadROM(MMU& mem)
 {
+	// Map the whole file, or share the image if it is already loaded.
+	// Throws if it can't be read at all.
+	rom = RomImage::load(rom_file_path);
+
 	// Read the ROM's header into a byte array
 	std::array<uint8_t, 80> header{}; // Header is 80 bytes between $100-$14F
-	try {
-		RomFile.seekg(0x100);
-		RomFile.read( (char*)(header.data()), 80);
-		RomFile.seekg(0); // Reset position
-
-	} catch(std::exception& ex) {
+	if(rom->size() < 0x100 + header.size())
+	{
 		Logger::instance().log("CART: Could not read ROM Header.",
 							   Logger::ERRORS);
-		Logger::instance().log(ex.what(), Logger::ERRORS);
 
-		// Rethrow with more descriptive message
 		throw std::runtime_error("ROM is corrupt: Could not read ROM Header.");
 	}
+	std::copy(rom->data() + 0x100,
+			  rom->data() + 0x100 + header.size(),
+			  header.begin());
 
 	// Check the validity of the ROM's header
 	if(!isHeaderValid(header))
@@ -167,38 +168,17 @@ void Cartridge::loadROM(MMU& mem)
 	mem.setERAM(ram_bank_amount, persistent, sav_file_path, mbc_id);
 
 
-	// Begin loading ROM data into MMU
-	try {
-		std::array<uint8_t, 0x4000> static_rom{};
-		RomFile.read((char*)(static_rom.data()), static_rom.size());
-
-		mem.setROM1(static_rom);
-
-	} catch(std::exception& ex) {
-
-		throw std::runtime_error("ROM is corrupt: Could not read static ROM");
-	}
-
-	// Load ROM banks into memory
-	// Subtract 1 because Static ROM (bank 1) is already loaded
-	std::vector< std::array<uint8_t, 0x4000> > rom_banks{};
-
-	// Iterate through every bank, reading 16kb chunks into memory
-	for(int i = 0; i < rom_bank_amount - 1; i++)
+	// Every bank has to be in the file before the MMU can point into it
+	if(rom->size() < (size_t)rom_bank_amount * 0x4000)
 	{
-		try {
-			std::array<uint8_t, 0x4000> bank{};
-			RomFile.read((char*)(bank.data()), bank.size());
-			rom_banks.push_back(bank);
-
-		} catch(std::exception& ex) {
-			throw std::runtime_error(
-					"ROM is corrupt: Could not read all ROM banks.");
-		}
+		throw std::runtime_error(
+				"ROM is corrupt: Could not read all ROM banks.");
 	}
 
-	// Send banks to MMU
-	mem.setROM2(rom_banks, rom_bank_amount);
+	// The MMU reads straight out of the image, nothing is copied.
+	// Static ROM is bank 0, every bank after it is switchable.
+	mem.setROM1(rom->data());
+	mem.setROM2(rom->data() + 0x4000, rom_bank_amount - 1);
 }
 
 
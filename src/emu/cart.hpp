@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 9 Dec 2022
- EDITED : 9 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -17,6 +17,7 @@
 #include "../core.hpp"
 #include "gbstructs.hpp"
 #include "mmu.hpp" // Cartridge loads directly into an MMU
+#include "romimage.hpp"
 
 class Cartridge
 {
@@ -36,19 +37,24 @@ public:
 	// Gets the number of RAM Banks
 	int getRAMBankAmount();
 
+	// Gets the ROM image. Shared by every Cartridge of the same file.
+	std::shared_ptr<const RomImage> getROMImage();
+
 private:
 
 	std::string rom_file_path;
 	std::string sav_file_path;
 
-	std::ifstream RomFile;
+	// The MMU points into this, so it lives as long as the Cartridge.
+	// Immutable, so every Cartridge of the same file shares one copy.
+	std::shared_ptr<const RomImage> rom;
 
 	std::string game_title; // The game's title is store inside the header.
 	int rom_bank_amount;
 	int ram_bank_amount;
 	int mbc_id;
 
-	// Loads the RomFile from the rom_file_path
+	// Loads the ROM image from the rom_file_path into the MMU
 	void loadROM(MMU& mem);
 	// Returns if the ROM header of the RomFile is valid.
 	static bool isHeaderValid(std::array<uint8_t, 80>& header);
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -13,6 +13,8 @@
 
 #include "cpu.hpp"
 
+using namespace emath;
+
 CPU::CPU()
 {
 	// Set initial register values
@@ -29,2101 +31,2622 @@ CPU::CPU()
 	regs.pc = 0x0100;
 
 	halted = false;
-	interrupts_enabled = true;
-	next_interrupt_state = true;
+	// The boot ROM hands over with interrupts disabled
+	interrupts_enabled = false;
+	next_interrupt_state = false;
+
+	engine = ENGINE_INTERPRETER;
+}
+
+
+
+// Opcode Tables //
+
+// Builds OPCODE_TABLE. Evaluated at compile time.
+constexpr std::array<CPU::OpHandler, 256> CPU::buildOpcodeTable()
+{
+	std::array<OpHandler, 256> table{};
+
+	for(OpHandler& handler : table) { handler = &CPU::opUnhandled; }
+
+	// Algorithmic ranges. Low 3 bits are the source register.
+	for(int i = 0x40; i <= 0x7F; i++) { table[i] = &CPU::opLD_r_r; }
+	for(int i = 0x80; i <= 0x87; i++) { table[i] = &CPU::opADD_A_r; }
+	for(int i = 0x88; i <= 0x8F; i++) { table[i] = &CPU::opADC_A_r; }
+	for(int i = 0x90; i <= 0x97; i++) { table[i] = &CPU::opSUB_A_r; }
+	for(int i = 0x98; i <= 0x9F; i++) { table[i] = &CPU::opSBC_A_r; }
+	for(int i = 0xA0; i <= 0xA7; i++) { table[i] = &CPU::opAND_A_r; }
+	for(int i = 0xA8; i <= 0xAF; i++) { table[i] = &CPU::opXOR_A_r; }
+	for(int i = 0xB0; i <= 0xB7; i++) { table[i] = &CPU::opOR_A_r; }
+	for(int i = 0xB8; i <= 0xBF; i++) { table[i] = &CPU::opCP_A_r; }
+
+	// 0x76 lies in the LD r1,r2 range and is a HALT instruction
+	table[0x76] = &CPU::opHALT;
+
+	table[0xCB] = &CPU::opPrefixCB;
+
+	// Load Instructions
+	table[0x00] = &CPU::opNOP;
+	table[0xF0] = &CPU::opLDH_A_na;
+	table[0x36] = &CPU::opLD_HLa_n;
+	table[0x02] = &CPU::opLD_rra_A;
+	table[0x12] = &CPU::opLD_rra_A;
+	table[0xEA] = &CPU::opLD_nna_A;
+	table[0x06] = &CPU::opLD_r_n;
+	table[0x0E] = &CPU::opLD_r_n;
+	table[0x16] = &CPU::opLD_r_n;
+	table[0x1E] = &CPU::opLD_r_n;
+	table[0x26] = &CPU::opLD_r_n;
+	table[0x2E] = &CPU::opLD_r_n;
+	table[0x3E] = &CPU::opLD_r_n;
+	table[0xE2] = &CPU::opLDH_Ca_A;
+	table[0xF2] = &CPU::opLDH_A_Ca;
+	table[0xE0] = &CPU::opLDH_na_A;
+	table[0x01] = &CPU::opLD_rr_nn;
+	table[0x11] = &CPU::opLD_rr_nn;
+	table[0x21] = &CPU::opLD_rr_nn;
+	table[0x31] = &CPU::opLD_rr_nn;
+	table[0xF9] = &CPU::opLD_SP_HL;
+	table[0xF8] = &CPU::opLD_HL_SPn;
+	table[0x08] = &CPU::opLD_nna_SP;
+	table[0x22] = &CPU::opLDI_HLa_A;
+	table[0x2A] = &CPU::opLDI_A_HLa;
+	table[0x32] = &CPU::opLDD_HLa_A;
+	table[0x3A] = &CPU::opLDD_A_HLa;
+	table[0xF5] = &CPU::opPUSH;
+	table[0xC5] = &CPU::opPUSH;
+	table[0xD5] = &CPU::opPUSH;
+	table[0xE5] = &CPU::opPUSH;
+	table[0xF1] = &CPU::opPOP;
+	table[0xC1] = &CPU::opPOP;
+	table[0xD1] = &CPU::opPOP;
+	table[0xE1] = &CPU::opPOP;
+
+	// Arithmetic Instructions
+	table[0xC6] = &CPU::opADD_A_n;
+	table[0xFE] = &CPU::opCP_A_n;
+	table[0xCE] = &CPU::opADC_A_n;
+	table[0xDE] = &CPU::opSBC_A_n;
+	table[0xE6] = &CPU::opAND_A_n;
+	table[0xF6] = &CPU::opOR_A_n;
+	table[0xEE] = &CPU::opXOR_A_n;
+	table[0x09] = &CPU::opADD_HL_rr;
+	table[0x19] = &CPU::opADD_HL_rr;
+	table[0x29] = &CPU::opADD_HL_rr;
+	table[0x39] = &CPU::opADD_HL_rr;
+	table[0xE8] = &CPU::opADD_SP_nn;
+	table[0x04] = &CPU::opINC_r;
+	table[0x0C] = &CPU::opINC_r;
+	table[0x14] = &CPU::opINC_r;
+	table[0x1C] = &CPU::opINC_r;
+	table[0x24] = &CPU::opINC_r;
+	table[0x2C] = &CPU::opINC_r;
+	table[0x34] = &CPU::opINC_r;
+	table[0x3C] = &CPU::opINC_r;
+	table[0x03] = &CPU::opINC_rr;
+	table[0x13] = &CPU::opINC_rr;
+	table[0x23] = &CPU::opINC_rr;
+	table[0x33] = &CPU::opINC_rr;
+	table[0x05] = &CPU::opDEC_r;
+	table[0x0D] = &CPU::opDEC_r;
+	table[0x15] = &CPU::opDEC_r;
+	table[0x1D] = &CPU::opDEC_r;
+	table[0x25] = &CPU::opDEC_r;
+	table[0x2D] = &CPU::opDEC_r;
+	table[0x35] = &CPU::opDEC_r;
+	table[0x3D] = &CPU::opDEC_r;
+	table[0x0B] = &CPU::opDEC_rr;
+	table[0x1B] = &CPU::opDEC_rr;
+	table[0x2B] = &CPU::opDEC_rr;
+	table[0x3B] = &CPU::opDEC_rr;
+	table[0x27] = &CPU::opDAA;
+	table[0x2F] = &CPU::opCPL;
+
+	// Control Instructions
+	table[0x3F] = &CPU::opCCF;
+	table[0x37] = &CPU::opSCF;
+	table[0x10] = &CPU::opSTOP;
+	table[0xF3] = &CPU::opDI;
+	table[0xFB] = &CPU::opEI;
+
+	// Jump Instructions
+	table[0xC3] = &CPU::opJP;
+	table[0xC2] = &CPU::opJP;
+	table[0xCA] = &CPU::opJP;
+	table[0xD2] = &CPU::opJP;
+	table[0xDA] = &CPU::opJP;
+	table[0x18] = &CPU::opJR;
+	table[0x20] = &CPU::opJR;
+	table[0x28] = &CPU::opJR;
+	table[0x30] = &CPU::opJR;
+	table[0x38] = &CPU::opJR;
+	table[0xCD] = &CPU::opCALL;
+	table[0xC4] = &CPU::opCALL;
+	table[0xCC] = &CPU::opCALL;
+	table[0xD4] = &CPU::opCALL;
+	table[0xDC] = &CPU::opCALL;
+	table[0xC9] = &CPU::opRET;
+	table[0xC0] = &CPU::opRET;
+	table[0xC8] = &CPU::opRET;
+	table[0xD0] = &CPU::opRET;
+	table[0xD8] = &CPU::opRET;
+	table[0xD9] = &CPU::opRETI;
+	table[0xC7] = &CPU::opRST;
+	table[0xCF] = &CPU::opRST;
+	table[0xD7] = &CPU::opRST;
+	table[0xDF] = &CPU::opRST;
+	table[0xE7] = &CPU::opRST;
+	table[0xEF] = &CPU::opRST;
+	table[0xF7] = &CPU::opRST;
+	table[0xFF] = &CPU::opRST;
+
+	// Rotate and Shift Instructions
+	table[0x07] = &CPU::opRLCA;
+	table[0x0F] = &CPU::opRRCA;
+	table[0x17] = &CPU::opRLA;
+	table[0x1F] = &CPU::opRRA;
+
+	return table;
+}
+
+
+// Builds CB_OPCODE_TABLE. Evaluated at compile time.
+constexpr std::array<CPU::OpHandler, 256> CPU::buildCBOpcodeTable()
+{
+	std::array<OpHandler, 256> table{};
+
+	// Every 0xCB opcode is defined. Low 3 bits are the target register.
+	for(int i = 0x00; i <= 0x07; i++) { table[i] = &CPU::opRLC; }
+	for(int i = 0x08; i <= 0x0F; i++) { table[i] = &CPU::opRRC; }
+	for(int i = 0x10; i <= 0x17; i++) { table[i] = &CPU::opRL; }
+	for(int i = 0x18; i <= 0x1F; i++) { table[i] = &CPU::opRR; }
+	for(int i = 0x20; i <= 0x27; i++) { table[i] = &CPU::opSLA; }
+	for(int i = 0x28; i <= 0x2F; i++) { table[i] = &CPU::opSRA; }
+	for(int i = 0x30; i <= 0x37; i++) { table[i] = &CPU::opSWAP; }
+	for(int i = 0x38; i <= 0x3F; i++) { table[i] = &CPU::opSRL; }
+	for(int i = 0x40; i <= 0x7F; i++) { table[i] = &CPU::opBIT; }
+	for(int i = 0x80; i <= 0xBF; i++) { table[i] = &CPU::opRES; }
+	for(int i = 0xC0; i <= 0xFF; i++) { table[i] = &CPU::opSET; }
+
+	return table;
+}
+
+
+// Constant-initialized, so the tables are built before anything runs
+const std::array<CPU::OpHandler, 256> CPU::OPCODE_TABLE
+		= CPU::buildOpcodeTable();
+const std::array<CPU::OpHandler, 256> CPU::CB_OPCODE_TABLE
+		= CPU::buildCBOpcodeTable();
+
+
+// Gets if an opcode can leave straight-line code, or changes when interrupts
+// are taken
+static bool endsBlock(uint8_t opcode)
+{
+	switch(opcode)
+	{
+		case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+		case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: // JP
+		case 0xE9: // JP (HL)
+		case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC: // CALL
+		case 0xC9: case 0xC0: case 0xC8: case 0xD0: case 0xD8: // RET
+		case 0xD9: // RETI
+		case 0x76: case 0x10: // HALT, STOP
+		case 0xF3: case 0xFB: // DI, EI
+			return true;
+		default:
+			break;
+	}
+
+	// RST
+	return (opcode & 0xC7) == 0xC7;
 }
 
+// End Opcode Tables //
+
+
 
 // Executes an opcode, returns the number of cycles used
 int CPU::execute(uint8_t opcode, MMU &mem)
 {
-	using namespace emath;
-
 	// Setup
 
-	int cycles = 0;
-	bool done = false;
-	CPUInstruction ins{};
-	ins.origin = regs.pc;
+#ifdef ASCIIBOY_TRACE
+	if(tracer.isEnabled())
+	{
+		// Operands are peeked so that tracing has no side effects
+		tracer.record(getRegisterSet(), opcode,
+					  mem.peekByte(regs.pc + 1), mem.peekByte(regs.pc + 2));
+	}
+#endif
 
-	flags.byteToFlags(regs.f);
 	regs.pc++;
 
-	Logger::instance().log(
-			fmt::format("CPU: Executing instruction 0x{:02X}.", opcode),
-			Logger::EXTREME
-			);
+	// EI and RETI take effect after the instruction that follows them
+	interrupts_enabled = next_interrupt_state;
 
 	// Decode/Execute
 
-	// Algorithmic Checks //
+	int cycles = (this->*OPCODE_TABLE[opcode])(opcode, mem);
+
+	cycles += 4; // Every instruction takes at least 4 cycles
 
-	// LD r1,r2 - Load Register 2 into Register 1
-	// Opcode 0x76 lies in this range and is a HALT instruction
-	if (opcode >= 0b01000000 && opcode <= 0b01111111 && opcode != 0x76)
+	return cycles;
+}
+
+
+
+// Executes a decoded instruction, returns the number of cycles used
+inline int CPU::executeOp(const DecodedOp& op, MMU& mem)
+{
+#ifdef ASCIIBOY_TRACE
+	if(tracer.isEnabled())
 	{
-		ins.mnemonic = "LD";
-		ins.target1 = toTarget((opcode & 0b00111000) >> 3);
-		ins.target2 = toTarget(opcode & 0b00000111);
+		tracer.record(getRegisterSet(), op.is_cb ? 0xCB : op.opcode,
+					  mem.peekByte(regs.pc + 1), mem.peekByte(regs.pc + 2));
+	}
+#endif
 
-		if (ins.target1 != HL && ins.target2 != HL)
-		{
-			// Move the value of target2 into target1
-			uint8_t value = getByteReg(ins.target2);
-			setByteReg(ins.target1, value);
+	// The fetch was done when the block was decoded, prefix included
+	regs.pc += op.is_cb ? 2 : 1;
+
+	// EI and RETI take effect after the instruction that follows them
+	interrupts_enabled = next_interrupt_state;
 
-		} else if (ins.target1 == HL) { // HL is an address
+	OpHandler handler = op.is_cb ? CB_OPCODE_TABLE[op.opcode]
+								 : OPCODE_TABLE[op.opcode];
+	int cycles = (this->*handler)(op.opcode, mem);
 
-			// Write to address $HL, value in t2
-			ins.t1_as_address = true;
+	// Every instruction takes at least 4 cycles, and a CB prefix 4 more
+	cycles += op.is_cb ? 8 : 4;
 
-			uint8_t value = getByteReg(ins.target2);
-			mem.writeByte(regs.hl, value);
-			cycles += 4;
+	return cycles;
+}
 
-		} else if(ins.target2 == HL) { // HL is an address
 
-			// Read to t1, value at address $HL
-			ins.t2_as_address = true;
+// Executes the cached block of straight-line code at PC
+CPU::BlockResult CPU::executeBlock(MMU& mem, uint64_t max_cycles)
+{
+	BlockResult result{};
+	uint16_t address = regs.pc;
 
-			uint8_t value = mem.readByte(regs.hl);
-			setByteReg(ins.target1, value);
-			cycles += 4;
+	Block* block = nullptr;
+	if(MMU::isCodeCacheable(address))
+	{
+		int bank = (address >= 0x4000 && address <= 0x7FFF)
+				   ? mem.getROM2Index() : 0;
+		block = &findBlock(address, bank, mem);
+	}
 
+	// Code anywhere else, or an instruction cut off by the end of its bank or
+	// page, is interpreted
+	if(block == nullptr || block->op_amount == 0)
+	{
+		uint8_t opcode = mem.readByte(address);
+		result.cycles = execute(opcode, mem);
+		result.instructions = 1;
+		result.last_pc = address;
+		result.last_opcode = opcode;
+		return result;
+	}
+
+	mem.takeBlockBreak();
+
+#ifdef ASCIIBOY_JIT_SUPPORTED
+	if(engine == ENGINE_JIT && block->start <= 0x7FFF)
+	{
+		if(block->native == nullptr && ++block->run_count == JIT_THRESHOLD)
+		{
+			compileBlock(*block, mem);
 		}
 
-		done = true;
+		// Recompiled code only stops early after calling a handler, so it
+		// needs room for the whole block, and no EI or RETI taking effect
+		bool can_run_native = block->native != nullptr
+							  && (uint64_t)block->max_cycles <= max_cycles
+							  && interrupts_enabled == next_interrupt_state;
+#ifdef ASCIIBOY_TRACE
+		can_run_native = can_run_native && !tracer.isEnabled();
+#endif
 
-	} // END LD r1,r2
+		if(can_run_native)
+		{
+			return runNative(*block, mem);
+		}
+	}
+#endif
 
-	// ADD A,r - Add register 'r' into A
-	if(!done && opcode >= 0b10000000 && opcode <= 0b10000111)
+	bool ime = interrupts_enabled;
+
+	for(int i = 0; i < block->op_amount; i++)
 	{
-		ins.mnemonic = "ADD";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		const DecodedOp& op = block->ops[i];
 
-		uint8_t value = 0;
-		uint8_t sum = regs.a;
+		result.last_pc = address;
+		result.last_opcode = op.is_cb ? 0xCB : op.opcode;
+		result.cycles += executeOp(op, mem);
+		result.instructions++;
+		address += op.length;
 
-		if(ins.target2 != HL)
+		// A handler that moved PC anywhere else left the block
+		if((uint64_t)result.cycles >= max_cycles || regs.pc != address
+		   || interrupts_enabled != ime || mem.takeBlockBreak())
 		{
-			value = getByteReg(ins.target2);
+			break;
+		}
+	}
+
+	return result;
+}
 
-		} else if(ins.target2 == HL) { // HL is an address
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
+// Drops every cached block
+void CPU::clearBlockCache()
+{
+	for(Block& block : block_cache)
+	{
+		block.bank = -1;
+		block.native = nullptr;
+	}
+
+	if(code_buffer)
+	{
+		code_buffer->reset();
+	}
+}
+
 
+// Picks how blocks get run
+bool CPU::setEngine(Engine engine)
+{
+	if(engine == ENGINE_JIT)
+	{
+#ifdef ASCIIBOY_JIT_SUPPORTED
+		if(!code_buffer)
+		{
+			code_buffer = std::make_unique<CodeBuffer>(JIT_BUFFER_SIZE);
 		}
 
-		sum += value;
-		regs.a = sum;
+		if(!code_buffer->isValid())
+		{
+			code_buffer.reset();
+			return false;
+		}
+#else
+		return false;
+#endif
+	}
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = checkHCAdd(regs.a, value);
-		flags.carry = checkOFAdd(regs.a, value);
+	this->engine = engine;
+	return true;
+}
 
-		done = true;
+// Gets how blocks get run
+CPU::Engine CPU::getEngine() const
+{
+	return engine;
+}
+
+
+// Finds the block at an address, decoding it on a miss
+CPU::Block& CPU::findBlock(uint16_t address, int bank, MMU& mem)
+{
+	if(block_cache.empty())
+	{
+		block_cache.resize(BLOCK_CACHE_SIZE);
+		clearBlockCache();
+	}
 
-	} // END ADD A,r
+	Block& block = block_cache[(address ^ (bank << 7))
+							   & (BLOCK_CACHE_SIZE - 1)];
 
-	// ADC A,r - Add register 'r' + carry flag into A
-	if(!done && opcode >= 0b10001000 && opcode <= 0b10001111)
+	if(block.start != address || block.bank != bank
+	   || block.generation != mem.getCodeGeneration(address))
 	{
-		ins.mnemonic = "ADC";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		decodeBlock(block, address, bank, mem);
+	}
+
+	return block;
+}
 
-		uint8_t value = 0;
-		uint8_t sum = regs.a;
 
-		if(ins.target2 != HL)
+// Decodes the block at an address into a cache slot
+void CPU::decodeBlock(Block& block, uint16_t address, int bank, MMU& mem)
+{
+	block.start = address;
+	block.bank = bank;
+	block.generation = mem.getCodeGeneration(address);
+	block.op_amount = 0;
+	block.run_count = 0;
+	block.native = nullptr;
+	block.max_cycles = 0;
+
+	// Blocks stay within their ROM bank, or their page of RAM, since that is
+	// what is checked for changes. $FFFF is IE, not code.
+	uint32_t end = 0;
+	if(address <= 0x3FFF) { end = 0x4000; }
+	else if(address <= 0x7FFF) { end = 0x8000; }
+	else { end = std::min((address & 0xFF00) + 0x100, 0xFFFF); }
+
+	while(block.op_amount < MAX_BLOCK_OPS)
+	{
+		uint8_t opcode = mem.peekByte(address);
+		uint8_t length = gbstructs::OPCODE_INFO[opcode].length;
+		if(address + length > end)
 		{
-			value = getByteReg(ins.target2) + flags.carry;
+			break;
+		}
 
-		} else if(ins.target2 == HL) { // HL is an address
+		DecodedOp& op = block.ops[block.op_amount];
+		op.opcode = opcode == 0xCB ? mem.peekByte(address + 1) : opcode;
+		op.length = length;
+		op.is_cb = opcode == 0xCB;
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl) + flags.carry;
-			cycles += 4;
+		block.op_amount++;
+		address += length;
 
+		if(endsBlock(opcode) || OPCODE_TABLE[opcode] == &CPU::opUnhandled)
+		{
+			break;
 		}
+	}
+
+	if(block.op_amount > 0 && block.start >= 0x8000)
+	{
+		mem.protectCode(block.start, address - 1);
+	}
+}
+
 
-		sum += value;
-		regs.a = sum;
+// Recompiler //
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = checkHCAdd(regs.a, value);
-		flags.carry = checkOFAdd(regs.a, value);
+#ifdef ASCIIBOY_JIT_SUPPORTED
 
-		done = true;
-	} // END ADC A,r
+using namespace x86;
 
-	// SUB A,r - Subtract register 'r' from A
-	if(!done && opcode >= 0b10010000 && opcode <= 0b10010111)
+// Where each 8-bit register lives in the RegisterSet
+static int32_t byteRegOffset(TargetID target)
+{
+	switch(target)
 	{
-		ins.mnemonic = "SUB";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		case A: return offsetof(RegisterSet, a);
+		case B: return offsetof(RegisterSet, b);
+		case C: return offsetof(RegisterSet, c);
+		case D: return offsetof(RegisterSet, d);
+		case E: return offsetof(RegisterSet, e);
+		case H: return offsetof(RegisterSet, h);
+		case L: return offsetof(RegisterSet, l);
+		default: break;
+	}
 
-		uint8_t value = 0;
-		uint8_t dif = regs.a;
+	throw std::invalid_argument("Not an 8-bit register.");
+}
+
+// Where BC, DE, HL, or SP lives in the RegisterSet, from bits 4-5 of an opcode
+static int32_t shortRegOffset(uint8_t opcode)
+{
+	switch((opcode >> 4) & 0b11)
+	{
+		case 0: return offsetof(RegisterSet, bc);
+		case 1: return offsetof(RegisterSet, de);
+		case 2: return offsetof(RegisterSet, hl);
+		default: return offsetof(RegisterSet, sp);
+	}
+}
+
+
+// Gets the most cycles an op can take, with any branch taken
+static int getMaxOpCycles(uint8_t opcode, bool is_cb)
+{
+	if(!is_cb)
+	{
+		return gbstructs::OPCODE_INFO[opcode].cycles;
+	}
+
+	// CB ops on a register take 8. On (HL), BIT takes 12 and the rest 16.
+	if((opcode & 0b111) != 6)
+	{
+		return 8;
+	}
+	return (opcode >> 6) == 1 ? 12 : 16;
+}
 
-		if(ins.target2 != HL)
-		{
-			value = getByteReg(ins.target2);
 
-		} else if(ins.target2 == HL) { // HL is an address
+// Recompiles a ROM block into code_buffer
+void CPU::compileBlock(Block& block, MMU& mem)
+{
+	// The most code one block can take, with room to spare
+	static constexpr size_t MAX_BLOCK_CODE = 128 + MAX_BLOCK_OPS * 96;
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
+	CodeBuffer& code = *code_buffer;
 
+	code.beginWrite();
+
+	// Out of room. Start over, dropping all recompiled code.
+	if(code.getFree() < MAX_BLOCK_CODE)
+	{
+		for(Block& other : block_cache)
+		{
+			other.native = nullptr;
+			other.run_count = 0;
 		}
+		code.reset();
+	}
 
-		dif -= value;
-		regs.a = dif;
+	const uint8_t* entry = code.getCursor();
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = checkHCSub(regs.a, value);
-		flags.carry = checkUFSub(regs.a, value);
+	// Everything the block needs stays pinned in callee-saved registers, so
+	// it survives the handler calls. RBX points at the registers, R12 at the
+	// CPU, R13 at the MMU, and R15 at the instruction count. R14D adds up the
+	// cycles. Five pushes leave the stack aligned for calls.
+	code.push(RBX);
+	code.push(R12);
+	code.push(R13);
+	code.push(R14);
+	code.push(R15);
+	if(SHADOW_SPACE > 0) { code.subRSP(SHADOW_SPACE); }
 
-		done = true;
+	code.movRegReg(R12, ARG_REGS[0]);
+	code.movRegReg(R13, ARG_REGS[1]);
+	code.movRegReg(RBX, ARG_REGS[2]);
+	code.movRegReg(R15, ARG_REGS[3]);
+	code.movRegImm32(R14, 0);
 
-	} // END SUB A,r
+	std::vector<size_t> exits;
+	uint16_t address = block.start;
+	uint32_t native_cycles = 0; // Not yet added to R14D
+	int max_cycles = 0;
+	bool last_was_native = false;
 
-	// SBC A,r - Subtract (register 'r' + carry flag) from A
-	if(!done && opcode >= 0b10011000 && opcode <= 0b10011111)
+	for(int i = 0; i < block.op_amount; i++)
 	{
-		ins.mnemonic = "SBC";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		const DecodedOp& op = block.ops[i];
 
-		uint8_t value = 0;
-		uint8_t dif = regs.a;
+		int cycles = emitNativeOp(op, address, mem);
+		last_was_native = cycles >= 0;
 
-		if(ins.target2 != HL)
+		if(last_was_native)
 		{
-			value = getByteReg(ins.target2) + flags.carry;
+			native_cycles += cycles;
+			max_cycles += cycles;
+			address += op.length;
+			continue;
+		}
 
-		} else if(ins.target2 == HL) { // HL is an address
+		// An early stop has to count the native ops before it
+		if(native_cycles > 0)
+		{
+			code.addRegImm32(R14, native_cycles);
+			native_cycles = 0;
+		}
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl) + flags.carry;
-			cycles += 4;
+		// runOpFromNative(cpu, mem, &op, address)
+		code.movRegReg(ARG_REGS[0], R12);
+		code.movRegReg(ARG_REGS[1], R13);
+		code.movRegImm64(ARG_REGS[2], reinterpret_cast<uint64_t>(&op));
+		code.movRegImm32(ARG_REGS[3], address);
+		code.movRegImm64(RAX, reinterpret_cast<uint64_t>(&runOpFromNative));
+		code.callReg(RAX);
+		max_cycles += getMaxOpCycles(op.opcode, op.is_cb);
+
+		// Stopping early leaves PC wherever the handler put it
+		code.testRegReg32(RAX, RAX);
+		size_t keep_going = code.jcc32(COND_NS);
+		code.andRegImm32(RAX, ~JIT_STOP);
+		code.addRegReg32(R14, RAX);
+		code.movMem32Imm(R15, 0, i + 1);
+		exits.push_back(code.jmp32());
+		code.patchJump(keep_going);
+
+		code.addRegReg32(R14, RAX);
+		address += op.length;
+	}
 
-		}
+	// Ran the whole block. Native ops don't move PC as they go.
+	if(native_cycles > 0)
+	{
+		code.addRegImm32(R14, native_cycles);
+	}
+	if(last_was_native)
+	{
+		code.movMem16Imm(RBX, offsetof(RegisterSet, pc), address);
+	}
+	code.movMem32Imm(R15, 0, block.op_amount);
 
-		dif -= value;
-		regs.a = dif;
+	for(size_t exit : exits)
+	{
+		code.patchJump(exit);
+	}
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = checkHCSub(regs.a, value);
-		flags.carry = checkUFSub(regs.a, value);
+	code.movRegReg(RAX, R14);
+	if(SHADOW_SPACE > 0) { code.addRSP(SHADOW_SPACE); }
+	code.pop(R15);
+	code.pop(R14);
+	code.pop(R13);
+	code.pop(R12);
+	code.pop(RBX);
+	code.ret();
 
-		done = true;
+	code.endWrite();
 
-	} // END SBC A,r
+	block.native = reinterpret_cast<NativeBlock>(entry);
+	block.max_cycles = max_cycles;
+}
 
-	// AND A,r - Mask A with value of register 'r' using AND
-	if(!done && opcode >= 0b10100000 && opcode <= 0b10100111)
+
+// Emits an op that doesn't touch flags or memory as native code
+int CPU::emitNativeOp(const DecodedOp& op, uint16_t address, MMU& mem)
+{
+	CodeBuffer& code = *code_buffer;
+
+	if(op.is_cb)
 	{
-		ins.mnemonic = "AND";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		return -1;
+	}
 
-		uint8_t value = 0;
-		uint8_t val = regs.a;
+	uint8_t opcode = op.opcode;
 
-		if(ins.target2 != HL)
+	// NOP
+	if(opcode == 0x00)
+	{
+		return 4;
+	}
+
+	// LD r1,r2, unless either is (HL). 0x76 is HALT.
+	if(opcode >= 0x40 && opcode <= 0x7F)
+	{
+		TargetID target1 = toTarget((opcode & 0b00111000) >> 3);
+		TargetID target2 = toTarget(opcode & 0b00000111);
+		if(target1 == HL || target2 == HL)
 		{
-			value = getByteReg(ins.target2);
+			return -1;
+		}
 
-		} else if(ins.target2 == HL) { // HL is an address
+		code.movALMem8(RBX, byteRegOffset(target2));
+		code.movMem8AL(RBX, byteRegOffset(target1));
+		return 4;
+	}
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
+	// The operands of ROM code can't change under the block, so they are
+	// baked in
+	switch(opcode)
+	{
+		// LD r,n, unless r is (HL)
+		case 0x06: case 0x0E: case 0x16: case 0x1E:
+		case 0x26: case 0x2E: case 0x3E:
+			code.movMem8Imm(RBX, byteRegOffset(toTarget(opcode >> 3)),
+							mem.peekByte(address + 1));
+			return 8;
+
+		// LD rr,nn
+		case 0x01: case 0x11: case 0x21: case 0x31:
+			code.movMem16Imm(RBX, shortRegOffset(opcode),
+							 emath::bytesToUShort(mem.peekByte(address + 2),
+												  mem.peekByte(address + 1)));
+			return 12;
+
+		// INC rr
+		case 0x03: case 0x13: case 0x23: case 0x33:
+			code.incMem16(RBX, shortRegOffset(opcode));
+			return 4;
+
+		// DEC rr
+		case 0x0B: case 0x1B: case 0x2B: case 0x3B:
+			code.decMem16(RBX, shortRegOffset(opcode));
+			return 4;
 
-		}
+		default:
+			break;
+	}
+
+	return -1;
+}
 
-		val &= value;
-		regs.a = val;
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = true;
-		flags.carry = false;
+// Runs a block's recompiled code
+CPU::BlockResult CPU::runNative(const Block& block, MMU& mem)
+{
+	BlockResult result{};
+
+	int instructions = 0;
+	result.cycles = block.native(this, &mem, &regs, &instructions);
+	result.instructions = instructions;
+
+	// Find the last op that ran
+	uint16_t address = block.start;
+	for(int i = 0; i < instructions - 1; i++)
+	{
+		address += block.ops[i].length;
+	}
 
-		done = true;
+	const DecodedOp& last = block.ops[instructions - 1];
+	result.last_pc = address;
+	result.last_opcode = last.is_cb ? 0xCB : last.opcode;
+
+	return result;
+}
 
-	} // END AND A,r
 
-	// OR A,r - Mask A with value of register 'r' using OR
-	if(!done && opcode >= 0b10110000 && opcode <= 0b10110111)
+// Runs one op through its handler for recompiled code
+uint32_t CPU::runOpFromNative(CPU* cpu, MMU* mem, const DecodedOp* op,
+							  uint32_t address)
+{
+	cpu->regs.pc = address;
+	uint32_t cycles = cpu->executeOp(*op, *mem);
+
+	// Same as the interpreter's checks. EI, DI, and RETI always end the block.
+	if(cpu->regs.pc != (uint16_t)(address + op->length)
+	   || mem->takeBlockBreak())
 	{
-		ins.mnemonic = "OR";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		cycles |= JIT_STOP;
+	}
 
-		uint8_t value = 0;
-		uint8_t val = regs.a;
+	return cycles;
+}
 
-		if(ins.target2 != HL)
-		{
-			value = getByteReg(ins.target2);
+#endif
 
-		} else if(ins.target2 == HL) { // HL is an address
+// End Recompiler //
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
 
-		}
 
-		val |= value;
-		regs.a = val;
+// Wakes from HALT and jumps to a pending interrupt
+int CPU::handleInterrupts(MMU& mem)
+{
+	static constexpr uint16_t IF_ADDRESS = 0xFF0F;
+
+	uint8_t requested = mem.getIOReg(IF_ADDRESS);
+	uint8_t pending = requested & mem.getIEReg() & 0x1F;
+	if(pending == 0)
+	{
+		return 0;
+	}
+
+	// HALT ends on any pending interrupt, even with interrupts disabled
+	halted = false;
+
+	if(!interrupts_enabled)
+	{
+		return 0;
+	}
+
+	int cycles = 0;
+
+	// Lowest bit has the highest priority. VBlank, STAT, Timer, Serial, Joypad.
+	int bit = 0;
+	while(!(pending & (1 << bit))) { bit++; }
+
+	mem.setIOReg(IF_ADDRESS, requested & ~(1 << bit));
+	interrupts_enabled = false;
+	next_interrupt_state = false;
+	cycles += 8;
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = true;
-		flags.carry = false;
+	// Push PC the same way RST does
+	uint8_t lsb = 0, msb = 0;
+	emath::ushortToBytes(regs.pc, &msb, &lsb);
 
-		done = true;
+	regs.sp--;
+	mem.writeByte(regs.sp, msb);
+	cycles += 4;
 
-	} // END OR A,r
+	regs.sp--;
+	mem.writeByte(regs.sp, lsb);
+	cycles += 4;
 
-	// XOR A,r - Mask A with value of register 'r' using XOR
-	if(!done && opcode >= 0b10101000 && opcode <= 0b10101111)
+	// Vectors start at $0040, 8 bytes apart
+	regs.pc = 0x0040 + bit * 8;
+	cycles += 4;
+
+	return cycles;
+}
+
+// Gets if the CPU is halted
+bool CPU::isHalted() const
+{
+	return halted;
+}
+
+
+
+// Writes the registers and interrupt state into a save state
+void CPU::saveState(savestate::StateWriter& state) const
+{
+	// The lazy flags are saved as they are, pending op and all
+	state.write(regs);
+	flags.saveState(state);
+	state.write(halted);
+	state.write(interrupts_enabled);
+	state.write(next_interrupt_state);
+}
+
+// Reads back what saveState() wrote
+void CPU::loadState(savestate::StateReader& state)
+{
+	state.read(regs);
+	flags.loadState(state);
+	state.read(halted);
+	state.read(interrupts_enabled);
+	state.read(next_interrupt_state);
+}
+
+// Moves past what saveState() wrote without loading it
+void CPU::checkState(savestate::StateReader& state) const
+{
+	// bools are read, not skipped, so bad ones are caught here
+	bool loaded = false;
+
+	state.skip<decltype(regs)>();
+	flags.checkState(state);
+	state.read(loaded); // halted
+	state.read(loaded); // interrupts_enabled
+	state.read(loaded); // next_interrupt_state
+}
+
+
+
+// Gets the instruction tracer
+Tracer& CPU::getTracer()
+{
+	return tracer;
+}
+
+
+
+// Opcodes with no implementation yet
+int CPU::opUnhandled(uint8_t opcode, MMU& mem)
+{
+	// TODO: The rest of the instructions
+
+	ASCIIBOY_LOG(DEBUG, "CPU: Unhandled instruction 0x{:02X}!", opcode);
+
+	return 0;
+}
+
+
+// 0xCB prefix, dispatches into CB_OPCODE_TABLE
+int CPU::opPrefixCB(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	// New opcode is immediate value
+	opcode = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+
+	cycles += (this->*CB_OPCODE_TABLE[opcode])(opcode, mem);
+
+	return cycles;
+}
+
+
+
+// Load Instructions //
+
+// NOP
+int CPU::opNOP(uint8_t opcode, MMU& mem)
+{
+	return 0;
+} // END NOP
+
+
+// LD r1,r2 - Load Register 2 into Register 1
+int CPU::opLD_r_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	TargetID target1 = toTarget((opcode & 0b00111000) >> 3);
+	TargetID target2 = toTarget(opcode & 0b00000111);
+
+	if (target1 != HL && target2 != HL)
 	{
-		ins.mnemonic = "XOR";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		// Move the value of target2 into target1
+		uint8_t value = getByteReg(target2);
+		setByteReg(target1, value);
 
-		uint8_t value = 0;
-		uint8_t val = regs.a;
+	} else if (target1 == HL) { // HL is an address
 
-		if(ins.target2 != HL)
-		{
-			value = getByteReg(ins.target2);
+		// Write to address $HL, value in t2
+		uint8_t value = getByteReg(target2);
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		} else if(ins.target2 == HL) { // HL is an address
+	} else if(target2 == HL) { // HL is an address
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
+		// Read to t1, value at address $HL
+		uint8_t value = mem.readByte(regs.hl);
+		setByteReg(target1, value);
+		cycles += 4;
 
-		}
+	}
 
-		val ^= value;
-		regs.a = val;
+	return cycles;
+} // END LD r1,r2
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = true;
-		flags.carry = false;
 
-		done = true;
+// LDH A,(n) - Put value at address $FF00 + immediate 'n' into A
+int CPU::opLDH_A_na(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	} // END XOR A,r
+	uint16_t address = 0xFF00;
+	address += mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-	// CP A,r - Compares A with value in register 'r'. (SUB without changing A)
-	if(!done && opcode >= 0b10111000 && opcode <= 0b10111111)
+	regs.a = mem.readByte(address);
+	cycles += 4;
+
+	return cycles;
+} // END LDH A,(n)
+
+
+// LD (HL),n - Put immediate value 'n' into value at address HL
+int CPU::opLD_HLa_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	uint8_t value = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+
+	mem.writeByte(regs.hl, value);
+	cycles += 4;
+
+	return cycles;
+} // END LD (HL),n
+
+
+// LD (rr),A - Put A into byte at address in register 'rr'
+int CPU::opLD_rra_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	TargetID target1 = NOTARGET;
+
+	switch (opcode)
 	{
-		ins.mnemonic = "SUB";
-		ins.target1 = A;
-		ins.target2 = toTarget(opcode & 0b00000111);
+		case 0x02: target1 = BC; break;
+		case 0x12: target1 = DE; break;
+		default: break;
+	}
 
-		uint8_t value = 0;
-		uint8_t dif = regs.a;
+	uint16_t address = getShortReg(target1);
+	mem.writeByte(address, regs.a);
+	cycles += 4;
 
-		if(ins.target2 != HL)
-		{
-			value = getByteReg(ins.target2);
+	return cycles;
+} // END LD (rr),A
 
-		} else if(ins.target2 == HL) { // HL is an address
 
-			ins.t2_as_address = true;
-			value = mem.readByte(regs.hl);
-			cycles += 4;
+// LD (nn), A - Put A into byte at address in immediate 16-bit value
+int CPU::opLD_nna_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		}
+	uint8_t lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+
+	uint8_t msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+
+	uint16_t address = emath::bytesToUShort(msb, lsb);
+	mem.writeByte(address, regs.a);
+	cycles += 4;
+
+	return cycles;
+} // END LD (nn),A
 
-		dif -= value;
 
-		flags.zero = (dif == 0);
-		flags.subtract = true;
-		flags.half_carry = checkHCSub(dif, value);
-		flags.carry = checkUFSub(dif, value);
+// LD r,n - Put immediate value 'n' into register 'r'
+int CPU::opLD_r_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		done = true;
+	// Middle 3 bits denote register
 
-	} // END CP A,r
+	TargetID target1 = toTarget((opcode & 0b00111000) >> 3);
+
+	uint8_t val = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-	// End Algorithmic Checks //
+	setByteReg(target1, val);
+
+	return cycles;
+} // END LD r,n
+
+
+// LDH (C),A - Put value in A in value at address $FF00 + C
+int CPU::opLDH_Ca_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	uint16_t address = 0xFF00 + regs.c;
+	mem.writeByte(address, regs.a);
+	cycles += 4;
+
+	return cycles;
+} // END LDH (C),A
 
 
+// LDH A,(C) - Put value at address $FF00 + C into A
+int CPU::opLDH_A_Ca(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	uint16_t address = 0xFF00 + regs.c;
+
+	uint8_t val = mem.readByte(address);
+	cycles += 4;
+	regs.a = val;
+
+	return cycles;
+} // END LDH A,(C)
+
+
+// LDH (n),A - Put value in A into value at address $FF00 + immediate byte
+int CPU::opLDH_na_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
+
+	uint16_t address = 0xFF00;
+	address += mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+
+	mem.writeByte(address, regs.a);
+	cycles += 4;
+
+	return cycles;
+} // END LDH (n),A
+
+
+// LD rr,nn - Load 16-bit immediate value into 16-bit register
+int CPU::opLD_rr_nn(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// Two-Byte instructions //
+	TargetID target1 = NOTARGET;
 
-	if(!done && opcode == 0xCB)
+	// Get target1
+	switch (opcode)
 	{
-		ins.two_byte = true;
-
-		// New opcode is immediate value
-		opcode = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+		case 0x01: target1 = BC; break;
+		case 0x11: target1 = DE; break;
+		case 0x21: target1 = HL; break;
+		case 0x31: target1 = SP; break;
+		default: break;
+	}
 
-		// Change opcode for logging
-		ins.opcode = 0xCB00 + opcode;
-		Logger::instance().log(
-				fmt::format("CPU: Executing 2-Byte Instruction 0x{:04X}", ins.opcode),
-				Logger::EXTREME
-				);
+	uint8_t lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		// ROTATE AND SHIFT //
+	uint8_t msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		// SWAP r - Swap the upper and lower nibbles of a byte
-		if(opcode >= 0b00110000 && opcode <= 0b00110111)
-		{
-			ins.mnemonic = "SWAP";
-			ins.target1 = toTarget(opcode & 0b00000111);
+	uint16_t val = emath::bytesToUShort(msb, lsb);
 
-			uint8_t value;
+	setShortReg(target1, val);
 
-			if(ins.target1 != HL)
-			{
-				value = getByteReg(ins.target1);
+	return cycles;
+} // END LD rr,nn
 
-				uint8_t unibble = value & 0b11110000;
-				uint8_t lnibble = value & 0b00001111;
 
-				value = (unibble >> 8) | (lnibble << 8);
+// LD SP,HL - Put HL into SP
+int CPU::opLD_SP_HL(uint8_t opcode, MMU& mem)
+{
+	regs.sp = regs.hl;
 
-				setByteReg(ins.target1, value);
+	return 0;
+} // END LD SP,HL
 
-			} else { // HL is an address
 
-				ins.t1_as_address = true;
-				value = mem.readByte(regs.hl);
-				cycles += 4;
+// LD HL,SP+n - "Put SP + n effective address into HL" (SP + N) -> HL
+int CPU::opLD_HL_SPn(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				uint8_t unibble = value & 0b11110000;
-				uint8_t lnibble = value & 0b00001111;
+	uint16_t val1 = regs.sp;
+	uint16_t val2 = mem.readByte(regs.pc);
+	uint16_t sum = val1 + val2;
+	regs.pc++;
+	cycles += 4;
 
-				value = (unibble >> 8) | (lnibble << 8);
+	regs.hl = sum;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	// H and C come from the low byte. Z is always cleared.
+	flags.recordAdd(val1 & 0xFF, val2 & 0xFF, false);
+	flags.setMasked(FlagRegister::ZERO_MASK, 0);
 
-			}
+	return cycles;
+} // END LD HL,SP+n
 
-			// Zero is unchanged
-			flags.subtract = false;
-			flags.half_carry = false;
-			flags.carry = false;
 
-			done = true;
+// LD (nn),SP - Put SP into the value at address given by 16-bit immediate value
+int CPU::opLD_nna_SP(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		} // END SWAP
+	// Get address from immediate data
+	uint8_t address_lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+	uint8_t address_msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		// RLC r - Shift register 'r' left, MSB to Carry flag
-		if(!done && opcode >= 0b00000000 && opcode <= 0b00000111)
-		{
-			ins.mnemonic = "RLC";
+	uint16_t address = emath::bytesToUShort(address_msb, address_lsb);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
+	// Split SP into two bytes
+	uint8_t value_lsb = 0, value_msb = 0;
+	emath::ushortToBytes(regs.sp, &value_msb, &value_lsb);
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+	// Write split SP to memory
+	mem.writeByte(address, value_lsb);
+	address++;
+	cycles += 4;
+	mem.writeByte(address, value_msb);
+	cycles += 4;
 
-				bool old_msb = (value >> 7) & 1;
-				value = (value << 1) | old_msb;
-				flags.carry = old_msb;
-				setByteReg(ins.target1, value);
+	return cycles;
+} // END LD (nn),SP
 
-				flags.zero = (value == 0);
 
-			} else {
+// LDI (HL),A - Load into address at $HL, A. Increment HL
+int CPU::opLDI_HLa_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	mem.writeByte(regs.hl, regs.a);
+	cycles += 4;
 
-				bool old_msb = (value >> 7) & 1;
-				value = (value << 1) | old_msb;
-				flags.carry = old_msb;
+	regs.hl++;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	return cycles;
+} // END LDI (HL),A
 
-				flags.zero = (value == 0);
-			}
 
-			flags.subtract = false;
-			flags.half_carry = false;
+// LDI A,(HL) - Load into A, value at $HL. Increment HL
+int CPU::opLDI_A_HLa(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			done = true;
+	uint8_t val = mem.readByte(regs.hl);
+	cycles += 4;
+	regs.a = val;
 
-		} // END RLC r
+	regs.hl++;
 
-		// RL r - Shift register 'r' left, wrapped and set carry.
-		if(!done && opcode >= 0b00010000 && opcode <= 0b00010111)
-		{
-			ins.mnemonic = "RL";
+	return cycles;
+} // END LDI A,(HL)
 
-			ins.target1 = toTarget(opcode & 0b00000111);
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+// LDD (HL), A - Load into address at $HL, A. Decrement HL.
+int CPU::opLDD_HLa_A(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				bool old_msb = (value >> 7) & 1;
-				value = (value << 1) | flags.carry;
-				flags.carry = old_msb;
-				setByteReg(ins.target1, value);
+	mem.writeByte(regs.hl, regs.a);
+	cycles += 4;
 
-				flags.zero = (value == 0);
+	regs.hl--;
 
-			} else {
+	return cycles;
+} // END LDD (HL),A
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
 
-				bool old_msb = (value >> 7) & 1;
-				value = (value << 1) | flags.carry;
-				flags.carry = old_msb;
+// LDD A,(HL) - Load into A, value at $HL. Decrement HL.
+int CPU::opLDD_A_HLa(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	uint8_t val = mem.readByte(regs.hl);
+	cycles += 4;
+	regs.a = val;
 
-				flags.zero = (value == 0);
+	regs.hl--;
 
-			}
+	return cycles;
+} // END LDD A,(HL)
 
-			flags.subtract = false;
-			flags.half_carry = false;
 
-			done = true;
+// PUSH - Push 16-bit register onto stack, decrement SP twice
+int CPU::opPUSH(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		} // END RL r
+	TargetID target2 = NOTARGET;
 
-		// RRC r - Shift register 'r' right, LSB to Carry flag
-		if(!done && opcode >= 0b00001000 && opcode <= 0b00001111)
-		{
-			ins.mnemonic = "RRC";
+	// MSB
+	switch (opcode)
+	{
+		case 0xF5: target2 = A; break;
+		case 0xC5: target2 = B; break;
+		case 0xD5: target2 = D; break;
+		case 0xE5: target2 = H; break;
+		default: break;
+	}
 
-			ins.target1 = toTarget(opcode & 0b00000111);
+	regs.sp--;
+	uint8_t msb = getByteReg(target2);
+	mem.writeByte(regs.sp, msb);
+	cycles += 4;
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+	// LSB
+	switch (opcode)
+	{
+		case 0xF5: target2 = F; break;
+		case 0xC5: target2 = C; break;
+		case 0xD5: target2 = E; break;
+		case 0xE5: target2 = L; break;
+		default: break;
+	}
 
-				bool old_lsb = value & 1;
-				value = (value >> 1) | (old_lsb << 7);
-				flags.carry = old_lsb;
-				setByteReg(ins.target1, value);
+	regs.sp--;
+	uint8_t lsb = getByteReg(target2);
+	mem.writeByte(regs.sp, lsb);
+	cycles += 4;
 
-				flags.zero = (value == 0);
+	return cycles;
+} // END PUSH
 
-			} else {
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+// POP - Pop 16-bit value off of stack into 16-bit register, increment SP twice
+int CPU::opPOP(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				bool old_lsb = value & 1;
-				value = (value >> 1) | (old_lsb << 7);
-				flags.carry = old_lsb;
+	TargetID target1 = NOTARGET;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	// LSB
+	switch (opcode)
+	{
+		case 0xF1: target1 = F; break;
+		case 0xC1: target1 = C; break;
+		case 0xD1: target1 = E; break;
+		case 0xE1: target1 = L; break;
+		default: break;
+	}
 
-				flags.zero = (value == 0);
-			}
+	uint8_t val = mem.readByte(regs.sp);
+	regs.sp++;
+	cycles += 4;
 
-			flags.subtract = false;
-			flags.half_carry = false;
+	setByteReg(target1, val);
 
-			done = true;
+	// MSB
+	switch (opcode)
+	{
+		case 0xF1: target1 = A; break;
+		case 0xC1: target1 = B; break;
+		case 0xD1: target1 = D; break;
+		case 0xE1: target1 = H; break;
+		default: break;
+	}
 
-		} // END RRC
+	val = mem.readByte(regs.sp);
+	regs.sp++;
+	cycles += 4;
 
-		// RR r - Shift register 'r' right, wrapped and set carry.
-		if(!done && opcode >= 0b00011000 && opcode <= 0b00011111)
-		{
-			ins.mnemonic = "RR";
+	setByteReg(target1, val);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
+	return cycles;
+} // END POP
 
-			if(ins.target1 != HL)
-			{
-				byte value = getByteReg(ins.target1);
+// End Load Instructions //
 
-				bool old_lsb = value & 1;
-				value = (value >> 1) | (flags.carry << 7);
-				flags.carry = old_lsb;
-				setByteReg(ins.target1, value);
 
-				flags.zero = (value == 0);
 
-			} else {
+// Arithmetic Instructions //
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+// ADD A,r - Add register 'r' into A
+int CPU::opADD_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				bool old_lsb = value & 1;
-				value = (value >> 1) | (flags.carry << 7);
-				flags.carry = old_lsb;
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	uint8_t value = 0;
+	uint8_t sum = regs.a;
 
-				flags.zero = (value == 0);
-			}
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-			flags.subtract = false;
-			flags.half_carry = false;
+	} else if(target2 == HL) { // HL is an address
 
-			done = true;
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-		} // END RR
+	}
 
-		// SLA r - Shift r left into carry, set LSB to 0
-		if(!done && opcode >= 0b00100000 && opcode <= 0b01000111)
-		{
-			ins.mnemonic = "SLA";
+	flags.recordAdd(sum, value, false);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
+	sum += value;
+	regs.a = sum;
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+	return cycles;
+} // END ADD A,r
 
-				bool old_msb = (value >> 7) & 1;
-				value = value << 1;
-				flags.carry = old_msb;
-				setByteReg(ins.target1, value);
 
-				flags.zero = (value == 0);
+// ADC A,r - Add register 'r' + carry flag into A
+int CPU::opADC_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			} else {
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	uint8_t value = 0;
+	uint8_t sum = regs.a;
 
-				bool old_msb = (value >> 7) & 1;
-				value = value << 1;
-				flags.carry = old_msb;
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	} else if(target2 == HL) { // HL is an address
 
-				flags.zero = (value == 0);
-			}
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-			flags.subtract = false;
-			flags.half_carry = false;
+	}
 
-			done = true;
+	bool carry = flags.getCarry();
+	flags.recordAdd(sum, value, carry);
 
-		} // END SLA
+	sum += value + carry;
+	regs.a = sum;
 
-		// SRA r - Shift r right into Carry, leave MSB as-is
-		if(opcode >= 0b00101000 && opcode <= 0b00101111)
-		{
-			ins.mnemonic = "SRA";
+	return cycles;
+} // END ADC A,r
 
-			ins.target1 = toTarget(opcode & 0b00000111);
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+// SUB A,r - Subtract register 'r' from A
+int CPU::opSUB_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-				bool old_lsb = value & 1;
-				bool old_msb = (value >> 7) & 1;
-				value = (value >> 1) | (old_msb << 7);
-				flags.carry = old_lsb;
-				setByteReg(ins.target1, value);
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-				flags.zero = (value == 0);
+	uint8_t value = 0;
+	uint8_t dif = regs.a;
 
-			} else {
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	} else if(target2 == HL) { // HL is an address
 
-				bool old_lsb = value & 1;
-				bool old_msb = (value >> 7) & 1;
-				value = (value >> 1) | (old_msb << 7);
-				flags.carry = old_lsb;
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	}
 
-				flags.zero = (value == 0);
+	flags.recordSub(dif, value, false);
 
-			}
+	dif -= value;
+	regs.a = dif;
 
-			flags.subtract = false;
-			flags.half_carry = false;
+	return cycles;
+} // END SUB A,r
 
-			done = true;
 
-		} // END SRA
+// SBC A,r - Subtract (register 'r' + carry flag) from A
+int CPU::opSBC_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		// SRL r - Shift r left into Carry, MSB set to 0
-		if(!done && opcode >= 0b00111000 && opcode <= 0b00111111)
-		{
-			ins.mnemonic = "SRL";
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
+	uint8_t value = 0;
+	uint8_t dif = regs.a;
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-				bool old_lsb = value & 1;
-				value = value >> 1;
-				flags.carry = old_lsb;
-				setByteReg(ins.target1, value);
+	} else if(target2 == HL) { // HL is an address
 
-				flags.zero = (value == 0);
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-			} else {
+	}
 
-				ins.t1_as_address = true;
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	bool carry = flags.getCarry();
+	flags.recordSub(dif, value, carry);
 
-				bool old_lsb = value & 1;
-				value = value >> 1;
-				flags.carry = old_lsb;
+	dif -= value + carry;
+	regs.a = dif;
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
+	return cycles;
+} // END SBC A,r
 
-				flags.zero = (value == 0);
 
-			}
+// AND A,r - Mask A with value of register 'r' using AND
+int CPU::opAND_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			flags.subtract = false;
-			flags.half_carry = false;
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-			done = true;
+	uint8_t value = 0;
+	uint8_t val = regs.a;
 
-		} // END SRL
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-		// END ROTATE AND SHIFT //
+	} else if(target2 == HL) { // HL is an address
 
-		// SINGLE-BIT //
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-		// BIT b,r - Check bit 'b' in register 'r'
-		if(!done && opcode >= 0b01000000 && opcode <= 0b01111111)
-		{
-			ins.mnemonic = "BIT";
+	}
 
-			ins.target1 = toTarget(opcode & 0b00000111);
-			// Bit to check is direct value in middle 3 bits
-			uint8_t check_bit = ((opcode & 0b00111000) >> 3);
+	val &= value;
+	regs.a = val;
 
-			if(ins.target1 != HL)
-			{
-				// Shift value so check_bit is at position 0,
-				// then mask to only bit zero
-				flags.zero = (getByteReg(ins.target1) >> check_bit) & 1;
+	flags.recordResult(regs.a, FlagRegister::HALF_CARRY_MASK);
 
-			} else {
+	return cycles;
+} // END AND A,r
 
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
-				flags.zero = (value >> check_bit) & 1;
-			}
 
-			flags.subtract = false;
-			flags.half_carry = true;
+// OR A,r - Mask A with value of register 'r' using OR
+int CPU::opOR_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			done = true;
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-		} // END BIT
+	uint8_t value = 0;
+	uint8_t val = regs.a;
 
-		// RES b,r - Reset bit 'b' in register 'r'
-		if(!done && opcode >= 0b10000000 && opcode <= 0b10111111)
-		{
-			ins.mnemonic = "RES";
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
-			// Bit to check is direct value in middle 3 bits
-			uint8_t check_bit = (opcode & 0b00111000) >> 3;
+	} else if(target2 == HL) { // HL is an address
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-				// Create a mask of all ones except check_bit
-				value &= ~(1 << check_bit);
+	}
 
-				setByteReg(ins.target1, value);
+	val |= value;
+	regs.a = val;
 
-			} else {
+	flags.recordResult(regs.a, 0);
 
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	return cycles;
+} // END OR A,r
 
-				// Create a mask of all ones except check_bit
-				value &= ~(1 << check_bit);
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
-			}
+// XOR A,r - Mask A with value of register 'r' using XOR
+int CPU::opXOR_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			done = true;
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-		} // END RES
+	uint8_t value = 0;
+	uint8_t val = regs.a;
 
-		// SET b,r - Set bit 'b' in register 'r'
-		if(!done && opcode >= 0b11000000 && opcode <= 0b11111111)
-		{
-			ins.mnemonic = "SET";
+	if(target2 != HL)
+	{
+		value = getByteReg(target2);
 
-			ins.target1 = toTarget(opcode & 0b00000111);
-			// Bit to check is direct value in middle 3 bits
-			uint8_t check_bit = (opcode & 0b00111000) >> 3;
+	} else if(target2 == HL) { // HL is an address
 
-			if(ins.target1 != HL)
-			{
-				uint8_t value = getByteReg(ins.target1);
-				value |= (1 << check_bit);
-				setByteReg(ins.target1, value);
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-			} else {
+	}
 
-				uint8_t value = mem.readByte(regs.hl);
-				cycles += 4;
+	val ^= value;
+	regs.a = val;
 
-				value |= (1 << check_bit);
+	flags.recordResult(regs.a, 0);
 
-				mem.writeByte(regs.hl, value);
-				cycles += 4;
-			}
+	return cycles;
+} // END XOR A,r
 
-			done = true;
 
-		} // END SET
+// CP A,r - Compares A with value in register 'r'. (SUB without changing A)
+int CPU::opCP_A_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		// END SINGLE BIT //
-	}
+	TargetID target2 = toTarget(opcode & 0b00000111);
 
-	// End Two-Byte instructions //
+	uint8_t value = 0;
+	uint8_t dif = regs.a;
 
-	// THE BIG SWITCH
-	if (!done)
-	switch(opcode)
-	{
-	// NOP
-	case 0x00:
+	if(target2 != HL)
 	{
-		ins.mnemonic = "NOP";
-		done = true;
-		break;
-	} // END NOP
+		value = getByteReg(target2);
 
-	// Load Instructions //
+	} else if(target2 == HL) { // HL is an address
 
-	// LD A,n - Put immediate value 'n' into register A
-	case 0xF0:
-	{
-		ins.mnemonic = "LD";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
-
-		uint8_t value = mem.readByte(regs.pc);
-		regs.pc++;
+		value = mem.readByte(regs.hl);
 		cycles += 4;
 
-		regs.a = value;
+	}
 
-		done = true;
+	// A is left unchanged
+	flags.recordSub(dif, value, false);
 
-		break;
-	} // END LD A,n
+	return cycles;
+} // END CP A,r
 
-	// LD (HL),n - Put immediate value 'n' into value at address HL
-	case 0x36:
-	{
-		ins.mnemonic = "LD";
-		ins.target1 = HL;
-		ins.t1_as_address = true;
-		ins.target2 = IMMEDIATE;
 
-		uint8_t value = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+// ADD A,n
+int CPU::opADD_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
+	regs.pc++;
+	uint8_t val1 = mem.readByte(regs.pc);
+	cycles += 4;
 
-		mem.writeByte(regs.hl, value);
-		cycles += 4;
+	uint8_t val2 = regs.a;
 
-		done = true;
+	uint8_t sum = val1 + val2;
 
-		break;
-	} // END LD (HL),n
+	regs.a = sum;
 
-	// LD (rr),A - Put A into byte at address in register 'rr'
-	case 0x02: case 0x12:
-	{
-		ins.mnemonic = "LD";
-		ins.target2 = A;
-		ins.t1_as_address = true;
+	flags.recordAdd(val2, val1, false);
 
-		switch (opcode)
-		{
-			case 0x02: ins.target1 = BC; break;
-			case 0x12: ins.target1 = DE; break;
-			default: break;
-		}
+	return cycles;
+} // END ADD A,n
 
-		uint16_t address = getShortReg(ins.target1);
-		mem.writeByte(address, regs.a);
-		cycles += 4;
 
-		done = true;
+// CP A,n - Compares A with value in register 'r'. (SUB without changing A)
+int CPU::opCP_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END LD (rr),A
+	uint8_t val = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-	// LD (nn), A - Put A into byte at address in immediate 16-bit value
-	case 0xEA:
-	{
-		ins.mnemonic = "LD";
-		ins.target1 = IMMEDIATE;
-		ins.t1_as_address = true;
-		ins.target2 = A;
+	flags.recordSub(regs.a, val, false);
 
-		uint8_t lsb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	return cycles;
+} // END CP A,n
 
-		uint8_t msb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
 
-		uint16_t address = emath::bytesToUShort(msb, lsb);
-		mem.writeByte(address, regs.a);
-		cycles += 4;
+// ADC A,n - Add (immediate value 'n' + carry flag) to A
+int CPU::opADC_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		done = true;
+	bool carry = flags.getCarry();
 
-		break;
-	} // END LD (nn),A
+	uint8_t val1 = regs.a;
+	uint8_t val2 = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-	// LD r,n - Put immediate value 'n' into register 'r'
-	case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E:
-	{
-		ins.mnemonic = "LD";
-		ins.target2 = IMMEDIATE;
+	uint8_t sum = val1 + val2 + carry;
 
-		// Middle 3 bits denote register
-		ins.target1 = toTarget((opcode & 0b00111000) >> 3);
+	regs.a = sum;
 
-		uint8_t val = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	flags.recordAdd(val1, val2, carry);
 
-		setByteReg(ins.target1, val);
+	return cycles;
+} // END ADC A,n
 
-		done = true;
 
-		break;
-	} // END LD r,n
+// SBC A,n - Subtract (immediate value 'n' + carry flag) from A
+int CPU::opSBC_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// LDH (C),A - Put value in A in value at address $FF00 + C
-	case 0xE2:
-	{
-		ins.mnemonic = "LDH";
-		ins.target1 = C;
-		ins.t1_as_address = true;
-		ins.target2 = A;
+	bool carry = flags.getCarry();
 
-		uint16_t address = 0xFF00 + regs.c;
-		mem.writeByte(address, regs.a);
-		cycles += 4;
+	uint8_t val1 = regs.a;
+	uint8_t val2 = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		done = true;
+	uint8_t dif = val1 - val2 - carry;
 
-		break;
-	} // END LDH (C),A
+	regs.a = dif;
 
-	// LDH A,(C) - Put value at address $FF00 + C into A
-	case 0xF2:
-	{
-		ins.mnemonic = "LDH";
-		ins.target1 = A;
-		ins.target2 = C;
-		ins.t2_as_address = true;
+	flags.recordSub(val1, val2, carry);
 
-		uint16_t address = 0xFF00 + regs.c;
+	return cycles;
+} // END SBC A,n
 
-		uint8_t val = mem.readByte(address);
-		cycles += 4;
-		regs.a = val;
 
-		done = true;
+// AND A,n
+int CPU::opAND_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END LDH A,(C)
+	uint8_t val = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-	// LDH (n),A - Put value in A into value at address $FF00 + immediate byte
-	case 0xE0:
-	{
-		ins.mnemonic = "LDH";
-		ins.target1 = IMMEDIATE;
-		ins.t1_as_address = true;
-		ins.target2 = A;
+	regs.a &= val;
 
-		uint16_t address = 0xFF00;
-		address += mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	flags.recordResult(regs.a, FlagRegister::HALF_CARRY_MASK);
 
-		mem.writeByte(address, regs.a);
-		cycles += 4;
+	return cycles;
+} // END AND A,n
 
-		done = true;
 
-		break;
-	} // END LDH (n),A
+// OR A,n
+int CPU::opOR_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// LD rr,nn - Load 16-bit immediate value into 16-bit register
-	case 0x01: case 0x11: case 0x21: case 0x31:
-	{
-		ins.mnemonic = "LD";
-		ins.target2 = IMMEDIATE;
+	uint8_t val = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		// Get target1
-		switch (opcode)
-		{
-			case 0x01: ins.target1 = BC; break;
-			case 0x11: ins.target1 = DE; break;
-			case 0x21: ins.target1 = HL; break;
-			case 0x31: ins.target1 = SP; break;
-			default: break;
-		}
+	regs.a |= val;
 
-		byte lsb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	flags.recordResult(regs.a, 0);
 
-		byte msb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	return cycles;
+} // END OR A,n
 
-		uint16_t val = emath::bytesToUShort(msb, lsb);
 
-		setShortReg(ins.target1, val);
+// XOR A,n
+int CPU::opXOR_A_n(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		done = true;
+	uint8_t val = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		break;
-	} // END LD rr,nn
+	regs.a ^= val;
 
-	// LD SP,HL - Put HL into SP
-	case 0xF9:
-	{
-		ins.mnemonic = "LD";
-		ins.target1 = SP;
-		ins.target2 = HL;
+	flags.recordResult(regs.a, 0);
 
-		regs.sp = regs.hl;
+	return cycles;
+} // END XOR A,n
 
-		done = true;
 
-		break;
-	} // END LD SP,HL
+// ADD HL,rr - To HL, add HL + 16-bit register
+int CPU::opADD_HL_rr(uint8_t opcode, MMU& mem)
+{
+	TargetID target2 = NOTARGET;
 
-	// LD HL,SP+n - "Put SP + n effective address into HL" (SP + N) -> HL
-	case 0xF8:
+	switch(opcode)
 	{
-		ins.mnemonic = "LD";
-		ins.target1 = HL;
-		ins.target2 = SP;
+	case 0x09: target2 = BC; break;
+	case 0x19: target2 = DE; break;
+	case 0x29: target2 = HL; break;
+	case 0x39: target2 = SP; break;
+	default: break;
+	}
 
-		uint16_t val1 = regs.sp;
-		uint16_t val2 = mem.readByte(regs.pc);
-		uint16_t sum = val1 + val2;
-		regs.pc++;
-		cycles += 4;
+	uint16_t val1 = regs.hl;
+	uint16_t val2 = getShortReg(target2);
 
-		regs.hl = sum;
+	uint16_t sum = val1 + val2;
 
-		flags.zero = false;
-		flags.subtract = false;
-		flags.half_carry = emath::checkHCAdd(val1, val2);
-		flags.carry = emath::checkOFAdd(val1, val2);
+	regs.hl = sum;
 
-		done = true;
+	flags.recordAdd16(val1, val2);
 
-		break;
-	} // END LD HL,SP+n
+	return 0;
+} // END ADD HL,rr
 
-	// LD (nn),SP - Put SP into the value at address given by 16-bit immediate value
-	case 0x08:
-	{
-		ins.mnemonic = "LD";
-		ins.target1 = IMMEDIATE;
-		ins.t1_as_address = true;
-		ins.target2 = SP;
 
-		// Get address from immediate data
-		byte address_lsb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
-		byte address_msb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+// ADD SP,nn
+int CPU::opADD_SP_nn(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		uint16_t address = emath::bytesToUShort(address_msb, address_lsb);
+	// Get Immediate value
+	uint8_t lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+	uint8_t msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		// Split SP into two bytes
-		uint8_t value_lsb = 0, value_msb = 0;
-		emath::ushortToBytes(regs.sp, &value_msb, &value_lsb);
+	uint16_t val1 = regs.sp;
+	uint16_t val2 = emath::bytesToUShort(msb, lsb);
 
-		// Write split SP to memory
-		mem.writeByte(address, value_lsb);
-		address++;
-		cycles += 4;
-		mem.writeByte(address, value_msb);
-		cycles += 4;
+	uint16_t sum = val1 + val2;
 
-		done = true;
+	regs.sp = sum;
 
-		break;
-	} // END LD (nn),SP
+	// H and C come from the low byte. Z is always cleared.
+	flags.recordAdd(val1 & 0xFF, val2 & 0xFF, false);
+	flags.setMasked(FlagRegister::ZERO_MASK, 0);
 
-	// LDI (HL),A - Load into address at $HL, A. Increment HL
-	case 0x22:
-	{
-		ins.mnemonic = "LDI";
-		ins.target1 = HL;
-		ins.t1_as_address = true;
-		ins.target2 = A;
+	return cycles;
+} // END ADD SP,nn
 
-		mem.writeByte(regs.hl, regs.a);
-		cycles += 4;
 
-		regs.hl++;
+// INC r - Increment value in/at register 'r'
+int CPU::opINC_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		done = true;
+	// Middle 3 bits define Target 1
 
-		break;
-	} // END LDI (HL),A
+	TargetID target1 = toTarget((uint8_t) ((opcode & 0b00111000) >> 3));
 
-	// LDI A,(HL) - Load into A, value at $HL. Increment HL
-	case 0x2A:
-	{
-		ins.mnemonic = "LDI";
-		ins.target1 = A;
-		ins.target2 = HL;
-		ins.t2_as_address = true;
+	if (target1 != HL) {
+		uint8_t sum = getByteReg(target1);
+		flags.recordInc(sum);
+		sum++;
+		setByteReg(target1, sum);
 
-		uint8_t val = mem.readByte(regs.hl);
+	} else {
+		uint8_t sum = mem.readByte(regs.hl);
 		cycles += 4;
-		regs.a = val;
-
-		regs.hl++;
-
-		done = true;
-
-		break;
-	} // END LDI (HL),A
 
-	// LDD (HL), A - Load into A, value at $HL. Decrement HL.
-	case 0x32:
-	{
-		ins.mnemonic = "LDD";
-		ins.target1 = HL;
-		ins.t1_as_address = true;
-		ins.target2 = A;
+		flags.recordInc(sum);
+		sum++;
 
-		mem.writeByte(regs.hl, regs.a);
+		mem.writeByte(regs.hl, sum);
 		cycles += 4;
+	}
 
-		regs.hl--;
+	return cycles;
+} // END INC r
 
-		done = true;
 
-		break;
-	} // END LDI (HL),A
+// INC rr - Increment value in register 'rr'
+int CPU::opINC_rr(uint8_t opcode, MMU& mem)
+{
+	TargetID target1 = NOTARGET;
 
-	// LDI A,(HL) - Load into A, value at $HL. Decrement HL.
-	case 0x3A:
+	switch (opcode)
 	{
-		ins.mnemonic = "LDD";
-		ins.target1 = A;
-		ins.target2 = HL;
-		ins.t2_as_address = true;
+		case 0x03: target1 = BC; break;
+		case 0x13: target1 = DE; break;
+		case 0x23: target1 = HL; break;
+		case 0x33: target1 = SP; break;
+		default: break;
+	}
 
-		uint8_t val = mem.readByte(regs.hl);
-		cycles += 4;
-		regs.a = val;
+	uint16_t sum = getShortReg(target1);
+	sum++;
+	setShortReg(target1, sum);
 
-		regs.hl--;
+	// Flags are not set
 
-		done = true;
+	return 0;
+} // END INC rr
 
-		break;
-	} // END LDI (HL),A
 
-	// PUSH - Push 16-bit register onto stack, decrement SP twice
-	case 0xF5: case 0xC5: case 0xD5: case 0xE5:
-	{
-		ins.mnemonic = "PUSH";
-		ins.target1 = SP;
-		ins.t1_as_address = true;
+// DEC r - Decrement value in/at register 'r'
+int CPU::opDEC_r(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		// MSB
-		switch (opcode)
-		{
-			case 0xF5: ins.target2 = A; break;
-			case 0xC5: ins.target2 = B; break;
-			case 0xD5: ins.target2 = D; break;
-			case 0xE5: ins.target2 = H; break;
-			default: break;
-		}
+	// Middle 3 bits define Target 1
 
-		regs.sp--;
-		uint8_t msb = getByteReg(ins.target2);
-		mem.writeByte(regs.sp, msb);
-		cycles += 4;
+	TargetID target1 = toTarget((uint8_t) ((opcode & 0b00111000) >> 3));
 
-		// LSB
-		switch (opcode)
-		{
-			case 0xF5: ins.target2 = F; break;
-			case 0xC5: ins.target2 = C; break;
-			case 0xD5: ins.target2 = E; break;
-			case 0xE5: ins.target2 = L; break;
-			default: break;
-		}
+	if (target1 != HL) {
+		uint8_t dif = getByteReg(target1);
+		flags.recordDec(dif);
+		dif--;
+		setByteReg(target1, dif);
 
-		regs.sp--;
-		byte lsb = getByteReg(ins.target2);
-		mem.writeByte(regs.sp, lsb);
+	} else {
+		uint8_t dif = mem.readByte(regs.hl);
 		cycles += 4;
 
-		done = true;
-
-		break;
-	} // END PUSH
-
-	// POP - Pop 16-bit value off of stack into 16-bit register, increment SP twice
-	case 0xF1: case 0xC1: case 0xD1: case 0xE1:
-	{
-		ins.mnemonic = "POP";
-		ins.target2 = SP;
-		ins.t2_as_address = true;
-
-		// LSB
-		switch (opcode)
-		{
-			case 0xF1: ins.target1 = F; break;
-			case 0xC1: ins.target1 = C; break;
-			case 0xD1: ins.target1 = E; break;
-			case 0xE1: ins.target1 = L; break;
-			default: break;
-		}
+		flags.recordDec(dif);
+		dif--;
 
-		regs.sp++;
-		byte val = mem.readByte(regs.sp);
+		mem.writeByte(regs.hl, dif);
 		cycles += 4;
+	}
 
-		setByteReg(ins.target1, val);
+	return cycles;
+} // END DEC r
 
-		// MSB
-		switch (opcode)
-		{
-			case 0xF1: ins.target1 = A; break;
-			case 0xC1: ins.target1 = B; break;
-			case 0xD1: ins.target1 = D; break;
-			case 0xE1: ins.target1 = H; break;
-			default: break;
-		}
 
-		regs.sp++;
-		val = mem.readByte(regs.sp);
-		cycles += 4;
+// DEC rr
+int CPU::opDEC_rr(uint8_t opcode, MMU& mem)
+{
+	TargetID target1 = NOTARGET;
+
+	switch (opcode)
+	{
+		case 0x0B: target1 = BC; break;
+		case 0x1B: target1 = DE; break;
+		case 0x2B: target1 = HL; break;
+		case 0x3B: target1 = SP; break;
+		default: break;
+	}
 
-		setByteReg(ins.target1, val);
+	uint16_t dif = getShortReg(target1);
+	dif--;
+	setShortReg(target1, dif);
 
-		// Update flags in case AF was loaded
-		regs.f = flags.flagsToByte();
+	// Flags are not set
 
-		done = true;
+	return 0;
+} // END DEC rr
 
-		break;
 
-	} // END POP
+//DAA - Retroactively adjusts A to a valid BCD result. This means something, and does something.
+int CPU::opDAA(uint8_t opcode, MMU& mem)
+{
+	// DAA is one of the few readers of N and H, so settle them here
+	bool subtract = flags.getSubtract();
+	bool half_carry = flags.getHalfCarry();
+	bool carry = flags.getCarry();
+
+	// Taken from user AWJ @ https://forums.nesdev.org/viewtopic.php?t=15944
+	if (!subtract)
+	{  // after an addition, adjust if (half-)carry occurred or if result is out of bounds
+		if (carry || regs.a > 0x99) { regs.a += 0x60; carry = true; }
+		if (half_carry || (regs.a & 0x0f) > 0x09) { regs.a += 0x6; }
+	} else
+	{  // after a subtraction, only adjust if (half-)carry occurred
+		if (carry) { regs.a -= 0x60; }
+		if (half_carry) { regs.a -= 0x6; }
+	}
+	// z is the usual z flag, h flag is always cleared, n is unchanged
+	flags.recordResult(regs.a,
+					   (subtract << FlagRegister::SUBTRACT_POSITION)
+					   | (carry << FlagRegister::CARRY_POSITION));
 
-	// End Load Instructions //
+	return 0;
+} // END DAA
 
 
+// CPL - Flip all bits in A
+int CPU::opCPL(uint8_t opcode, MMU& mem)
+{
+	regs.a = ~regs.a;
 
-	// Arithmetic Instructions //
+	flags.setMasked(FlagRegister::SUBTRACT_MASK | FlagRegister::HALF_CARRY_MASK,
+					FlagRegister::SUBTRACT_MASK | FlagRegister::HALF_CARRY_MASK);
 
-	// ADD A,n
-	case 0xC6:
-	{
-		ins.mnemonic = "ADD";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
+	return 0;
+} // END CPL
 
-		regs.pc++;
-		uint8_t val1 = mem.readByte(regs.pc);
-		cycles += 4;
+// End Arithmetic Instructions //
 
-		uint8_t val2 = regs.a;
 
-		uint8_t sum = val1 + val2;
 
-		regs.a = sum;
+// Control Instructions //
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = emath::checkHCAdd(val1, val2);
-		flags.carry = emath::checkOFAdd(val1, val2);
+//CCF - Flip Carry flag
+int CPU::opCCF(uint8_t opcode, MMU& mem)
+{
+	// N and H are cleared. Zero is unchanged.
+	flags.setMasked(FlagRegister::SUBTRACT_MASK
+					| FlagRegister::HALF_CARRY_MASK
+					| FlagRegister::CARRY_MASK,
+					flags.getCarry() ? 0 : FlagRegister::CARRY_MASK);
 
-		done = true;
+	return 0;
+} // END CCF
 
-		break;
-	} // END ADD A,n
 
-	// CP A,n - Compares A with value in register 'r'. (SUB without changing A)
-	case 0xFE:
-	{
-		ins.mnemonic = "CP";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
+//SCF - Set Carry flag
+int CPU::opSCF(uint8_t opcode, MMU& mem)
+{
+	// N and H are cleared. Zero is unchanged.
+	flags.setMasked(FlagRegister::SUBTRACT_MASK
+					| FlagRegister::HALF_CARRY_MASK
+					| FlagRegister::CARRY_MASK,
+					FlagRegister::CARRY_MASK);
 
-		regs.pc++;
-		uint8_t val = mem.readByte(regs.pc);
-		cycles += 4;
+	return 0;
+} // END SCF
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = emath::checkHCSub(regs.a, val);
-		flags.carry = emath::checkUFSub(regs.a, val);
 
-		done = true;
+// HALT
+int CPU::opHALT(uint8_t opcode, MMU& mem)
+{
+	halted = true;
 
-		break;
-	} // END CP A,n
+	return 0;
+} // END HALT
 
-	// ADD A,n - Add (immediate value 'n' + carry flag) to A
-	case 0xCE:
-	{
-		ins.mnemonic = "ADC";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
 
-		uint8_t val1 = regs.a;
-		uint8_t val2 = mem.readByte(regs.pc) + flags.carry;
-		regs.pc++;
-		cycles += 4;
+// STOP
+int CPU::opSTOP(uint8_t opcode, MMU& mem)
+{
+	// TODO: Put Emulator in STOPPED state instead of crashing it.
+	throw std::runtime_error("STOP CALLED");
+} // END STOP
 
-		uint8_t sum = val1 + val2;
 
-		regs.a = sum;
+// DI - Disable Interrupts, starting immediately
+int CPU::opDI(uint8_t opcode, MMU& mem)
+{
+	interrupts_enabled = false;
+	next_interrupt_state = false;
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = emath::checkHCAdd(val1, val2);
-		flags.carry = emath::checkOFAdd(val1, val2);
+	return 0;
+} // END DI
 
-		done = true;
 
-		break;
-	} // END ADC A,n
+// EI - Enable Interrupts after next instruction is executed
+int CPU::opEI(uint8_t opcode, MMU& mem)
+{
+	next_interrupt_state = true;
 
-	// SBC A,n - Subtract (immediate value 'n' + carry flag) from A
-	case 0xDE:
-	{
-		ins.mnemonic = "SBC";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
+	return 0;
+} // END EI
 
-		uint8_t val1 = regs.a;
-		uint8_t val2 = mem.readByte(regs.pc) + flags.carry;
-		regs.pc++;
-		cycles += 4;
+// End Control Instructions //
 
-		uint8_t dif = val1 - val2;
 
-		regs.a = dif;
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = true;
-		flags.half_carry = emath::checkHCSub(val1, val2);
-		flags.carry = emath::checkUFSub(val1, val2);
+// Jump Instructions //
 
-		done = true;
+// JP nn,c - If condition met, jump to the immediate value 'nn'
+int CPU::opJP(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END SBC A,n
+	bool condition_met = true;
 
-	// AND A,n
-	case 0xE6:
+	switch (opcode)
 	{
-		ins.mnemonic = "AND";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
+		case 0xC2: condition_met = !flags.getZero(); break;
+		case 0xCA: condition_met = flags.getZero(); break;
+		case 0xD2: condition_met = !flags.getCarry(); break;
+		case 0xDA: condition_met = flags.getCarry(); break;
+		default: break;
+	}
 
-		uint8_t val = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	uint8_t lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+	uint8_t msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		regs.a &= val;
+	uint16_t  address = emath::bytesToUShort(msb, lsb);
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = true;
-		flags.carry = false;
+	if (condition_met) { regs.pc = address; }
 
-		done = true;
+	return cycles;
+} // END JP nn,c
 
-		break;
-	} // END ADD A,n
 
-	// OR A,n
-	case 0xF6:
-	{
-		ins.mnemonic = "OR";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
+// JR n,c - If condition met, jump to PC + 'n'
+int CPU::opJR(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		uint8_t val = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	bool condition_met = true;
 
-		regs.a |= val;
+	switch (opcode)
+	{
+		case 0x20: condition_met = !flags.getZero(); break;
+		case 0x28: condition_met = flags.getZero(); break;
+		case 0x30: condition_met = !flags.getCarry(); break;
+		case 0x38: condition_met = flags.getCarry(); break;
+		default: break;
+	}
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = true;
-		flags.carry = false;
+	// The offset is signed, and relative to the end of the instruction
+	int8_t offset = (int8_t)mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		done = true;
+	if (condition_met) { regs.pc += offset; }
 
-		break;
-	} // END OR A,n
+	return cycles;
+} // END JR n,c
 
-	// XOR A,n
-	case 0xEE:
-	{
-		ins.mnemonic = "XOR";
-		ins.target1 = A;
-		ins.target2 = IMMEDIATE;
 
-		uint8_t val = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+// CALL - Push current PC onto stack, jump to address in immediate 16 bits
+int CPU::opCALL(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		regs.a ^= val;
+	bool condition_met = true;
 
-		flags.zero = (regs.a == 0);
-		flags.subtract = false;
-		flags.half_carry = true;
-		flags.carry = false;
+	switch(opcode)
+	{
+		case 0xC4: condition_met = !flags.getZero(); break;
+		case 0xCC: condition_met = flags.getZero(); break;
+		case 0xD4: condition_met = !flags.getCarry(); break;
+		case 0xDC: condition_met = flags.getCarry(); break;
+		default: break;
+	}
 
-		done = true;
+	// Get address from nn
+	uint8_t lsb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
+	uint8_t msb = mem.readByte(regs.pc);
+	regs.pc++;
+	cycles += 4;
 
-		break;
-	} // END XOR A,n
+	uint16_t jump_address = emath::bytesToUShort(msb, lsb);
 
-	// ADD HL,rr - To HL, add HL + 16-bit register
-	case 0x09: case 0x19: case 0x29: case 0x39:
+	if(condition_met)
 	{
-		ins.mnemonic = "ADD";
+		// Break PC into bytes
+		uint8_t pclsb = 0, pcmsb = 0;
+		emath::ushortToBytes(regs.pc, &pcmsb, &pclsb);
 
-		switch(opcode)
-		{
-		case 0x09: ins.target2 = BC; break;
-		case 0x19: ins.target2 = DE; break;
-		case 0x29: ins.target2 = HL; break;
-		case 0x39: ins.target2 = SP; break;
-		default: break;
-		}
+		// Push MSB
+		regs.sp--;
+		mem.writeByte(regs.sp, pcmsb);
+		cycles += 4;
 
-		uint16_t val1 = regs.hl;
-		uint16_t val2 = getShortReg(ins.target2);
+		// Push LSB
+		regs.sp--;
+		mem.writeByte(regs.sp, pclsb);
+		cycles += 4;
 
-		uint16_t sum = val1 + val2;
+		// Jump to address
+		regs.pc = jump_address;
+	}
 
-		regs.hl = sum;
+	return cycles;
+} // END CALL
 
-		// Flags are not set
 
-		done = true;
+// RET - Pop from stack and jump to that address
+int CPU::opRET(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END ADD HL,rr
+	bool condition_met = true;
 
-	// ADD SP,nn
-	case 0xE8:
+	switch(opcode)
 	{
-		ins.mnemonic = "ADD";
-		ins.target1 = SP;
-		ins.target2 = IMMEDIATE;
+		case 0xC0: condition_met = !flags.getZero(); break;
+		case 0xC8: condition_met = flags.getZero(); break;
+		case 0xD0: condition_met = !flags.getCarry(); break;
+		case 0xD8: condition_met = flags.getCarry(); break;
+		default: break;
+	}
 
-		// Get Immediate value
-		byte lsb = mem.readByte(regs.pc);
-		regs.pc++;
+	if(condition_met)
+	{
+		// POP address
+		uint8_t lsb = mem.readByte(regs.sp);
+		regs.sp++;
 		cycles += 4;
-		byte msb = mem.readByte(regs.pc);
-		regs.pc++;
+
+		uint8_t msb = mem.readByte(regs.sp);
+		regs.sp++;
 		cycles += 4;
 
-		uint16_t val1 = regs.sp;
-		uint16_t val2 = emath::bytesToUShort(msb, lsb);
+		uint16_t value = emath::bytesToUShort(msb, lsb);
 
-		uint16_t sum = val1 + val2;
+		// Jump to address
+		regs.pc = value;
+	}
 
-		regs.sp = sum;
+	return cycles;
+} // END RET
 
-		flags.zero = false;
-		flags.subtract = false;
-		// TODO: See if this checks lower or upper bytes
-		flags.half_carry = emath::checkHCAdd(val1 & 0xFF, val2 & 0xFF);
-		flags.carry = emath::checkOFAdd(val1, val2);
 
-		done = true;
+// RETI - Pop from stack and jump to that address, then enable interrupts
+int CPU::opRETI(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END ADD SP,nn
+	// POP address
+	uint8_t lsb = mem.readByte(regs.sp);
+	regs.sp++;
+	cycles += 4;
 
-	// INC r - Increment value in/at register 'r'
-	case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x34: case 0x3C:
-	{
-		ins.mnemonic = "INC";
+	uint8_t msb = mem.readByte(regs.sp);
+	regs.sp++;
+	cycles += 4;
 
-		// Middle 3 bits define Target 1
-		ins.target1 = toTarget((byte) ((opcode & 0b00111000) >> 3));
+	uint16_t value = emath::bytesToUShort(msb, lsb);
 
-		if (ins.target1 != HL) {
-			uint8_t sum = getByteReg(ins.target1);
-			sum++;
-			setByteReg(ins.target1, sum);
+	next_interrupt_state = true;
 
-			flags.zero = (sum == 0);
-			flags.subtract = false;
-			flags.half_carry = emath::checkHCAdd(sum, 1);
+	// Jump to address
+	regs.pc = value;
 
-		} else {
+	return cycles;
+} // END RETI
 
-			ins.t1_as_address = true;
-			uint8_t sum = mem.readByte(regs.hl);
-			cycles += 4;
 
-			sum++;
+// RST n - Push current address onto stack, jump to vector
+int CPU::opRST(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			mem.writeByte(regs.hl, sum);
-			cycles += 4;
+	// Jump location is encoded in the middle 3 bits
+	uint16_t vector = opcode & 0b00111000;
 
-			flags.zero = (sum == 0);
-			flags.subtract = false;
-			flags.half_carry = emath::checkHCAdd(sum, 1);
-			// Carry is unchanged
-		}
+	// Break PC into bytes
+	uint8_t lsb = 0, msb = 0;
+	emath::ushortToBytes(regs.pc, &msb, &lsb);
 
-		done = true;
+	// Push MSB
+	regs.sp--;
+	mem.writeByte(regs.sp, msb);
+	cycles += 4;
 
-		break;
-	} // END INC r
+	// Push LSB
+	regs.sp--;
+	mem.writeByte(regs.sp, lsb);
+	cycles += 4;
 
-	// INC rr - Increment value in register 'rr'
-	case 0x03: case 0x13: case 0x23: case 0x33:
-	{
-		ins.mnemonic = "INC";
+	// Jump to address
+	regs.pc = vector;
 
-		switch (opcode)
-		{
-			case 0x03: ins.target1 = BC; break;
-			case 0x13: ins.target1 = DE; break;
-			case 0x23: ins.target1 = HL; break;
-			case 0x33: ins.target1 = SP; break;
-			default: break;
-		}
+	return cycles;
+} // END RST n
 
-		uint16_t sum = getShortReg(ins.target1);
-		sum++;
-		setShortReg(ins.target1, sum);
+// End Jump Instructions //
 
-		// Flags are not set
 
-		done = true;
 
-		break;
-	} // END INC rr
+// Rotate and Shift Instructions //
 
-	// DEC r - Decrement value in/at register 'r'
-	case 0x05: case 0x0D: case 0x15: case 0x1D:
-	case 0x25: case 0x2D: case 0x35: case 0x3D:
-	{
-		ins.mnemonic = "DEC";
+// RLCA - Shift A left - MSB to Carry flag and LSB
+int CPU::opRLCA(uint8_t opcode, MMU& mem)
+{
+	uint8_t value = regs.a;
 
-		// Middle 3 bits define Target 1
-		ins.target1 = toTarget((byte) ((opcode & 0b00111000) >> 3));
+	bool old_msb = (value >> 7) & 1;
+	value = (value << 1) | old_msb;
+	regs.a = value;
 
-		if (ins.target1 != HL) {
-			uint8_t dif = getByteReg(ins.target1);
-			dif--;
-			setByteReg(ins.target1, dif);
+	// Z, N, and H are cleared
+	flags.byteToFlags(old_msb << FlagRegister::CARRY_POSITION);
 
-			flags.zero = (dif == 0);
-			flags.subtract = true;
-			flags.half_carry = emath::checkHCSub(dif, 1);
+	return 0;
+} // END RLCA
 
-		} else {
 
-			ins.t1_as_address = true;
-			uint8_t dif = mem.readByte(regs.hl);
-			cycles += 4;
+// RRCA - Shift A right - old LSB to carry flag and MSB
+int CPU::opRRCA(uint8_t opcode, MMU& mem)
+{
+	uint8_t value = regs.a;
 
-			dif--;
+	bool old_lsb = value & 1;
+	value = (value >> 1) | (old_lsb << 7);
+	regs.a = value;
 
-			mem.writeByte(regs.hl, dif);
-			cycles += 4;
+	// Z, N, and H are cleared
+	flags.byteToFlags(old_lsb << FlagRegister::CARRY_POSITION);
 
-			flags.zero = (dif == 0);
-			flags.subtract = false;
-			flags.half_carry = emath::checkHCSub(dif, 1);
-			// Carry is unchanged
-		}
+	return 0;
+} // END RRCA
 
-		done = true;
 
-		break;
-	} // END DEC r
+// RLA - Shift A left - LSB to Carry flag, MSB to old Carry flag
+int CPU::opRLA(uint8_t opcode, MMU& mem)
+{
+	uint8_t value = regs.a;
 
-	// DEC rr
-	case 0x0B: case 0x1B: case 0x2B: case 0x3B:
-	{
-		ins.mnemonic = "DEC";
+	bool old_msb = (value >> 7) & 1;
+	value = (value << 1) | flags.getCarry();
+	regs.a = value;
 
-		switch (opcode)
-		{
-			case 0x0B: ins.target1 = BC; break;
-			case 0x1B: ins.target1 = DE; break;
-			case 0x2B: ins.target1 = HL; break;
-			case 0x3B: ins.target1 = SP; break;
-			default: break;
-		}
+	// Z, N, and H are cleared
+	flags.byteToFlags(old_msb << FlagRegister::CARRY_POSITION);
 
-		uint16_t dif = getShortReg(ins.target1);
-		dif--;
-		setShortReg(ins.target1, dif);
+	return 0;
+} // END RLA
 
-		// Flags are not set
 
-		done = true;
+// RRA - Shift A right - LSB to Carry flag, MSB to old Carry flag
+int CPU::opRRA(uint8_t opcode, MMU& mem)
+{
+	uint8_t value = regs.a;
 
-		break;
-	} // END DEC rr
+	bool old_lsb = value & 1;
+	value = (value >> 1) | (flags.getCarry() << 7);
+	regs.a = value;
 
-	//DAA - Retroactively adjusts A to a valid BCD result. This means something, and does something.
-	case 0x27:
-	{
-		ins.mnemonic = "DAA";
-		ins.target1 = A;
+	// Z, N, and H are cleared
+	flags.byteToFlags(old_lsb << FlagRegister::CARRY_POSITION);
 
-		// Taken from user AWJ @ https://forums.nesdev.org/viewtopic.php?t=15944
-		if (!flags.zero)
-		{  // after an addition, adjust if (half-)carry occurred or if result is out of bounds
-			if (flags.carry || regs.a > 0x99) { regs.a += 0x60; flags.carry = true; }
-			if (flags.half_carry || (regs.a & 0x0f) > 0x09) { regs.a += 0x6; }
-		} else
-		{  // after a subtraction, only adjust if (half-)carry occurred
-			if (flags.carry) { regs.a -= 0x60; }
-			if (flags.half_carry) { regs.a -= 0x60; }
-		}
-		// these flags are always updated
-		flags.zero = (regs.a == 0); // the usual z flag
-		flags.half_carry = false; // h flag is always cleared
+	return 0;
+} // END RRA
 
-		done = true;
+// End Rotate and Shift Instructions //
 
-		break;
-	} // END DAA
 
-	// CPL - Flip all bits in A
-	case 0x2F:
-	{
-		ins.mnemonic = "CPL";
-		ins.target1 = A;
 
-		regs.a = ~regs.a;
+// Two-Byte Instructions //
 
-		flags.subtract = true;
-		flags.half_carry = true;
+// ROTATE AND SHIFT //
 
-		done = true;
+// SWAP r - Swap the upper and lower nibbles of a byte
+int CPU::opSWAP(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END CPL
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// End Arithmetic Instructions //
+	uint8_t value;
 
+	if(target1 != HL)
+	{
+		value = getByteReg(target1);
 
+		uint8_t unibble = value & 0b11110000;
+		uint8_t lnibble = value & 0b00001111;
 
-	// Control Instructions //
+		value = (unibble >> 8) | (lnibble << 8);
 
-	//CCF - Flip Carry flag
-	case 0x3F:
-	{
-		ins.mnemonic = "CCF";
-		ins.target1 = F;
+		setByteReg(target1, value);
 
-		flags.carry = !flags.carry;
+	} else { // HL is an address
 
-		done = true;
+		value = mem.readByte(regs.hl);
+		cycles += 4;
 
-		break;
-	} // END CCF
+		uint8_t unibble = value & 0b11110000;
+		uint8_t lnibble = value & 0b00001111;
 
-	//SCF - Set Carry flag
-	case 0x37:
-	{
-		ins.mnemonic = "SCF";
-		ins.target1 = F;
+		value = (unibble >> 8) | (lnibble << 8);
 
-		flags.carry = true;
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		done = true;
+	}
 
-		break;
-	} // END SCF
+	flags.recordResult(value, 0);
 
-	// HALT
-	case 0x76:
-	{
-		ins.mnemonic = "HALT";
+	return cycles;
+} // END SWAP
 
-		halted = true;
 
-		done = true;
+// RLC r - Shift register 'r' left, MSB to Carry flag
+int CPU::opRLC(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END HALT
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// STOP
-	case 0x10:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "STOP";
+		uint8_t value = getByteReg(target1);
 
-		// TODO: Put Emulator in STOPPED state instead of crashing it.
-		throw std::runtime_error("STOP CALLED");
+		bool old_msb = (value >> 7) & 1;
+		value = (value << 1) | old_msb;
+		setByteReg(target1, value);
 
-		done = true;
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
 
-		break;
-	} // END STOP
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
+		cycles += 4;
 
-	// DI - Disable Interrupts after next instruction is executed
-	case 0xF3:
-	{
-		ins.mnemonic = "DI";
-		next_interrupt_state = false;
+		bool old_msb = (value >> 7) & 1;
+		value = (value << 1) | old_msb;
 
-		done = true;
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		break;
-	} // END DI
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
+	}
 
-	// EI - Enable Interrupts after next instruction is executed
-	case 0xFB:
-	{
-		ins.mnemonic = "EI";
-		next_interrupt_state = true;
+	return cycles;
+} // END RLC r
 
-		done = true;
 
-		break;
-	} // END EI
+// RL r - Shift register 'r' left, wrapped and set carry.
+int CPU::opRL(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// End Control Instructions //
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// JP nn,c - If condition met, jump to the immediate value 'nn'
-	case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "JP";
-		ins.target1 = IMMEDIATE;
+		uint8_t value = getByteReg(target1);
 
-		bool condition_met = true;
+		bool old_msb = (value >> 7) & 1;
+		value = (value << 1) | flags.getCarry();
+		setByteReg(target1, value);
 
-		switch (opcode)
-		{
-			case 0xC2: condition_met = !flags.zero; break;
-			case 0xCA: condition_met = flags.zero; break;
-			case 0xD2: condition_met = !flags.carry; break;
-			case 0xDA: condition_met = flags.carry; break;
-			default: break;
-		}
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
 
-		uint8_t lsb = mem.readByte(regs.pc);
-		regs.pc++;
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
 		cycles += 4;
-		uint8_t msb = mem.readByte(regs.pc);
-		regs.pc++;
+
+		bool old_msb = (value >> 7) & 1;
+		value = (value << 1) | flags.getCarry();
+
+		mem.writeByte(regs.hl, value);
 		cycles += 4;
 
-		uint16_t  address = emath::bytesToUShort(msb, lsb);
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
+
+	}
+
+	return cycles;
+} // END RL r
 
-		if (condition_met) { regs.pc = address; }
 
-		done = true;
+// RRC r - Shift register 'r' right, LSB to Carry flag
+int CPU::opRRC(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END JP nn,c
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// JR n,c - If condition met, jump to PC + 'n'
-	case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "JR";
-		ins.target1 = IMMEDIATE;
-
-		bool condition_met = true;
+		uint8_t value = getByteReg(target1);
 
-		switch (opcode)
-		{
-			case 0x20: condition_met = !flags.zero; break;
-			case 0x28: condition_met = flags.zero; break;
-			case 0x30: condition_met = !flags.carry; break;
-			case 0x38: condition_met = flags.carry; break;
-			default: break;
-		}
+		bool old_lsb = value & 1;
+		value = (value >> 1) | (old_lsb << 7);
+		setByteReg(target1, value);
 
-		uint16_t address = regs.pc;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-		address += mem.readByte(regs.pc);
-		regs.pc++;
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
 		cycles += 4;
 
-		if (condition_met) { regs.pc = address; }
+		bool old_lsb = value & 1;
+		value = (value >> 1) | (old_lsb << 7);
 
-		done = true;
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		break;
-	} // END JR n,c
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
+	}
 
-	// CALL - Push current PC onto stack, jump to address in immediate 16 bits
-	case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC:
-	{
-		ins.mnemonic = "CALL";
-		ins.target1 = IMMEDIATE;
+	return cycles;
+} // END RRC
 
-		bool condition_met = true;
 
-		switch(opcode)
-		{
-			case 0x20: condition_met = !flags.zero; break;
-			case 0x28: condition_met = flags.zero; break;
-			case 0x30: condition_met = !flags.carry; break;
-			case 0x38: condition_met = flags.carry; break;
-			default: break;
-		}
+// RR r - Shift register 'r' right, wrapped and set carry.
+int CPU::opRR(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		// Get address from nn
-		uint8_t lsb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
-		uint8_t msb = mem.readByte(regs.pc);
-		regs.pc++;
-		cycles += 4;
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-		uint16_t jump_address = emath::bytesToUShort(msb, lsb);
+	if(target1 != HL)
+	{
+		uint8_t value = getByteReg(target1);
 
-		if(condition_met)
-		{
-			// Break PC into bytes
-			uint8_t pclsb = 0, pcmsb = 0;
-			emath::ushortToBytes(regs.pc, &pclsb, &pcmsb);
-
-			// Push MSB
-			regs.sp--;
-			mem.writeByte(regs.sp, pcmsb);
-			cycles += 4;
-
-			// Push LSB
-			regs.sp--;
-			mem.writeByte(regs.sp, pclsb);
-			cycles += 4;
-
-			// Jump to address
-			regs.pc = jump_address;
-		}
+		bool old_lsb = value & 1;
+		value = (value >> 1) | (flags.getCarry() << 7);
+		setByteReg(target1, value);
 
-		done = true;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-		break;
-	} // END CALL
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
+		cycles += 4;
 
-	// RET - Pop from stack and jump to that address
-	case 0xC9: case 0xC0: case 0xC8: case 0xD0: case 0xD8:
-	{
-		ins.mnemonic = "RET";
-		ins.target1 = IMMEDIATE;
+		bool old_lsb = value & 1;
+		value = (value >> 1) | (flags.getCarry() << 7);
 
-		bool condition_met = true;
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		switch(opcode)
-		{
-			case 0xC0: condition_met = !flags.zero; break;
-			case 0xC8: condition_met = flags.zero; break;
-			case 0xD0: condition_met = !flags.carry; break;
-			case 0xD8: condition_met = flags.carry; break;
-			default: break;
-		}
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
+	}
 
-		if(condition_met)
-		{
-			// POP address
-			regs.sp++;
-			uint8_t lsb = mem.readByte(regs.sp);
-			cycles += 4;
+	return cycles;
+} // END RR
 
-			regs.sp++;
-			uint8_t msb = mem.readByte(regs.sp);
-			cycles += 4;
 
-			uint16_t value = emath::bytesToUShort(msb, lsb);
+// SLA r - Shift r left into carry, set LSB to 0
+int CPU::opSLA(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-			// Jump to address
-			regs.pc = value;
-		}
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-		done = true;
+	if(target1 != HL)
+	{
+		uint8_t value = getByteReg(target1);
 
-		break;
-	} // END RET
+		bool old_msb = (value >> 7) & 1;
+		value = value << 1;
+		setByteReg(target1, value);
 
-	// RETI - Pop from stack and jump to that address, then enable interrupts
-	case 0xD9:
-	{
-		ins.mnemonic = "RET";
-		ins.target1 = IMMEDIATE;
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
 
-		// POP address
-		regs.sp++;
-		uint8_t lsb = mem.readByte(regs.sp);
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
 		cycles += 4;
 
-		regs.sp++;
-		uint8_t msb = mem.readByte(regs.sp);
-		cycles += 4;
+		bool old_msb = (value >> 7) & 1;
+		value = value << 1;
 
-		uint16_t value = emath::bytesToUShort(msb, lsb);
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		next_interrupt_state = true;
+		flags.recordResult(value, old_msb << FlagRegister::CARRY_POSITION);
+	}
 
-		// Jump to address
-		regs.pc = value;
+	return cycles;
+} // END SLA
 
-		done = true;
 
-		break;
+// SRA r - Shift r right into Carry, leave MSB as-is
+int CPU::opSRA(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	} // END RETI
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// RST n - Push current address onto stack, jump to vector
-	case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "RST";
-
-		uint16_t vector;
-
-		// Get jump location
-		switch(opcode)
-		{
-			case 0xC7: vector = 0x00; break;
-			case 0xCF: vector = 0x08; break;
-			case 0xD7: vector = 0x10; break;
-			case 0xDF: vector = 0x18; break;
-			case 0xE7: vector = 0x20; break;
-			case 0xEF: vector = 0x28; break;
-			case 0xF7: vector = 0x30; break;
-			case 0xFF: vector = 0x38; break;
-			default: break;
-		} // END SWITCH
+		uint8_t value = getByteReg(target1);
 
-		// Break PC into bytes
-		uint8_t lsb = 0, msb = 0;
-		emath::ushortToBytes(regs.pc, &lsb, &msb);
+		bool old_lsb = value & 1;
+		bool old_msb = (value >> 7) & 1;
+		value = (value >> 1) | (old_msb << 7);
+		setByteReg(target1, value);
 
-		// Push MSB
-		regs.sp--;
-		mem.writeByte(regs.sp, msb);
-		cycles += 4;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-		// Push LSB
-		regs.sp--;
-		mem.writeByte(regs.sp, lsb);
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
 		cycles += 4;
 
-		// Jump to address
-		regs.pc = vector;
+		bool old_lsb = value & 1;
+		bool old_msb = (value >> 7) & 1;
+		value = (value >> 1) | (old_msb << 7);
 
-		done = true;
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-		break;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-	} // END RST n
+	}
 
-	// End Jump Instructions //
+	return cycles;
+} // END SRA
 
 
+// SRL r - Shift r left into Carry, MSB set to 0
+int CPU::opSRL(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// End Rotate and Shift Instructions //
+	TargetID target1 = toTarget(opcode & 0b00000111);
 
-	// RLCA - Shift A left - MSB to Carry flag and LSB
-	case 0x07:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "RLCA";
-		ins.target1 = A;
+		uint8_t value = getByteReg(target1);
 
-		uint8_t value = regs.a;
+		bool old_lsb = value & 1;
+		value = value >> 1;
+		setByteReg(target1, value);
 
-		bool old_msb = (value >> 7) & 1;
-		value = (value << 1) | old_msb;
-		flags.carry = old_msb;
-		regs.a = value;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-		flags.zero = false;
-		flags.subtract = false;
-		flags.half_carry = false;
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
+		cycles += 4;
 
-		done = true;
+		bool old_lsb = value & 1;
+		value = value >> 1;
 
-		break;
-	} // END RLCA
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
 
-	// RRCA - Shift A right - old LSB to carry flag and MSB
-	case 0x0F:
-	{
-		ins.mnemonic = "RRCA";
-		ins.target1 = A;
+		flags.recordResult(value, old_lsb << FlagRegister::CARRY_POSITION);
 
-		uint8_t value = regs.a;
+	}
 
-		bool old_lsb = value & 1;
-		value = (value >> 1) | (old_lsb << 7);
-		flags.carry = old_lsb;
-		regs.a = value;
+	return cycles;
+} // END SRL
 
-		flags.zero = false;
-		flags.subtract = false;
-		flags.half_carry = false;
+// END ROTATE AND SHIFT //
 
-		done = true;
+// SINGLE-BIT //
 
-		break;
-	} // END RRCA
+// BIT b,r - Check bit 'b' in register 'r'
+int CPU::opBIT(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-	// RLA - Shift A left - LSB to Carry flag, MSB to old Carry flag
-	case 0x17:
+	TargetID target1 = toTarget(opcode & 0b00000111);
+	// Bit to check is direct value in middle 3 bits
+	uint8_t check_bit = ((opcode & 0b00111000) >> 3);
+	uint8_t value;
+
+	if(target1 != HL)
 	{
-		ins.mnemonic = "RLA";
-		ins.target1 = A;
+		// Shift value so check_bit is at position 0,
+		// then mask to only bit zero
+		value = (getByteReg(target1) >> check_bit) & 1;
+
+	} else {
+		value = (mem.readByte(regs.hl) >> check_bit) & 1;
+		cycles += 4;
+	}
 
-		uint8_t value = regs.a;
+	// Z is set if the bit is clear. Carry is unchanged.
+	flags.setMasked(FlagRegister::ZERO_MASK
+					| FlagRegister::SUBTRACT_MASK
+					| FlagRegister::HALF_CARRY_MASK,
+					(!value << FlagRegister::ZERO_POSITION)
+					| FlagRegister::HALF_CARRY_MASK);
 
-		bool old_msb = (value >> 7) & 1;
-		value = (value << 1) | flags.carry;
-		flags.carry = old_msb;
-		regs.a = value;
+	return cycles;
+} // END BIT
 
-		flags.zero = false;
-		flags.subtract = false;
-		flags.half_carry = false;
 
-		done = true;
+// RES b,r - Reset bit 'b' in register 'r'
+int CPU::opRES(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
-		break;
-	} // END RLA
+	TargetID target1 = toTarget(opcode & 0b00000111);
+	// Bit to check is direct value in middle 3 bits
+	uint8_t check_bit = (opcode & 0b00111000) >> 3;
 
-	// RRA - Shift A right - LSB to Carry flag, MSB to old Carry flag
-	case 0x1F:
+	if(target1 != HL)
 	{
-		ins.mnemonic = "RRA";
-		ins.target1 = A;
-
-		byte value = regs.a;
+		uint8_t value = getByteReg(target1);
 
-		bool old_lsb = value & 1;
-		value = (value >> 1) | (flags.carry << 7);
-		flags.carry = old_lsb;
-		regs.a = value;
+		// Create a mask of all ones except check_bit
+		value &= ~(1 << check_bit);
 
-		flags.zero = false;
-		flags.subtract = false;
-		flags.half_carry = false;
+		setByteReg(target1, value);
 
-		done = true;
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
+		cycles += 4;
 
-		break;
-	} // END RRA
+		// Create a mask of all ones except check_bit
+		value &= ~(1 << check_bit);
 
-	// End Rotate and Shift Instructions //
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
+	}
 
+	return cycles;
+} // END RES
 
-	// End Jump Instructions //
 
-	default: break;
-	} // END THE BIG SWITCH
+// SET b,r - Set bit 'b' in register 'r'
+int CPU::opSET(uint8_t opcode, MMU& mem)
+{
+	int cycles = 0;
 
+	TargetID target1 = toTarget(opcode & 0b00000111);
+	// Bit to check is direct value in middle 3 bits
+	uint8_t check_bit = (opcode & 0b00111000) >> 3;
 
-	// TODO: The rest of the instructions
+	if(target1 != HL)
+	{
+		uint8_t value = getByteReg(target1);
+		value |= (1 << check_bit);
+		setByteReg(target1, value);
 
+	} else {
+		uint8_t value = mem.readByte(regs.hl);
+		cycles += 4;
 
+		value |= (1 << check_bit);
 
-	// Final logging/cleanup
+		mem.writeByte(regs.hl, value);
+		cycles += 4;
+	}
 
-	if(!done)
-	{
-		Logger::instance().log(
-				fmt::format("CPU: Unhandled instruction 0x{:02X}!",
-									opcode),
-				Logger::DEBUG
-				);
-	} else {
+	return cycles;
+} // END SET
 
-		Logger::instance().log(
-				fmt::format("CPU: Executed instruction {0}",
-									instructionToString(ins)),
-				Logger::EXTREME
-				);
-		Logger::instance().log(
-				fmt::format("CPU: New register state {0}",
-									registerToString(regs)),
-				Logger::EXTREME
-				);
-	}
+// END SINGLE BIT //
 
-	regs.f = flags.flagsToByte(); // Set flags register
-	cycles += 4; // Every instruction takes at least 4 cycles
+// End Two-Byte Instructions //
 
-	return cycles;
-}
 
 
 // Gets a byte from an 8-bit register
@@ -2132,7 +2655,7 @@ uint8_t CPU::getByteReg(TargetID target) const
 	switch(target)
 	{
 	case A: return regs.a;
-	case F: return regs.f;
+	case F: return flags.flagsToByte();
 	case B: return regs.b;
 	case C: return regs.c;
 	case D: return regs.d;
@@ -2154,7 +2677,7 @@ void CPU::setByteReg(TargetID target, uint8_t value)
 	switch(target)
 	{
 		case A: regs.a = value; return;
-		case F: regs.f = value; return;
+		case F: flags.byteToFlags(value); return;
 		case B: regs.b = value; return;
 		case C: regs.c = value; return;
 		case D: regs.d = value; return;
@@ -2175,7 +2698,7 @@ uint16_t CPU::getShortReg(TargetID target) const
 {
 	switch(target)
 	{
-	case AF: return regs.af;
+	case AF: return emath::bytesToUShort(regs.a, flags.flagsToByte());
 	case BC: return regs.bc;
 	case DE: return regs.de;
 	case HL: return regs.hl;
@@ -2195,7 +2718,12 @@ void CPU::setShortReg(TargetID target, uint16_t value)
 {
 	switch(target)
 	{
-	case AF: regs.af = value; return;
+	case AF:
+	{
+		regs.a = value >> 8;
+		flags.byteToFlags(value & 0xFF);
+		return;
+	}
 	case BC: regs.bc = value; return;
 	case DE: regs.de = value; return;
 	case HL: regs.hl = value; return;
@@ -2212,6 +2740,17 @@ void CPU::setShortReg(TargetID target, uint16_t value)
 
 
 
+// Gets a copy of every register, with F built from the current flags
+RegisterSet CPU::getRegisterSet() const
+{
+	RegisterSet output = regs;
+	output.f = flags.flagsToByte();
+
+	return output;
+}
+
+
+
 // Converts a 3-bit ID to a TargetID
 TargetID CPU::toTarget(uint8_t id)
 {
@@ -2236,4 +2775,4 @@ TargetID CPU::toTarget(uint8_t id)
 					);
 		}
 	}
-}
\ No newline at end of file
+}
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 12 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -16,16 +16,55 @@
 #include "../core.hpp"
 #include "gbstructs.hpp"
 #include "mmu.hpp"
+#include "tracer.hpp"
+#include "savestate.hpp"
+#include "jit.hpp"
 
 using namespace gbstructs;
 
 class CPU
 {
 public:
+	// How blocks get run
+	enum Engine : uint8_t
+	{
+		ENGINE_INTERPRETER,
+		ENGINE_JIT, // Hot ROM blocks are recompiled to x86-64
+	};
+
 	CPU();
 
+	// What executeBlock() ran
+	struct BlockResult
+	{
+		int cycles;
+		int instructions;
+		uint16_t last_pc; // Where the last instruction run starts
+		uint8_t last_opcode; // 0xCB for any CB instruction
+	};
+
 	// Executes an opcode, returns the number of cycles used
 	int execute(uint8_t opcode, MMU& mem);
+	// Executes the block of straight-line code at PC from the block cache,
+	// decoding it first on a miss. Stops early once max_cycles have been used,
+	// when interrupts get enabled, or when cached code or the interrupt
+	// registers are written, so interrupts are never taken late.
+	BlockResult executeBlock(MMU& mem, uint64_t max_cycles);
+	// Drops every cached block, and any recompiled code
+	void clearBlockCache();
+
+	// Picks how blocks get run. Returns false, staying on the interpreter, if
+	// this build or host can't recompile.
+	bool setEngine(Engine engine);
+	// Gets how blocks get run
+	Engine getEngine() const;
+
+	// Wakes from HALT if any enabled interrupt is requested, then jumps to the
+	// highest priority one if interrupts are enabled. Call between
+	// instructions. Returns the number of cycles used.
+	int handleInterrupts(MMU& mem);
+	// Gets if the CPU is halted, waiting for an interrupt
+	bool isHalted() const;
 
 	// SGetters
 
@@ -37,8 +76,23 @@ public:
 	uint16_t getShortReg(TargetID target) const;
 	// Sets a 16-bit register to a value
 	void setShortReg(TargetID target, uint16_t value);
+	// Gets a copy of every register, with F built from the current flags
+	RegisterSet getRegisterSet() const;
+
+	// Gets the instruction tracer. Only records if built with ASCIIBOY_TRACE.
+	Tracer& getTracer();
+
+	// Writes the registers and interrupt state into a save state
+	void saveState(savestate::StateWriter& state) const;
+	// Reads back what saveState() wrote
+	void loadState(savestate::StateReader& state);
+	// Moves past what saveState() wrote without loading it. Throws if the
+	// state is cut short.
+	void checkState(savestate::StateReader& state) const;
 
 private:
+	// regs.f is not kept up to date. Flags live in the lazy FlagRegister,
+	// and are only packed into F when read through the getters above.
 	RegisterSet regs{};
 	FlagRegister flags{};
 
@@ -46,6 +100,178 @@ private:
 	bool interrupts_enabled;
 	bool next_interrupt_state;
 
+	Tracer tracer;
+
 	// Converts a 3-bit ID to a TargetID
 	static TargetID toTarget(uint8_t id);
+
+	// Opcode dispatch //
+
+	// Every opcode handler returns the cycles used on top of the base 4
+	using OpHandler = int (CPU::*)(uint8_t opcode, MMU& mem);
+
+	// Handlers for the main opcodes, indexed by opcode
+	static const std::array<OpHandler, 256> OPCODE_TABLE;
+	// Handlers for the opcodes following a 0xCB prefix, indexed by opcode
+	static const std::array<OpHandler, 256> CB_OPCODE_TABLE;
+
+	// Builds OPCODE_TABLE. Evaluated at compile time.
+	static constexpr std::array<OpHandler, 256> buildOpcodeTable();
+	// Builds CB_OPCODE_TABLE. Evaluated at compile time.
+	static constexpr std::array<OpHandler, 256> buildCBOpcodeTable();
+
+	// Block cache //
+
+	static constexpr int MAX_BLOCK_OPS = 16;
+	static constexpr int BLOCK_CACHE_SIZE = 1024; // Must be a power of 2
+
+	// An instruction, without its handler: that is looked up as it runs,
+	// which keeps an op at 2 bytes and the whole cache around 56KB
+	struct DecodedOp
+	{
+		uint8_t opcode; // The second byte, for CB instructions
+		uint8_t length : 2; // Including the prefix and operands
+		uint8_t is_cb : 1;
+	};
+
+	// Recompiled code for a block. Returns the cycles used, and sets
+	// instructions to how many of the block's ops ran.
+	using NativeBlock = uint32_t (*)(CPU* cpu, MMU* mem, RegisterSet* regs,
+									 int* instructions);
+
+	// Straight-line code up to and including whatever ends it: a jump, call,
+	// return, HALT, STOP, EI, DI, or an unhandled opcode
+	struct Block
+	{
+		NativeBlock native; // Recompiled code, or nullptr
+		uint32_t generation; // The MMU code generation it was decoded at
+		uint16_t start;
+		int16_t bank; // The ROM2 bank for $4000-$7FFF, else 0. -1 if empty.
+		uint16_t max_cycles; // Most cycles the recompiled code can use
+		uint8_t run_count; // Times run since it was decoded
+		uint8_t op_amount;
+		std::array<DecodedOp, MAX_BLOCK_OPS> ops;
+	};
+
+	// Direct mapped by address and bank. A miss decodes over the old block.
+	// Allocated on the first lookup.
+	std::vector<Block> block_cache;
+
+	// Finds the block at an address, decoding it on a miss
+	Block& findBlock(uint16_t address, int bank, MMU& mem);
+	// Decodes the block at an address into a cache slot
+	void decodeBlock(Block& block, uint16_t address, int bank, MMU& mem);
+	// Executes a decoded instruction, returns the number of cycles used
+	inline int executeOp(const DecodedOp& op, MMU& mem);
+
+	// Recompiler //
+
+	// How many times a ROM block is interpreted before it is recompiled
+	static constexpr uint32_t JIT_THRESHOLD = 32;
+	static constexpr size_t JIT_BUFFER_SIZE = 4 * 1024 * 1024;
+	// Set in what runOpFromNative() returns when the block has to end early
+	static constexpr uint32_t JIT_STOP = 0x80000000;
+
+	Engine engine;
+	std::unique_ptr<CodeBuffer> code_buffer; // Only made for ENGINE_JIT
+
+	// Recompiles a ROM block into code_buffer. Ops without a native version
+	// call back into their handlers through runOpFromNative().
+	void compileBlock(Block& block, MMU& mem);
+	// Emits an op that doesn't touch flags or memory as native code. Returns
+	// its cycles, or -1 if it has to go through its handler.
+	int emitNativeOp(const DecodedOp& op, uint16_t address, MMU& mem);
+	// Runs a block's recompiled code
+	BlockResult runNative(const Block& block, MMU& mem);
+	// Runs one op through its handler for recompiled code. Returns its cycles,
+	// with JIT_STOP set if the block has to end after it.
+	static uint32_t runOpFromNative(CPU* cpu, MMU* mem, const DecodedOp* op,
+									uint32_t address);
+
+	// Opcodes with no implementation yet
+	int opUnhandled(uint8_t opcode, MMU& mem);
+	// 0xCB prefix, dispatches into CB_OPCODE_TABLE
+	int opPrefixCB(uint8_t opcode, MMU& mem);
+
+	// Load Instructions
+	int opNOP(uint8_t opcode, MMU& mem);
+	int opLD_r_r(uint8_t opcode, MMU& mem);
+	int opLDH_A_na(uint8_t opcode, MMU& mem);
+	int opLD_HLa_n(uint8_t opcode, MMU& mem);
+	int opLD_rra_A(uint8_t opcode, MMU& mem);
+	int opLD_nna_A(uint8_t opcode, MMU& mem);
+	int opLD_r_n(uint8_t opcode, MMU& mem);
+	int opLDH_Ca_A(uint8_t opcode, MMU& mem);
+	int opLDH_A_Ca(uint8_t opcode, MMU& mem);
+	int opLDH_na_A(uint8_t opcode, MMU& mem);
+	int opLD_rr_nn(uint8_t opcode, MMU& mem);
+	int opLD_SP_HL(uint8_t opcode, MMU& mem);
+	int opLD_HL_SPn(uint8_t opcode, MMU& mem);
+	int opLD_nna_SP(uint8_t opcode, MMU& mem);
+	int opLDI_HLa_A(uint8_t opcode, MMU& mem);
+	int opLDI_A_HLa(uint8_t opcode, MMU& mem);
+	int opLDD_HLa_A(uint8_t opcode, MMU& mem);
+	int opLDD_A_HLa(uint8_t opcode, MMU& mem);
+	int opPUSH(uint8_t opcode, MMU& mem);
+	int opPOP(uint8_t opcode, MMU& mem);
+
+	// Arithmetic Instructions
+	int opADD_A_r(uint8_t opcode, MMU& mem);
+	int opADC_A_r(uint8_t opcode, MMU& mem);
+	int opSUB_A_r(uint8_t opcode, MMU& mem);
+	int opSBC_A_r(uint8_t opcode, MMU& mem);
+	int opAND_A_r(uint8_t opcode, MMU& mem);
+	int opOR_A_r(uint8_t opcode, MMU& mem);
+	int opXOR_A_r(uint8_t opcode, MMU& mem);
+	int opCP_A_r(uint8_t opcode, MMU& mem);
+	int opADD_A_n(uint8_t opcode, MMU& mem);
+	int opCP_A_n(uint8_t opcode, MMU& mem);
+	int opADC_A_n(uint8_t opcode, MMU& mem);
+	int opSBC_A_n(uint8_t opcode, MMU& mem);
+	int opAND_A_n(uint8_t opcode, MMU& mem);
+	int opOR_A_n(uint8_t opcode, MMU& mem);
+	int opXOR_A_n(uint8_t opcode, MMU& mem);
+	int opADD_HL_rr(uint8_t opcode, MMU& mem);
+	int opADD_SP_nn(uint8_t opcode, MMU& mem);
+	int opINC_r(uint8_t opcode, MMU& mem);
+	int opINC_rr(uint8_t opcode, MMU& mem);
+	int opDEC_r(uint8_t opcode, MMU& mem);
+	int opDEC_rr(uint8_t opcode, MMU& mem);
+	int opDAA(uint8_t opcode, MMU& mem);
+	int opCPL(uint8_t opcode, MMU& mem);
+
+	// Control Instructions
+	int opCCF(uint8_t opcode, MMU& mem);
+	int opSCF(uint8_t opcode, MMU& mem);
+	int opHALT(uint8_t opcode, MMU& mem);
+	int opSTOP(uint8_t opcode, MMU& mem);
+	int opDI(uint8_t opcode, MMU& mem);
+	int opEI(uint8_t opcode, MMU& mem);
+
+	// Jump Instructions
+	int opJP(uint8_t opcode, MMU& mem);
+	int opJR(uint8_t opcode, MMU& mem);
+	int opCALL(uint8_t opcode, MMU& mem);
+	int opRET(uint8_t opcode, MMU& mem);
+	int opRETI(uint8_t opcode, MMU& mem);
+	int opRST(uint8_t opcode, MMU& mem);
+
+	// Rotate and Shift Instructions
+	int opRLCA(uint8_t opcode, MMU& mem);
+	int opRRCA(uint8_t opcode, MMU& mem);
+	int opRLA(uint8_t opcode, MMU& mem);
+	int opRRA(uint8_t opcode, MMU& mem);
+
+	// Two-Byte Instructions
+	int opSWAP(uint8_t opcode, MMU& mem);
+	int opRLC(uint8_t opcode, MMU& mem);
+	int opRL(uint8_t opcode, MMU& mem);
+	int opRRC(uint8_t opcode, MMU& mem);
+	int opRR(uint8_t opcode, MMU& mem);
+	int opSLA(uint8_t opcode, MMU& mem);
+	int opSRA(uint8_t opcode, MMU& mem);
+	int opSRL(uint8_t opcode, MMU& mem);
+	int opBIT(uint8_t opcode, MMU& mem);
+	int opRES(uint8_t opcode, MMU& mem);
+	int opSET(uint8_t opcode, MMU& mem);
 };
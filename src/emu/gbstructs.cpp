@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 12 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -65,99 +65,546 @@ std::string gbstructs::registerToString(RegisterSet regs) {
 
 
 
-// Converts a 3-bit register ID to a TargetID
-std::string gbstructs::instructionToString(CPUInstruction ins)
+// Info for every main opcode, indexed by opcode
+const std::array<OpcodeInfo, 256> gbstructs::OPCODE_INFO =
+{{
+		{"NOP", 1, 4}, // 0x00
+		{"LD BC,${1:04X}", 3, 12}, // 0x01
+		{"LD (BC),A", 1, 8}, // 0x02
+		{"INC BC", 1, 8}, // 0x03
+		{"INC B", 1, 4}, // 0x04
+		{"DEC B", 1, 4}, // 0x05
+		{"LD B,${0:02X}", 2, 8}, // 0x06
+		{"RLCA", 1, 4}, // 0x07
+		{"LD (${1:04X}),SP", 3, 20}, // 0x08
+		{"ADD HL,BC", 1, 8}, // 0x09
+		{"LD A,(BC)", 1, 8}, // 0x0A
+		{"DEC BC", 1, 8}, // 0x0B
+		{"INC C", 1, 4}, // 0x0C
+		{"DEC C", 1, 4}, // 0x0D
+		{"LD C,${0:02X}", 2, 8}, // 0x0E
+		{"RRCA", 1, 4}, // 0x0F
+		{"STOP", 2, 4}, // 0x10
+		{"LD DE,${1:04X}", 3, 12}, // 0x11
+		{"LD (DE),A", 1, 8}, // 0x12
+		{"INC DE", 1, 8}, // 0x13
+		{"INC D", 1, 4}, // 0x14
+		{"DEC D", 1, 4}, // 0x15
+		{"LD D,${0:02X}", 2, 8}, // 0x16
+		{"RLA", 1, 4}, // 0x17
+		{"JR {2:+d}", 2, 12}, // 0x18
+		{"ADD HL,DE", 1, 8}, // 0x19
+		{"LD A,(DE)", 1, 8}, // 0x1A
+		{"DEC DE", 1, 8}, // 0x1B
+		{"INC E", 1, 4}, // 0x1C
+		{"DEC E", 1, 4}, // 0x1D
+		{"LD E,${0:02X}", 2, 8}, // 0x1E
+		{"RRA", 1, 4}, // 0x1F
+		{"JR NZ,{2:+d}", 2, 12}, // 0x20
+		{"LD HL,${1:04X}", 3, 12}, // 0x21
+		{"LD (HL+),A", 1, 8}, // 0x22
+		{"INC HL", 1, 8}, // 0x23
+		{"INC H", 1, 4}, // 0x24
+		{"DEC H", 1, 4}, // 0x25
+		{"LD H,${0:02X}", 2, 8}, // 0x26
+		{"DAA", 1, 4}, // 0x27
+		{"JR Z,{2:+d}", 2, 12}, // 0x28
+		{"ADD HL,HL", 1, 8}, // 0x29
+		{"LD A,(HL+)", 1, 8}, // 0x2A
+		{"DEC HL", 1, 8}, // 0x2B
+		{"INC L", 1, 4}, // 0x2C
+		{"DEC L", 1, 4}, // 0x2D
+		{"LD L,${0:02X}", 2, 8}, // 0x2E
+		{"CPL", 1, 4}, // 0x2F
+		{"JR NC,{2:+d}", 2, 12}, // 0x30
+		{"LD SP,${1:04X}", 3, 12}, // 0x31
+		{"LD (HL-),A", 1, 8}, // 0x32
+		{"INC SP", 1, 8}, // 0x33
+		{"INC (HL)", 1, 12}, // 0x34
+		{"DEC (HL)", 1, 12}, // 0x35
+		{"LD (HL),${0:02X}", 2, 12}, // 0x36
+		{"SCF", 1, 4}, // 0x37
+		{"JR C,{2:+d}", 2, 12}, // 0x38
+		{"ADD HL,SP", 1, 8}, // 0x39
+		{"LD A,(HL-)", 1, 8}, // 0x3A
+		{"DEC SP", 1, 8}, // 0x3B
+		{"INC A", 1, 4}, // 0x3C
+		{"DEC A", 1, 4}, // 0x3D
+		{"LD A,${0:02X}", 2, 8}, // 0x3E
+		{"CCF", 1, 4}, // 0x3F
+		{"LD B,B", 1, 4}, // 0x40
+		{"LD B,C", 1, 4}, // 0x41
+		{"LD B,D", 1, 4}, // 0x42
+		{"LD B,E", 1, 4}, // 0x43
+		{"LD B,H", 1, 4}, // 0x44
+		{"LD B,L", 1, 4}, // 0x45
+		{"LD B,(HL)", 1, 8}, // 0x46
+		{"LD B,A", 1, 4}, // 0x47
+		{"LD C,B", 1, 4}, // 0x48
+		{"LD C,C", 1, 4}, // 0x49
+		{"LD C,D", 1, 4}, // 0x4A
+		{"LD C,E", 1, 4}, // 0x4B
+		{"LD C,H", 1, 4}, // 0x4C
+		{"LD C,L", 1, 4}, // 0x4D
+		{"LD C,(HL)", 1, 8}, // 0x4E
+		{"LD C,A", 1, 4}, // 0x4F
+		{"LD D,B", 1, 4}, // 0x50
+		{"LD D,C", 1, 4}, // 0x51
+		{"LD D,D", 1, 4}, // 0x52
+		{"LD D,E", 1, 4}, // 0x53
+		{"LD D,H", 1, 4}, // 0x54
+		{"LD D,L", 1, 4}, // 0x55
+		{"LD D,(HL)", 1, 8}, // 0x56
+		{"LD D,A", 1, 4}, // 0x57
+		{"LD E,B", 1, 4}, // 0x58
+		{"LD E,C", 1, 4}, // 0x59
+		{"LD E,D", 1, 4}, // 0x5A
+		{"LD E,E", 1, 4}, // 0x5B
+		{"LD E,H", 1, 4}, // 0x5C
+		{"LD E,L", 1, 4}, // 0x5D
+		{"LD E,(HL)", 1, 8}, // 0x5E
+		{"LD E,A", 1, 4}, // 0x5F
+		{"LD H,B", 1, 4}, // 0x60
+		{"LD H,C", 1, 4}, // 0x61
+		{"LD H,D", 1, 4}, // 0x62
+		{"LD H,E", 1, 4}, // 0x63
+		{"LD H,H", 1, 4}, // 0x64
+		{"LD H,L", 1, 4}, // 0x65
+		{"LD H,(HL)", 1, 8}, // 0x66
+		{"LD H,A", 1, 4}, // 0x67
+		{"LD L,B", 1, 4}, // 0x68
+		{"LD L,C", 1, 4}, // 0x69
+		{"LD L,D", 1, 4}, // 0x6A
+		{"LD L,E", 1, 4}, // 0x6B
+		{"LD L,H", 1, 4}, // 0x6C
+		{"LD L,L", 1, 4}, // 0x6D
+		{"LD L,(HL)", 1, 8}, // 0x6E
+		{"LD L,A", 1, 4}, // 0x6F
+		{"LD (HL),B", 1, 8}, // 0x70
+		{"LD (HL),C", 1, 8}, // 0x71
+		{"LD (HL),D", 1, 8}, // 0x72
+		{"LD (HL),E", 1, 8}, // 0x73
+		{"LD (HL),H", 1, 8}, // 0x74
+		{"LD (HL),L", 1, 8}, // 0x75
+		{"HALT", 1, 4}, // 0x76
+		{"LD (HL),A", 1, 8}, // 0x77
+		{"LD A,B", 1, 4}, // 0x78
+		{"LD A,C", 1, 4}, // 0x79
+		{"LD A,D", 1, 4}, // 0x7A
+		{"LD A,E", 1, 4}, // 0x7B
+		{"LD A,H", 1, 4}, // 0x7C
+		{"LD A,L", 1, 4}, // 0x7D
+		{"LD A,(HL)", 1, 8}, // 0x7E
+		{"LD A,A", 1, 4}, // 0x7F
+		{"ADD A,B", 1, 4}, // 0x80
+		{"ADD A,C", 1, 4}, // 0x81
+		{"ADD A,D", 1, 4}, // 0x82
+		{"ADD A,E", 1, 4}, // 0x83
+		{"ADD A,H", 1, 4}, // 0x84
+		{"ADD A,L", 1, 4}, // 0x85
+		{"ADD A,(HL)", 1, 8}, // 0x86
+		{"ADD A,A", 1, 4}, // 0x87
+		{"ADC A,B", 1, 4}, // 0x88
+		{"ADC A,C", 1, 4}, // 0x89
+		{"ADC A,D", 1, 4}, // 0x8A
+		{"ADC A,E", 1, 4}, // 0x8B
+		{"ADC A,H", 1, 4}, // 0x8C
+		{"ADC A,L", 1, 4}, // 0x8D
+		{"ADC A,(HL)", 1, 8}, // 0x8E
+		{"ADC A,A", 1, 4}, // 0x8F
+		{"SUB B", 1, 4}, // 0x90
+		{"SUB C", 1, 4}, // 0x91
+		{"SUB D", 1, 4}, // 0x92
+		{"SUB E", 1, 4}, // 0x93
+		{"SUB H", 1, 4}, // 0x94
+		{"SUB L", 1, 4}, // 0x95
+		{"SUB (HL)", 1, 8}, // 0x96
+		{"SUB A", 1, 4}, // 0x97
+		{"SBC A,B", 1, 4}, // 0x98
+		{"SBC A,C", 1, 4}, // 0x99
+		{"SBC A,D", 1, 4}, // 0x9A
+		{"SBC A,E", 1, 4}, // 0x9B
+		{"SBC A,H", 1, 4}, // 0x9C
+		{"SBC A,L", 1, 4}, // 0x9D
+		{"SBC A,(HL)", 1, 8}, // 0x9E
+		{"SBC A,A", 1, 4}, // 0x9F
+		{"AND B", 1, 4}, // 0xA0
+		{"AND C", 1, 4}, // 0xA1
+		{"AND D", 1, 4}, // 0xA2
+		{"AND E", 1, 4}, // 0xA3
+		{"AND H", 1, 4}, // 0xA4
+		{"AND L", 1, 4}, // 0xA5
+		{"AND (HL)", 1, 8}, // 0xA6
+		{"AND A", 1, 4}, // 0xA7
+		{"XOR B", 1, 4}, // 0xA8
+		{"XOR C", 1, 4}, // 0xA9
+		{"XOR D", 1, 4}, // 0xAA
+		{"XOR E", 1, 4}, // 0xAB
+		{"XOR H", 1, 4}, // 0xAC
+		{"XOR L", 1, 4}, // 0xAD
+		{"XOR (HL)", 1, 8}, // 0xAE
+		{"XOR A", 1, 4}, // 0xAF
+		{"OR B", 1, 4}, // 0xB0
+		{"OR C", 1, 4}, // 0xB1
+		{"OR D", 1, 4}, // 0xB2
+		{"OR E", 1, 4}, // 0xB3
+		{"OR H", 1, 4}, // 0xB4
+		{"OR L", 1, 4}, // 0xB5
+		{"OR (HL)", 1, 8}, // 0xB6
+		{"OR A", 1, 4}, // 0xB7
+		{"CP B", 1, 4}, // 0xB8
+		{"CP C", 1, 4}, // 0xB9
+		{"CP D", 1, 4}, // 0xBA
+		{"CP E", 1, 4}, // 0xBB
+		{"CP H", 1, 4}, // 0xBC
+		{"CP L", 1, 4}, // 0xBD
+		{"CP (HL)", 1, 8}, // 0xBE
+		{"CP A", 1, 4}, // 0xBF
+		{"RET NZ", 1, 20}, // 0xC0
+		{"POP BC", 1, 12}, // 0xC1
+		{"JP NZ,${1:04X}", 3, 16}, // 0xC2
+		{"JP ${1:04X}", 3, 16}, // 0xC3
+		{"CALL NZ,${1:04X}", 3, 24}, // 0xC4
+		{"PUSH BC", 1, 16}, // 0xC5
+		{"ADD A,${0:02X}", 2, 8}, // 0xC6
+		{"RST $00", 1, 16}, // 0xC7
+		{"RET Z", 1, 20}, // 0xC8
+		{"RET", 1, 16}, // 0xC9
+		{"JP Z,${1:04X}", 3, 16}, // 0xCA
+		{"PREFIX CB", 2, 16}, // 0xCB
+		{"CALL Z,${1:04X}", 3, 24}, // 0xCC
+		{"CALL ${1:04X}", 3, 24}, // 0xCD
+		{"ADC A,${0:02X}", 2, 8}, // 0xCE
+		{"RST $08", 1, 16}, // 0xCF
+		{"RET NC", 1, 20}, // 0xD0
+		{"POP DE", 1, 12}, // 0xD1
+		{"JP NC,${1:04X}", 3, 16}, // 0xD2
+		{"ILLEGAL", 1, 4}, // 0xD3
+		{"CALL NC,${1:04X}", 3, 24}, // 0xD4
+		{"PUSH DE", 1, 16}, // 0xD5
+		{"SUB ${0:02X}", 2, 8}, // 0xD6
+		{"RST $10", 1, 16}, // 0xD7
+		{"RET C", 1, 20}, // 0xD8
+		{"RETI", 1, 16}, // 0xD9
+		{"JP C,${1:04X}", 3, 16}, // 0xDA
+		{"ILLEGAL", 1, 4}, // 0xDB
+		{"CALL C,${1:04X}", 3, 24}, // 0xDC
+		{"ILLEGAL", 1, 4}, // 0xDD
+		{"SBC A,${0:02X}", 2, 8}, // 0xDE
+		{"RST $18", 1, 16}, // 0xDF
+		{"LDH (${0:02X}),A", 2, 12}, // 0xE0
+		{"POP HL", 1, 12}, // 0xE1
+		{"LD (C),A", 1, 8}, // 0xE2
+		{"ILLEGAL", 1, 4}, // 0xE3
+		{"ILLEGAL", 1, 4}, // 0xE4
+		{"PUSH HL", 1, 16}, // 0xE5
+		{"AND ${0:02X}", 2, 8}, // 0xE6
+		{"RST $20", 1, 16}, // 0xE7
+		{"ADD SP,{2:+d}", 2, 16}, // 0xE8
+		{"JP HL", 1, 4}, // 0xE9
+		{"LD (${1:04X}),A", 3, 16}, // 0xEA
+		{"ILLEGAL", 1, 4}, // 0xEB
+		{"ILLEGAL", 1, 4}, // 0xEC
+		{"ILLEGAL", 1, 4}, // 0xED
+		{"XOR ${0:02X}", 2, 8}, // 0xEE
+		{"RST $28", 1, 16}, // 0xEF
+		{"LDH A,(${0:02X})", 2, 12}, // 0xF0
+		{"POP AF", 1, 12}, // 0xF1
+		{"LD A,(C)", 1, 8}, // 0xF2
+		{"DI", 1, 4}, // 0xF3
+		{"ILLEGAL", 1, 4}, // 0xF4
+		{"PUSH AF", 1, 16}, // 0xF5
+		{"OR ${0:02X}", 2, 8}, // 0xF6
+		{"RST $30", 1, 16}, // 0xF7
+		{"LD HL,SP{2:+d}", 2, 12}, // 0xF8
+		{"LD SP,HL", 1, 8}, // 0xF9
+		{"LD A,(${1:04X})", 3, 16}, // 0xFA
+		{"EI", 1, 4}, // 0xFB
+		{"ILLEGAL", 1, 4}, // 0xFC
+		{"ILLEGAL", 1, 4}, // 0xFD
+		{"CP ${0:02X}", 2, 8}, // 0xFE
+		{"RST $38", 1, 16}, // 0xFF
+
+}};
+
+
+
+// Disassembles an instruction from its opcode and the two bytes after it
+std::string gbstructs::disassemble(uint8_t opcode, uint8_t byte1, uint8_t byte2)
 {
-	std::string output{};
+	if(opcode == 0xCB)
+	{
+		// CB opcodes are regular enough to decode from their bits
+		static constexpr const char* OPS[8] =
+				{ "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL" };
+		static constexpr const char* REGS[8] =
+				{ "B", "C", "D", "E", "H", "L", "(HL)", "A" };
+
+		int group = byte1 >> 6;
+		int bit = (byte1 >> 3) & 0b111;
+		const char* reg = REGS[byte1 & 0b111];
+
+		switch(group)
+		{
+		case 0: return fmt::format("{} {}", OPS[bit], reg);
+		case 1: return fmt::format("BIT {},{}", bit, reg);
+		case 2: return fmt::format("RES {},{}", bit, reg);
+		default: return fmt::format("SET {},{}", bit, reg);
+		}
+	}
 
-	output.append("(");
+	return fmt::format(fmt::runtime(OPCODE_INFO[opcode].format),
+					   byte1,
+					   emath::bytesToUShort(byte2, byte1),
+					   static_cast<int8_t>(byte1));
+}
 
-	// Format the string as it would be in a .asm file, more or less
 
-	std::string target1str{}, target2str{};
 
-	if(ins.target1 == NOTARGET) { target1str = ""; }
-	else if(ins.target1 == IMMEDIATE) { target1str = "n"; }
-	else { target1str = enumToString(ins.target1); }
 
-	if(ins.target2 == NOTARGET) { target2str = ""; }
-	else if(ins.target2 == IMMEDIATE) { target2str = "n"; }
-	else { target2str = enumToString(ins.target1); }
+// FLAGREGISTER CLASS //
 
-	output.append("INS: " + ins.mnemonic + " ");
-	if(ins.t1_as_address)
-	{
-		output.append(fmt::format("({})", target1str));
-	} else if(ins.target1 != NOTARGET) {
-		output.append(fmt::format("{}", target1str));
-	}
 
-	if(ins.t2_as_address)
-	{
-		output.append(",");
-		output.append(fmt::format("({})", target2str));
-	} else if(ins.target2 != NOTARGET) {
-		output.append(",");
-		output.append(fmt::format("{}", target2str));
-	}
+// Constructor
+gbstructs::FlagRegister::FlagRegister()
+{
+	resolved = 0;
+	pending = 0;
+
+	op = ADD8;
+	lhs = 0;
+	rhs = 0;
+	carry_in = false;
+}
 
-	output.append(" | ");
 
-	output.append(fmt::format("Origin Address: ${:04X} | ", ins.origin));
+// Gets a flag, computing it from the last recorded op if needed
+bool FlagRegister::getZero() const { return getFlag(ZERO_MASK); }
+bool FlagRegister::getSubtract() const { return getFlag(SUBTRACT_MASK); }
+bool FlagRegister::getHalfCarry() const { return getFlag(HALF_CARRY_MASK); }
+bool FlagRegister::getCarry() const { return getFlag(CARRY_MASK); }
 
-	if(ins.two_byte)
+
+// Gets a single flag by its mask
+bool FlagRegister::getFlag(uint8_t mask) const
+{
+	if(pending & mask)
 	{
-		output.append(fmt::format("Opcode: 0x{:04X}", ins.opcode));
-	} else {
-		output.append(fmt::format("Opcode: 0x{:02X}", ins.opcode));
+		return computePending() & mask;
 	}
-	output.append(")");
 
-	// Old string logic
-//	output.append("INS: " + ins.mnemonic + " | ");
-//	output.append("Target1: " + enumToString(ins.target1) + " | ");
-//	output.append("Target2: " + enumToString(ins.target2) + " | ");
-//	output.append(fmt::format("T1 Address: {} | ", ins.t1_as_address));
-//	output.append(fmt::format("T2 Address: {} | ", ins.t2_as_address));
+	return resolved & mask;
+}
 
-	return output;
+
+// Sets the flags in mask to the matching bits of value.
+void FlagRegister::setMasked(uint8_t mask, uint8_t value)
+{
+	resolved = (resolved & ~mask) | (value & mask);
+	pending &= ~mask;
 }
 
 
+// Records an 8-bit addition (a + b + carry_in). Sets Z, N, H, and C.
+void FlagRegister::recordAdd(uint8_t a, uint8_t b, bool carry)
+{
+	op = ADD8;
+	lhs = a;
+	rhs = b;
+	carry_in = carry;
 
+	resolved = 0; // N is cleared
+	pending = ZERO_MASK | HALF_CARRY_MASK | CARRY_MASK;
+}
 
-// FLAGREGISTER CLASS //
 
+// Records an 8-bit subtraction (a - b - carry_in). Sets Z, N, H, and C.
+void FlagRegister::recordSub(uint8_t a, uint8_t b, bool carry)
+{
+	op = SUB8;
+	lhs = a;
+	rhs = b;
+	carry_in = carry;
+
+	resolved = SUBTRACT_MASK;
+	pending = ZERO_MASK | HALF_CARRY_MASK | CARRY_MASK;
+}
 
-// Converts a byte (f register) into flag booleans
-gbstructs::FlagRegister::FlagRegister()
+
+// Records an 8-bit increment of a. Sets Z, N, and H.
+void FlagRegister::recordInc(uint8_t a)
 {
-	zero = false;
-	subtract = false;
-	half_carry = false;
-	carry = false;
+	// Carry is unchanged, so it has to be settled before the op is replaced.
+	// Only it, the rest of the last op's flags are about to be overwritten.
+	uint8_t carry = getFlag(CARRY_MASK) ? CARRY_MASK : 0;
+
+	op = ADD8;
+	lhs = a;
+	rhs = 1;
+	carry_in = false;
+
+	resolved = carry;
+	pending = ZERO_MASK | HALF_CARRY_MASK;
 }
 
 
-// Converts the flags into a byte (f register)
-uint8_t FlagRegister::flagsToByte()
+// Records an 8-bit decrement of a. Sets Z, N, and H.
+void FlagRegister::recordDec(uint8_t a)
 {
+	// Carry is unchanged, so it has to be settled before the op is replaced.
+	// Only it, the rest of the last op's flags are about to be overwritten.
+	uint8_t carry = getFlag(CARRY_MASK) ? CARRY_MASK : 0;
+
+	op = SUB8;
+	lhs = a;
+	rhs = 1;
+	carry_in = false;
+
+	resolved = carry | SUBTRACT_MASK;
+	pending = ZERO_MASK | HALF_CARRY_MASK;
+}
+
+
+// Records a 16-bit addition (a + b). Sets N, H, and C.
+void FlagRegister::recordAdd16(uint16_t a, uint16_t b)
+{
+	// Zero is unchanged, so it has to be settled before the op is replaced.
+	// Only it, the rest of the last op's flags are about to be overwritten.
+	uint8_t zero = getFlag(ZERO_MASK) ? ZERO_MASK : 0;
+
+	op = ADD16;
+	lhs = a;
+	rhs = b;
+	carry_in = false;
+
+	resolved = zero;
+	pending = HALF_CARRY_MASK | CARRY_MASK;
+}
+
+
+// Records an op where Z comes from the result, and N/H/C are known.
+void FlagRegister::recordResult(uint8_t result, uint8_t other_flags)
+{
+	// Z of "result + 0" is just result == 0
+	op = ADD8;
+	lhs = result;
+	rhs = 0;
+	carry_in = false;
+
+	resolved = other_flags & ~ZERO_MASK;
+	pending = ZERO_MASK;
+}
+
+
+// Computes every flag the last op can produce, in F register layout
+uint8_t FlagRegister::computePending() const
+{
+	bool zero = false, half_carry = false, carry = false;
+
+	switch(op)
+	{
+	case ADD8:
+	{
+		unsigned int sum = lhs + rhs + carry_in;
+		zero = (sum & 0xFF) == 0;
+		half_carry = ((lhs & 0xF) + (rhs & 0xF) + carry_in) > 0xF;
+		carry = sum > 0xFF;
+		break;
+	}
+
+	case SUB8:
+	{
+		int dif = lhs - rhs - carry_in;
+		zero = (dif & 0xFF) == 0;
+		half_carry = ((lhs & 0xF) - (rhs & 0xF) - carry_in) < 0;
+		carry = dif < 0;
+		break;
+	}
+
+	case ADD16:
+	{
+		unsigned int sum = lhs + rhs;
+		half_carry = ((lhs & 0xFFF) + (rhs & 0xFFF)) > 0xFFF;
+		carry = sum > 0xFFFF;
+		break;
+	}
+	}
+
 	uint8_t output = 0;
 	output |= (zero << ZERO_POSITION);
-	output |= (subtract << SUBTRACT_POSITION);
 	output |= (half_carry << HALF_CARRY_POSITION);
 	output |= (carry << CARRY_POSITION);
 	return output;
 }
 
 
+// Writes every field into a save state one by one
+void FlagRegister::saveState(savestate::StateWriter& state) const
+{
+	state.write(resolved);
+	state.write(pending);
+	state.write((uint8_t)op);
+	state.write(lhs);
+	state.write(rhs);
+	state.write(carry_in);
+}
+
+
+// Reads back what saveState() wrote
+void FlagRegister::loadState(savestate::StateReader& state)
+{
+	uint8_t loaded_op = 0;
+
+	state.read(resolved);
+	state.read(pending);
+	state.read(loaded_op);
+	state.read(lhs);
+	state.read(rhs);
+	state.read(carry_in);
+
+	op = (LazyOp)loaded_op;
+}
+
+
+// Moves past what saveState() wrote without loading it
+void FlagRegister::checkState(savestate::StateReader& state) const
+{
+	uint8_t loaded_op = 0;
+	bool loaded_carry_in = false;
+
+	state.skip<decltype(resolved)>();
+	state.skip<decltype(pending)>();
+	state.read(loaded_op);
+	state.skip<decltype(lhs)>();
+	state.skip<decltype(rhs)>();
+	state.read(loaded_carry_in);
+
+	if(loaded_op > ADD16)
+	{
+		throw std::invalid_argument("Save state has a flag op that doesn't "
+									"exist.");
+	}
+}
+
+
 // Converts the flags into a byte (f register)
+uint8_t FlagRegister::flagsToByte() const
+{
+	if(!pending)
+	{
+		return resolved;
+	}
+
+	return resolved | (computePending() & pending);
+}
+
+
+// Converts a byte (f register) into flags
 void FlagRegister::byteToFlags(uint8_t f_reg)
 {
-	zero = (f_reg >> ZERO_POSITION) & 1;
-	subtract = (f_reg >> SUBTRACT_POSITION) & 1;
-	half_carry = (f_reg >> HALF_CARRY_POSITION) & 1;
-	carry = (f_reg >> CARRY_POSITION) & 1;
+	// The lower nibble of F is always zero
+	resolved = f_reg & 0xF0;
+	pending = 0;
 }
 
 // END FLAGREGISTER CLASS //
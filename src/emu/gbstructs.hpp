@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 12 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "../core.hpp"
+#include "savestate.hpp"
 
 namespace gbstructs
 {
@@ -48,30 +49,83 @@ namespace gbstructs
 
 
 
-	// The flag register is a set of 4 bools
+	// The flag register is evaluated lazily. ALU ops record their operands,
+	// and Z/N/H/C are only computed when something reads them.
 	class FlagRegister
 	{
 	public:
-		bool zero;
-		bool subtract;
-		bool half_carry;
-		bool carry;
-
 		static constexpr int ZERO_POSITION = 7;
 		static constexpr int SUBTRACT_POSITION = 6;
 		static constexpr int HALF_CARRY_POSITION = 5;
 		static constexpr int CARRY_POSITION = 4;
 
+		static constexpr uint8_t ZERO_MASK = 1 << ZERO_POSITION;
+		static constexpr uint8_t SUBTRACT_MASK = 1 << SUBTRACT_POSITION;
+		static constexpr uint8_t HALF_CARRY_MASK = 1 << HALF_CARRY_POSITION;
+		static constexpr uint8_t CARRY_MASK = 1 << CARRY_POSITION;
+
 		FlagRegister();
 
-		// Converts a byte (f register) into flag booleans
+		// Gets a flag, computing it from the last recorded op if needed
+		bool getZero() const;
+		bool getSubtract() const;
+		bool getHalfCarry() const;
+		bool getCarry() const;
+
+		// Sets the flags in mask to the matching bits of value.
+		// Flags outside of mask are unchanged.
+		void setMasked(uint8_t mask, uint8_t value);
+
+		// Records an 8-bit addition (a + b + carry_in). Sets Z, N, H, and C.
+		void recordAdd(uint8_t a, uint8_t b, bool carry_in);
+		// Records an 8-bit subtraction (a - b - carry_in). Sets Z, N, H, and C.
+		void recordSub(uint8_t a, uint8_t b, bool carry_in);
+		// Records an 8-bit increment of a. Sets Z, N, and H.
+		void recordInc(uint8_t a);
+		// Records an 8-bit decrement of a. Sets Z, N, and H.
+		void recordDec(uint8_t a);
+		// Records a 16-bit addition (a + b). Sets N, H, and C.
+		void recordAdd16(uint16_t a, uint16_t b);
+		// Records an op where Z comes from the result, and N/H/C are known.
+		// other_flags is in F register layout. Its Z bit is ignored.
+		void recordResult(uint8_t result, uint8_t other_flags);
+
+		// Converts a byte (f register) into flags
 		void byteToFlags(uint8_t f_reg);
 		// Converts the flags into a byte (f register)
-		uint8_t flagsToByte();
-	};
+		uint8_t flagsToByte() const;
+
+		// Writes every field into a save state one by one, so padding never
+		// ends up in it
+		void saveState(savestate::StateWriter& state) const;
+		// Reads back what saveState() wrote. Check it with checkState() first.
+		void loadState(savestate::StateReader& state);
+		// Moves past what saveState() wrote without loading it. Throws if the
+		// state is cut short or its op doesn't exist.
+		void checkState(savestate::StateReader& state) const;
+
+	private:
+		// The kinds of operations that can leave flags pending
+		enum LazyOp : uint8_t
+		{
+			ADD8,  // lhs + rhs + carry_in
+			SUB8,  // lhs - rhs - carry_in
+			ADD16, // lhs + rhs, H and C from bits 11 and 15
+		};
 
-	// Converts an instruction to a string
-	std::string instructionToString();
+		uint8_t resolved; // Flags that are already known, in F register layout
+		uint8_t pending; // Mask of flags that come from the last op
+
+		LazyOp op;
+		uint16_t lhs;
+		uint16_t rhs;
+		bool carry_in;
+
+		// Computes every flag the last op can produce, in F register layout
+		uint8_t computePending() const;
+		// Gets a single flag by its mask
+		bool getFlag(uint8_t mask) const;
+	};
 
 	// Used to generalize targets for instructions. Also useful for logging.
 	enum TargetID
@@ -83,20 +137,22 @@ namespace gbstructs
 		IMMEDIATE,
 	};
 
-	// Used almost entirely for logging. TargetIDs only slightly useful.
-	struct CPUInstruction
+	// Static information about a main opcode. Used for disassembly, and by
+	// the recompiler to budget cycles.
+	struct OpcodeInfo
 	{
-		std::string mnemonic;
-		TargetID target1; // To
-		TargetID target2; // From
-		bool t1_as_address; // Use target1 as an address
-		bool t2_as_address; // Use target2 as an address
-
-		uint16_t origin; // Original address
-		uint16_t opcode;
-		bool two_byte; // Opcodes beginning with CB are two bytes long
+		// fmt format string. {0} is the byte operand, {1} is the 16-bit
+		// operand, and {2} is the byte operand as a signed offset.
+		const char* format;
+		uint8_t length; // Length in bytes, including the opcode
+		// Most cycles it takes, with any branch taken. For 0xCB, the most
+		// any CB instruction takes.
+		uint8_t cycles;
 	};
 
+	// Info for every main opcode, indexed by opcode
+	extern const std::array<OpcodeInfo, 256> OPCODE_INFO;
+
 	// Used to indicate MBC controls and memory persistence
 	enum BankController
 	{
@@ -145,6 +201,6 @@ namespace gbstructs
 
 	// Creates a formatted string from a RegisterSet
 	std::string registerToString(RegisterSet regs);
-	// Creates a formatted string from a CPUInstruction
-	std::string instructionToString(CPUInstruction ins);
+	// Disassembles an instruction from its opcode and the two bytes after it
+	std::string disassemble(uint8_t opcode, uint8_t byte1, uint8_t byte2);
 }
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -13,11 +13,50 @@
 
 #include "gbsystem.hpp"
 
+// I/O registers the scheduled events drive, and DIV
+static constexpr uint16_t DIV_ADDRESS = 0xFF04;
+static constexpr uint16_t TIMA_ADDRESS = 0xFF05;
+static constexpr uint16_t TMA_ADDRESS = 0xFF06;
+static constexpr uint16_t TAC_ADDRESS = 0xFF07;
+static constexpr uint16_t IF_ADDRESS = 0xFF0F;
+static constexpr uint16_t LCDC_ADDRESS = 0xFF40;
+static constexpr uint16_t STAT_ADDRESS = 0xFF41;
+static constexpr uint16_t LY_ADDRESS = 0xFF44;
+static constexpr uint16_t LYC_ADDRESS = 0xFF45;
+
+// IF bits
+static constexpr uint8_t VBLANK_INTERRUPT = 0x01;
+static constexpr uint8_t STAT_INTERRUPT = 0x02;
+static constexpr uint8_t TIMER_INTERRUPT = 0x04;
+
+// DIV counts up every 256 cycles
+static constexpr uint64_t DIV_PERIOD = 256;
+// TIMA periods, indexed by the low two bits of TAC
+static constexpr std::array<uint64_t, 4> TIMER_PERIODS = {1024, 16, 64, 256};
+
+// PPU mode lengths. A scanline is always 456 cycles.
+static constexpr uint64_t OAM_SCAN_CYCLES = 80;     // Mode 2
+static constexpr uint64_t PIXEL_TRANSFER_CYCLES = 172; // Mode 3
+static constexpr uint64_t HBLANK_CYCLES = 204;      // Mode 0
+static constexpr uint64_t SCANLINE_CYCLES = 456;    // Mode 1 is whole lines
+static constexpr int VBLANK_FIRST_LINE = 144;
+static constexpr int LINE_AMOUNT = 154;
+// Not a STAT mode. Kept while the LCD is off, so turning it back on starts
+// the frame over from line 0's OAM scan.
+static constexpr int PPU_MODE_OFF = 4;
+
+const std::array<GBSystem::EventHandler, Scheduler::EVENT_TYPE_COUNT>
+		GBSystem::EVENT_HANDLERS = {
+	&GBSystem::onTimerTick, // TIMER_TICK
+	&GBSystem::onPPUMode,   // PPU_MODE
+};
+
 // Constructor
 GBSystem::GBSystem(const std::string& rom_path)
 {
 	internal_speed = 4194304; // GB always starts out in standard speed mode
-    cycles_per_frame = internal_speed / 59.7; // Close enough
+	// 154 scanlines of 456 cycles, about 59.73 frames a second
+	cycles_per_frame = SCANLINE_CYCLES * LINE_AMOUNT;
 
 	// Check if ROM file path exists and is accessible
 	if(!std::filesystem::exists(rom_path))
@@ -28,6 +67,25 @@ GBSystem::GBSystem(const std::string& rom_path)
 	rom_file_path = rom_path;
 
 	cart = std::make_unique<Cartridge>(rom_file_path, mem);
+
+	// Memory writes go in the same trace as the instructions making them
+	mem.setTracer(&cpu.getTracer());
+	// DIV is read off the cycle count
+	mem.setClock(&cycle_count);
+
+	// The boot ROM leaves the LCD on
+	mem.setIOReg(LCDC_ADDRESS, 0x91);
+
+	cycle_count = 0;
+	instruction_count = 0;
+	idle_cycle_count = 0;
+	run_target = 0;
+	ppu_mode = 2;
+	ppu_line = 0;
+
+	// TAC starts with the timer off, so only the PPU has an event
+	scheduleTimer();
+	scheduler.schedule(Scheduler::PPU_MODE, OAM_SCAN_CYCLES);
 }
 
 // Destructor
@@ -35,20 +93,66 @@ GBSystem::~GBSystem() = default;
 
 
 
-// Steps the system by one CPU instruction;
+// Steps the system by one CPU instruction
 void GBSystem::step()
 {
-	// Fetch
-	uint8_t opcode = mem.readByte(cpu.getShortReg(gbstructs::PC));
+	executeBlock(scheduler.nextEventCycle(), true);
+	dispatchEvents();
+}
 
-	// Decode/Execute
-	int cycles = cpu.execute(opcode, mem);
 
-	// Step other components
-	for(int i = 0; i < cycles; i++)
+// Runs CPU instructions until the next scheduled event, then handles it
+void GBSystem::runUntilNextEvent()
+{
+	// Only a TAC or DIV write can change the schedule before an event is
+	// handled. It ends the block, so the next event is read again after each.
+	while(cycle_count < scheduler.nextEventCycle())
 	{
-		// In terms of other components, we have no other components.
+		executeBlock(scheduler.nextEventCycle());
 	}
+
+	dispatchEvents();
+}
+
+
+// Runs the system as fast as the host allows for a number of cycles
+uint64_t GBSystem::runCycles(uint64_t cycles)
+{
+	// The longest instruction is 24 cycles, and a skipped idle loop iteration
+	// at most 32, so a run never ends further past its target than that.
+	// Anything more means step() ran in between, and the target catches back
+	// up to the present.
+	static constexpr uint64_t MAX_OVERSHOOT = 32;
+
+	uint64_t start_cycle = cycle_count;
+	if(cycle_count > run_target + MAX_OVERSHOOT)
+	{
+		run_target = cycle_count;
+	}
+	run_target += cycles;
+
+	while(cycle_count < run_target)
+	{
+		// Burst up to the next event or the end of the run, whichever is
+		// first. A timer write can bring the next event closer.
+		uint64_t stop_cycle = std::min(scheduler.nextEventCycle(), run_target);
+		while(cycle_count < stop_cycle)
+		{
+			executeBlock(stop_cycle);
+			stop_cycle = std::min(scheduler.nextEventCycle(), run_target);
+		}
+
+		dispatchEvents();
+	}
+
+	return cycle_count - start_cycle;
+}
+
+
+// Runs the system for one frame's worth of cycles
+uint64_t GBSystem::runFrame()
+{
+	return runCycles(cycles_per_frame);
 }
 
 
@@ -61,4 +165,504 @@ int GBSystem::getInternalSpeed()
 int GBSystem::getCyclesPerFrame()
 {
     return cycles_per_frame;
-}
\ No newline at end of file
+}
+
+
+uint64_t GBSystem::getCycleCount()
+{
+	return cycle_count;
+}
+
+
+uint64_t GBSystem::getInstructionCount()
+{
+	return instruction_count;
+}
+
+
+uint64_t GBSystem::getIdleCycleCount()
+{
+	return idle_cycle_count;
+}
+
+
+
+// Save States //
+
+// Serializes the whole system into buffer
+void GBSystem::saveState(std::vector<uint8_t>& buffer)
+{
+	buffer.clear();
+	savestate::StateWriter state(buffer);
+
+	savestate::StateHeader header = makeStateHeader();
+	state.write(header);
+
+	state.write(cycle_count);
+	state.write(instruction_count);
+	state.write(run_target);
+	state.write(ppu_mode);
+	state.write(ppu_line);
+
+	cpu.saveState(state);
+	mem.saveState(state);
+	ppu.saveState(state);
+	scheduler.saveState(state);
+
+	// Now that the size is known, patch it into the header
+	header.size = state.size();
+	std::memcpy(buffer.data(), &header, sizeof(header));
+}
+
+
+// Restores the system from a buffer made by saveState()
+void GBSystem::loadState(const std::vector<uint8_t>& buffer)
+{
+	savestate::StateReader state(buffer.data(), buffer.size());
+
+	savestate::StateHeader header{};
+	state.read(header);
+
+	// Check everything before touching the system, so a bad state can't
+	// leave it half loaded
+	savestate::StateHeader expected = makeStateHeader();
+	if(!std::equal(std::begin(savestate::MAGIC), std::end(savestate::MAGIC),
+				   header.magic))
+	{
+		throw std::invalid_argument("Not an ASCII-Boy save state.");
+	}
+	if(header.version != expected.version)
+	{
+		throw std::invalid_argument("Save state is from another version.");
+	}
+	if(header.rom_checksum != expected.rom_checksum
+	   || header.header_checksum != expected.header_checksum
+	   || header.rom_size != expected.rom_size)
+	{
+		throw std::invalid_argument("Save state is from another game.");
+	}
+	if(header.size != buffer.size())
+	{
+		throw std::invalid_argument("Save state is the wrong size.");
+	}
+
+	// Walk a copy of the reader over the rest, so the banks, ERAM size and
+	// total size are known to fit before anything is loaded
+	savestate::StateReader check = state;
+	check.skip<decltype(cycle_count)>();
+	check.skip<decltype(instruction_count)>();
+	check.skip<decltype(run_target)>();
+	check.skip<decltype(ppu_mode)>();
+	int line = 0;
+	check.read(line);
+	if(line < 0 || line >= LINE_AMOUNT)
+	{
+		throw std::invalid_argument("Save state has a line that doesn't "
+									"exist.");
+	}
+	cpu.checkState(check);
+	mem.checkState(check);
+	ppu.checkState(check);
+	scheduler.checkState(check);
+	if(check.remaining() != 0)
+	{
+		throw std::invalid_argument("Save state is the wrong size.");
+	}
+
+	state.read(cycle_count);
+	state.read(instruction_count);
+	state.read(run_target);
+	state.read(ppu_mode);
+	state.read(ppu_line);
+
+	cpu.loadState(state);
+	mem.loadState(state);
+	ppu.loadState(state);
+	scheduler.loadState(state);
+
+	// Memory changed underneath whatever loop was being watched
+	idle_loop = IdleLoop{};
+}
+
+
+// Builds the header identifying states of this version and game
+savestate::StateHeader GBSystem::makeStateHeader()
+{
+	savestate::StateHeader header{};
+	std::copy(std::begin(savestate::MAGIC), std::end(savestate::MAGIC),
+			  header.magic);
+	header.version = savestate::VERSION;
+
+	const RomImage& rom = *cart->getROMImage();
+	header.rom_checksum = emath::bytesToUShort(rom.data()[0x14E],
+											   rom.data()[0x14F]);
+	header.header_checksum = rom.data()[0x14D];
+	header.rom_size = rom.size();
+
+	return header;
+}
+
+
+
+// Event Dispatch //
+
+// Runs the handler of every event due by the current cycle
+void GBSystem::dispatchEvents()
+{
+	Scheduler::Event event{};
+	while(scheduler.popDue(cycle_count, event))
+	{
+		(this->*EVENT_HANDLERS[event.type])(event.cycle);
+	}
+}
+
+
+// Executes a cached block of CPU instructions and counts their cycles
+void GBSystem::executeBlock(uint64_t stop_cycle, bool single_step)
+{
+	cycle_count += cpu.handleInterrupts(mem);
+
+	// Only an interrupt wakes the CPU, and only events request those, so
+	// nothing happens until stop_cycle
+	if(cpu.isHalted())
+	{
+		uint64_t wake_cycle = std::max(stop_cycle, cycle_count + 4);
+		idle_cycle_count += wake_cycle - cycle_count;
+		cycle_count = wake_cycle;
+		return;
+	}
+
+	uint16_t pc = cpu.getShortReg(gbstructs::PC);
+
+	if(pc == idle_loop.start && idle_loop.is_idle
+	   && idle_loop.bank == getBankOf(pc))
+	{
+		uint8_t value = mem.peekByte(idle_loop.polled);
+		if(idle_loop.verified && value == idle_loop.value
+		   && skipIdleLoop(stop_cycle))
+		{
+			return;
+		}
+
+		idle_loop.started = true;
+		idle_loop.started_value = value;
+		idle_loop.started_cycle = cycle_count;
+		idle_loop.started_instruction = instruction_count;
+	}
+
+	// Any cycle budget of at least 1 runs one instruction
+	uint64_t max_cycles = 1;
+	if(!single_step && stop_cycle > cycle_count)
+	{
+		max_cycles = stop_cycle - cycle_count;
+	}
+
+	CPU::BlockResult result = cpu.executeBlock(mem, max_cycles);
+	cycle_count += result.cycles;
+	instruction_count += result.instructions;
+
+	if(mem.takeTimerWrite())
+	{
+		scheduleTimer();
+	}
+
+	// Every busy-wait loop ends in a conditional JR back to its start. A JR
+	// always ends a block, so it is the last instruction run.
+	if((result.last_opcode & 0xE7) == 0x20
+	   && cpu.getShortReg(gbstructs::PC) < result.last_pc)
+	{
+		onBackwardJump(result.last_pc);
+	}
+}
+
+
+// Skips whole iterations of the verified idle loop toward stop_cycle
+bool GBSystem::skipIdleLoop(uint64_t stop_cycle)
+{
+	// Events change what loops poll. DIV has none, but it only changes on
+	// its next edge, so that counts as one for a loop polling it.
+	uint64_t change_cycle = scheduler.nextEventCycle();
+	uint64_t end_cycle = stop_cycle;
+	if(idle_loop.polled == DIV_ADDRESS)
+	{
+		uint64_t div_edge = cycle_count + DIV_PERIOD
+							- mem.getDIVCounter() % DIV_PERIOD;
+		change_cycle = std::min(change_cycle, div_edge);
+		stop_cycle = std::min(stop_cycle, change_cycle);
+	}
+
+	if(stop_cycle <= cycle_count)
+	{
+		return false;
+	}
+
+	uint64_t remaining = stop_cycle - cycle_count;
+	uint64_t iterations = remaining / idle_loop.cycles;
+
+	// An iteration that straddles a change would only see it on the next
+	// pass anyway, since the poll is its first instruction. Anything else,
+	// like the end of a run, must not be passed by more than part of an
+	// iteration.
+	if(stop_cycle == change_cycle)
+	{
+		iterations = (remaining + idle_loop.cycles - 1) / idle_loop.cycles;
+
+		// A DIV edge isn't an event, so the one straddling it mustn't run
+		// past stop_cycle either
+		if(change_cycle != scheduler.nextEventCycle())
+		{
+			iterations = std::min(iterations, (end_cycle - cycle_count)
+											  / idle_loop.cycles);
+		}
+	}
+
+	if(iterations == 0)
+	{
+		return false;
+	}
+
+	uint64_t skipped = iterations * idle_loop.cycles;
+	cycle_count += skipped;
+	idle_cycle_count += skipped;
+	instruction_count += iterations * idle_loop.instructions;
+
+	return true;
+}
+
+
+// Checks the loop a backward JR at jr_address just closed
+void GBSystem::onBackwardJump(uint16_t jr_address)
+{
+	uint16_t start = cpu.getShortReg(gbstructs::PC);
+
+	// Code in RAM can change under the loop
+	if(start >= 0x8000)
+	{
+		return;
+	}
+
+	int bank = getBankOf(start);
+
+	if(start != idle_loop.start || bank != idle_loop.bank)
+	{
+		idle_loop = IdleLoop{};
+		idle_loop.start = start;
+		idle_loop.bank = bank;
+
+		// LDH A,(n), then CP n, AND n, AND A, or OR A, then the JR. A and the
+		// flags only depend on the byte read, and nothing is written.
+		if(mem.peekByte(start) != 0xF0)
+		{
+			return;
+		}
+		idle_loop.polled = 0xFF00 | mem.peekByte(start + 1);
+
+		uint16_t test = start + 2;
+		switch(mem.peekByte(test))
+		{
+		case 0xFE: // CP n
+		case 0xE6: // AND n
+			test += 2;
+			break;
+		case 0xA7: // AND A
+		case 0xB7: // OR A
+			test += 1;
+			break;
+		default:
+			return;
+		}
+
+		idle_loop.is_idle = test == jr_address;
+		return;
+	}
+
+	if(!idle_loop.is_idle || !idle_loop.started)
+	{
+		return;
+	}
+
+	// An iteration that started reading started_value came back around, so
+	// any later one reading the same value will too. One that took an
+	// interrupt along the way doesn't count.
+	uint64_t instructions = instruction_count - idle_loop.started_instruction;
+	idle_loop.started = false;
+	if(instructions != 3)
+	{
+		return;
+	}
+
+	idle_loop.verified = true;
+	idle_loop.value = idle_loop.started_value;
+	idle_loop.cycles = cycle_count - idle_loop.started_cycle;
+	idle_loop.instructions = instructions;
+}
+
+
+// Gets the ROM2 bank an address is in, or 0 outside ROM2
+int GBSystem::getBankOf(uint16_t address)
+{
+	return (address >= 0x4000 && address <= 0x7FFF) ? mem.getROM2Index() : 0;
+}
+
+
+// Sets a bit of IF
+void GBSystem::requestInterrupt(uint8_t mask)
+{
+	mem.setIOReg(IF_ADDRESS, mem.getIOReg(IF_ADDRESS) | mask);
+}
+
+
+// Schedules the next TIMER_TICK, or cancels it while the timer is off
+void GBSystem::scheduleTimer()
+{
+	uint8_t tac = mem.getIOReg(TAC_ADDRESS);
+
+	// A disabled timer can't raise an interrupt, so it doesn't wake HALT
+	if(!(tac & 0x04))
+	{
+		scheduler.cancel(Scheduler::TIMER_TICK);
+		return;
+	}
+
+	// TIMA counts on the DIV counter's edges, so the phase follows DIV resets
+	uint64_t period = TIMER_PERIODS[tac & 0x03];
+	scheduler.schedule(Scheduler::TIMER_TICK,
+					   cycle_count + period - mem.getDIVCounter() % period);
+}
+
+
+// TIMA increments at the rate TAC selects, and reloads from TMA on overflow
+void GBSystem::onTimerTick(uint64_t cycle)
+{
+	uint8_t tac = mem.getIOReg(TAC_ADDRESS);
+
+	// Writing TAC reschedules the timer, so it is always on here
+	uint8_t tima = mem.getIOReg(TIMA_ADDRESS) + 1;
+
+	if(tima == 0)
+	{
+		tima = mem.getIOReg(TMA_ADDRESS);
+		requestInterrupt(TIMER_INTERRUPT);
+	}
+
+	mem.setIOReg(TIMA_ADDRESS, tima);
+
+	scheduler.schedule(Scheduler::TIMER_TICK,
+					   cycle + TIMER_PERIODS[tac & 0x03]);
+}
+
+
+// Moves the PPU to its next mode: 2 -> 3 -> 0 per visible line, then 1 for
+// the VBlank lines
+void GBSystem::onPPUMode(uint64_t cycle)
+{
+	uint8_t stat = mem.getIOReg(STAT_ADDRESS);
+	uint64_t mode_cycles = 0;
+
+	// While the LCD is off, LY stays at 0 and the PPU only checks back each line
+	if(!(mem.getIOReg(LCDC_ADDRESS) & 0x80))
+	{
+		ppu_mode = PPU_MODE_OFF;
+		ppu_line = 0;
+		mem.setIOReg(LY_ADDRESS, 0);
+		mem.setIOReg(STAT_ADDRESS, stat & 0xF8);
+		mem.setOAMLocked(false);
+		mem.setVRAMLocked(false);
+		ppu.setLCDOff();
+
+		scheduler.schedule(Scheduler::PPU_MODE, cycle + SCANLINE_CYCLES);
+		return;
+	}
+
+	bool line_changed = false;
+
+	switch(ppu_mode)
+	{
+	case PPU_MODE_OFF: // LCD just turned on -> line 0's OAM scan
+	{
+		ppu_line = 0;
+		line_changed = true;
+		ppu_mode = 2;
+		mode_cycles = OAM_SCAN_CYCLES;
+		break;
+	}
+
+	case 2: // OAM scan -> pixel transfer
+	{
+		ppu_mode = 3;
+		mode_cycles = PIXEL_TRANSFER_CYCLES;
+		break;
+	}
+
+	case 3: // Pixel transfer -> HBlank
+	{
+		ppu.renderLine(ppu_line, mem);
+		ppu_mode = 0;
+		mode_cycles = HBLANK_CYCLES;
+		break;
+	}
+
+	case 0: // HBlank -> next line's OAM scan, or VBlank
+	{
+		ppu_line++;
+		line_changed = true;
+
+		if(ppu_line == VBLANK_FIRST_LINE)
+		{
+			ppu_mode = 1;
+			mode_cycles = SCANLINE_CYCLES;
+			requestInterrupt(VBLANK_INTERRUPT);
+			ppu.endFrame();
+		}
+		else
+		{
+			ppu_mode = 2;
+			mode_cycles = OAM_SCAN_CYCLES;
+		}
+		break;
+	}
+
+	case 1: // VBlank lines, then back to the top
+	default:
+	{
+		ppu_line++;
+		line_changed = true;
+
+		if(ppu_line == LINE_AMOUNT)
+		{
+			ppu_line = 0;
+			ppu_mode = 2;
+			mode_cycles = OAM_SCAN_CYCLES;
+		}
+		else
+		{
+			ppu_mode = 1;
+			mode_cycles = SCANLINE_CYCLES;
+		}
+		break;
+	}
+	}
+
+	// The PPU owns OAM from the scan on, and VRAM while pushing pixels
+	mem.setOAMLocked(ppu_mode == 2 || ppu_mode == 3);
+	mem.setVRAMLocked(ppu_mode == 3);
+
+	// STAT holds the mode in bits 0-1 and LY == LYC in bit 2
+	bool coincidence = ppu_line == mem.getIOReg(LYC_ADDRESS);
+	stat = (stat & 0xF8) | (coincidence ? 0x04 : 0x00) | ppu_mode;
+	mem.setIOReg(STAT_ADDRESS, stat);
+	mem.setIOReg(LY_ADDRESS, ppu_line);
+
+	// STAT bits 3-6 enable its interrupt for HBlank, VBlank, OAM scan and LYC
+	bool stat_interrupt = (ppu_mode == 0 && (stat & 0x08))
+						  || (ppu_mode == 1 && line_changed
+							  && ppu_line == VBLANK_FIRST_LINE && (stat & 0x10))
+						  || (ppu_mode == 2 && (stat & 0x20))
+						  || (line_changed && coincidence && (stat & 0x40));
+	if(stat_interrupt)
+	{
+		requestInterrupt(STAT_INTERRUPT);
+	}
+
+	scheduler.schedule(Scheduler::PPU_MODE, cycle + mode_cycles);
+}
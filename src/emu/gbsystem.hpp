@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -18,6 +18,8 @@
 #include "cpu.hpp"
 #include "mmu.hpp"
 #include "cart.hpp"
+#include "scheduler.hpp"
+#include "ppu.hpp"
 
 class GBSystem
 {
@@ -32,18 +34,114 @@ public:
 
 	CPU cpu;
 	MMU mem;
+	PPU ppu;
 	std::unique_ptr<Cartridge> cart;
 
-	// Steps the system by one CPU instruction
+	// Steps the system by one CPU instruction, then handles any events that
+	// came due
 	void step();
+	// Runs CPU instructions until the next scheduled event, then handles it
+	void runUntilNextEvent();
+	// Runs the system as fast as the host allows for a number of cycles.
+	// Returns the cycles actually run, which can be a few over or under so
+	// that consecutive runs stay lined up on whole instructions.
+	uint64_t runCycles(uint64_t cycles);
+	// Runs the system for one frame's worth of cycles
+	uint64_t runFrame();
 
     int getInternalSpeed();
     int getCyclesPerFrame();
+	// Gets the cycles run since the system started
+	uint64_t getCycleCount();
+	// Gets the instructions run since the system started
+	uint64_t getInstructionCount();
+	// Gets the cycles skipped over while halted or in a busy-wait loop
+	uint64_t getIdleCycleCount();
+
+	// Serializes the whole system into buffer, replacing its contents.
+	// Reusing the same buffer avoids allocating on every save.
+	void saveState(std::vector<uint8_t>& buffer);
+	// Restores the system from a buffer made by saveState(). Throws if it
+	// isn't a state of this version and game, leaving the system untouched.
+	void loadState(const std::vector<uint8_t>& buffer);
 
 private:
 	std::string rom_file_path; // Full file path for the GB ROM
 
 	int internal_speed; // The processor speed in Hz
-    int cycles_per_frame; // This might be incorrect
+    int cycles_per_frame; // Cycles between the start of one frame and the next
+
+	uint64_t cycle_count; // Absolute cycle, what the Scheduler is keyed on
+	uint64_t instruction_count;
+	// Where the last runCycles() meant to stop. The next run aims from here,
+	// so overshooting by part of an instruction doesn't add up over frames.
+	uint64_t run_target;
+	Scheduler scheduler;
+
+	// PPU timing. ppu renders each visible line as its pixel transfer ends.
+	int ppu_mode; // STAT mode, 0-3, or 4 while the LCD is off
+	int ppu_line; // LY
+
+	// Busy-wait loops, like LDH A,(n); CP n; JR NZ. The loop only does what
+	// it did last time until the byte it polls changes, and only events change
+	// it, so whole iterations can be skipped up to the next event.
+	// Only the most recent loop is remembered. Not saved, it is rebuilt by
+	// running.
+	struct IdleLoop
+	{
+		uint16_t start; // Address of the LDH
+		int bank; // ROM2 bank the loop is in, or 0 for ROM1
+		bool is_idle; // The loop matches a busy-wait idiom
+		uint16_t polled; // Address the LDH reads
+
+		// The iteration in progress
+		bool started;
+		uint8_t started_value;
+		uint64_t started_cycle;
+		uint64_t started_instruction;
+
+		// The last finished iteration. verified once there is one.
+		bool verified;
+		uint8_t value; // What the poll read, and kept the loop going
+		uint64_t cycles;
+		uint64_t instructions;
+	};
+	IdleLoop idle_loop{};
+	uint64_t idle_cycle_count;
+
+	// Builds the header identifying states of this version and game
+	savestate::StateHeader makeStateHeader();
+
+	// Event dispatch //
+
+	// Each handler gets the cycle its event was due on, and reschedules from
+	// that so that late dispatches don't drift
+	using EventHandler = void (GBSystem::*)(uint64_t cycle);
+	// Handlers indexed by Scheduler::EventType
+	static const std::array<EventHandler, Scheduler::EVENT_TYPE_COUNT>
+			EVENT_HANDLERS;
+
+	// Runs the handler of every event due by the current cycle
+	void dispatchEvents();
+	// Executes a cached block of CPU instructions up to about stop_cycle, or
+	// only one if single_step, and counts their cycles. While the CPU is
+	// halted or busy-waiting, skips ahead to about stop_cycle instead.
+	void executeBlock(uint64_t stop_cycle, bool single_step = false);
+	// Skips whole iterations of the verified idle loop toward stop_cycle, or
+	// DIV's next edge if it polls DIV. Returns false if not even one fits.
+	bool skipIdleLoop(uint64_t stop_cycle);
+	// Checks the loop a backward JR at jr_address just closed
+	void onBackwardJump(uint16_t jr_address);
+	// Gets the ROM2 bank an address is in, or 0 outside ROM2
+	int getBankOf(uint16_t address);
+	// Sets a bit of IF
+	void requestInterrupt(uint8_t mask);
+
+	// Schedules the next TIMER_TICK on the DIV counter edge TAC picks, or
+	// cancels it while TAC has the timer off
+	void scheduleTimer();
+
+	void onTimerTick(uint64_t cycle);
+	void onPPUMode(uint64_t cycle);
 
 };
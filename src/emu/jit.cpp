@@ -0,0 +1,359 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/jit.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Executable memory for the CPU's recompiler, and just enough of an x86-64
+ assembler to fill it.
+ ******************************************************************************/
+
+#include "jit.hpp"
+
+#include <cstring>
+
+using namespace x86;
+
+// Constructor
+CodeBuffer::CodeBuffer(size_t size)
+{
+	this->size = size;
+	used = 0;
+
+#ifdef _WIN32
+	memory = static_cast<uint8_t*>(VirtualAlloc(
+			nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+	void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+						 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	memory = mapping == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapping);
+#endif
+
+	if(memory == nullptr)
+	{
+		ASCIIBOY_LOG(ERRORS, "JIT: Could not allocate {} bytes of code memory.",
+					 size);
+		this->size = 0;
+	}
+}
+
+// Destructor
+CodeBuffer::~CodeBuffer()
+{
+	if(memory == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, size);
+#endif
+}
+
+
+
+// Gets if the memory could be allocated
+bool CodeBuffer::isValid() const
+{
+	return memory != nullptr;
+}
+
+// Gets how many bytes are left to emit into
+size_t CodeBuffer::getFree() const
+{
+	return size - used;
+}
+
+// Gets where the next byte will be emitted
+const uint8_t* CodeBuffer::getCursor() const
+{
+	return memory + used;
+}
+
+
+
+// Makes the buffer writable
+void CodeBuffer::beginWrite()
+{
+#ifdef _WIN32
+	DWORD old_protection = 0;
+	VirtualProtect(memory, size, PAGE_READWRITE, &old_protection);
+#else
+	mprotect(memory, size, PROT_READ | PROT_WRITE);
+#endif
+}
+
+// Makes the buffer executable again
+void CodeBuffer::endWrite()
+{
+#ifdef _WIN32
+	DWORD old_protection = 0;
+	VirtualProtect(memory, size, PAGE_EXECUTE_READ, &old_protection);
+	FlushInstructionCache(GetCurrentProcess(), memory, size);
+#else
+	mprotect(memory, size, PROT_READ | PROT_EXEC);
+#endif
+}
+
+// Drops everything emitted
+void CodeBuffer::reset()
+{
+	used = 0;
+}
+
+
+
+// Raw Bytes //
+
+void CodeBuffer::emit8(uint8_t value)
+{
+	if(used >= size)
+	{
+		throw std::runtime_error("JIT code buffer overflowed.");
+	}
+
+	memory[used++] = value;
+}
+
+void CodeBuffer::emit16(uint16_t value)
+{
+	emit8(value & 0xFF);
+	emit8(value >> 8);
+}
+
+void CodeBuffer::emit32(uint32_t value)
+{
+	emit16(value & 0xFFFF);
+	emit16(value >> 16);
+}
+
+void CodeBuffer::emit64(uint64_t value)
+{
+	emit32(value & 0xFFFFFFFF);
+	emit32(value >> 32);
+}
+
+// End Raw Bytes //
+
+
+
+// Encoding //
+
+// REX prefix for a reg field, base register, and operand width
+void CodeBuffer::rex(bool wide, int reg, int base)
+{
+	uint8_t prefix = 0x40;
+	if(wide) { prefix |= 0x08; }
+	if(reg & 8) { prefix |= 0x04; }
+	if(base & 8) { prefix |= 0x01; }
+
+	if(prefix != 0x40)
+	{
+		emit8(prefix);
+	}
+}
+
+// ModRM (and SIB) for [base + disp32]
+void CodeBuffer::modRMMem(int reg, Reg base, int32_t disp)
+{
+	emit8(0x80 | ((reg & 7) << 3) | (base & 7));
+
+	// RSP and R12 as a base can only be encoded through a SIB byte
+	if((base & 7) == RSP)
+	{
+		emit8(0x24);
+	}
+
+	emit32(disp);
+}
+
+// ModRM for a register operand
+void CodeBuffer::modRMReg(int reg, Reg rm)
+{
+	emit8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// End Encoding //
+
+
+
+// Instructions //
+
+void CodeBuffer::push(Reg reg)
+{
+	rex(false, 0, reg);
+	emit8(0x50 + (reg & 7));
+}
+
+void CodeBuffer::pop(Reg reg)
+{
+	rex(false, 0, reg);
+	emit8(0x58 + (reg & 7));
+}
+
+void CodeBuffer::ret()
+{
+	emit8(0xC3);
+}
+
+void CodeBuffer::movRegReg(Reg dst, Reg src)
+{
+	rex(true, src, dst);
+	emit8(0x89);
+	modRMReg(src, dst);
+}
+
+void CodeBuffer::movRegImm64(Reg reg, uint64_t value)
+{
+	rex(true, 0, reg);
+	emit8(0xB8 + (reg & 7));
+	emit64(value);
+}
+
+void CodeBuffer::movRegImm32(Reg reg, uint32_t value)
+{
+	rex(false, 0, reg);
+	emit8(0xB8 + (reg & 7));
+	emit32(value);
+}
+
+void CodeBuffer::movALMem8(Reg base, int32_t disp)
+{
+	rex(false, RAX, base);
+	emit8(0x8A);
+	modRMMem(RAX, base, disp);
+}
+
+void CodeBuffer::movMem8AL(Reg base, int32_t disp)
+{
+	rex(false, RAX, base);
+	emit8(0x88);
+	modRMMem(RAX, base, disp);
+}
+
+void CodeBuffer::movMem8Imm(Reg base, int32_t disp, uint8_t value)
+{
+	rex(false, 0, base);
+	emit8(0xC6);
+	modRMMem(0, base, disp);
+	emit8(value);
+}
+
+void CodeBuffer::movMem16Imm(Reg base, int32_t disp, uint16_t value)
+{
+	emit8(0x66); // Operand size prefix, before REX
+	rex(false, 0, base);
+	emit8(0xC7);
+	modRMMem(0, base, disp);
+	emit16(value);
+}
+
+void CodeBuffer::movMem32Imm(Reg base, int32_t disp, uint32_t value)
+{
+	rex(false, 0, base);
+	emit8(0xC7);
+	modRMMem(0, base, disp);
+	emit32(value);
+}
+
+void CodeBuffer::incMem16(Reg base, int32_t disp)
+{
+	emit8(0x66);
+	rex(false, 0, base);
+	emit8(0xFF);
+	modRMMem(0, base, disp);
+}
+
+void CodeBuffer::decMem16(Reg base, int32_t disp)
+{
+	emit8(0x66);
+	rex(false, 0, base);
+	emit8(0xFF);
+	modRMMem(1, base, disp);
+}
+
+void CodeBuffer::addRegImm32(Reg reg, uint32_t value)
+{
+	rex(false, 0, reg);
+	emit8(0x81);
+	modRMReg(0, reg);
+	emit32(value);
+}
+
+void CodeBuffer::addRegReg32(Reg dst, Reg src)
+{
+	rex(false, src, dst);
+	emit8(0x01);
+	modRMReg(src, dst);
+}
+
+void CodeBuffer::andRegImm32(Reg reg, uint32_t value)
+{
+	rex(false, 0, reg);
+	emit8(0x81);
+	modRMReg(4, reg);
+	emit32(value);
+}
+
+void CodeBuffer::subRSP(uint8_t value)
+{
+	emit8(0x48);
+	emit8(0x83);
+	modRMReg(5, RSP);
+	emit8(value);
+}
+
+void CodeBuffer::addRSP(uint8_t value)
+{
+	emit8(0x48);
+	emit8(0x83);
+	modRMReg(0, RSP);
+	emit8(value);
+}
+
+void CodeBuffer::testRegReg32(Reg a, Reg b)
+{
+	rex(false, b, a);
+	emit8(0x85);
+	modRMReg(b, a);
+}
+
+void CodeBuffer::callReg(Reg reg)
+{
+	rex(false, 0, reg);
+	emit8(0xFF);
+	modRMReg(2, reg);
+}
+
+size_t CodeBuffer::jmp32()
+{
+	emit8(0xE9);
+	size_t offset = used;
+	emit32(0);
+	return offset;
+}
+
+size_t CodeBuffer::jcc32(Condition condition)
+{
+	emit8(0x0F);
+	emit8(0x80 + condition);
+	size_t offset = used;
+	emit32(0);
+	return offset;
+}
+
+// Points a jump emitted earlier at the cursor
+void CodeBuffer::patchJump(size_t displacement_offset)
+{
+	int32_t displacement = (int32_t)(used - (displacement_offset + 4));
+	std::memcpy(memory + displacement_offset, &displacement,
+				sizeof(displacement));
+}
+
+// End Instructions //
@@ -0,0 +1,137 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/jit.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Executable memory for the CPU's recompiler, and just enough of an x86-64
+ assembler to fill it.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+
+// Builds with ASCIIBOY_JIT on an x86-64 host can recompile hot blocks.
+// Everywhere else, the CPU only interprets.
+#if defined(ASCIIBOY_JIT) && (defined(__x86_64__) || defined(_M_X64))
+#define ASCIIBOY_JIT_SUPPORTED
+#endif
+
+namespace x86
+{
+	enum Reg : uint8_t
+	{
+		RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15,
+	};
+
+	// Argument registers of the host calling convention
+#ifdef _WIN32
+	constexpr std::array<Reg, 4> ARG_REGS = {RCX, RDX, R8, R9};
+	// Space the caller reserves for the callee to spill its arguments
+	constexpr int SHADOW_SPACE = 32;
+#else
+	constexpr std::array<Reg, 4> ARG_REGS = {RDI, RSI, RDX, RCX};
+	constexpr int SHADOW_SPACE = 0;
+#endif
+
+	// Condition codes, as used by Jcc
+	enum Condition : uint8_t
+	{
+		COND_S = 0x8,  // Sign set
+		COND_NS = 0x9, // Sign clear
+	};
+}
+
+// A fixed-size block of memory that holds generated code. It is either
+// writable or executable, never both: emit between beginWrite() and
+// endWrite(), then run.
+class CodeBuffer
+{
+public:
+	explicit CodeBuffer(size_t size);
+	~CodeBuffer();
+
+	CodeBuffer(const CodeBuffer&) = delete;
+	CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+	// Gets if the memory could be allocated
+	bool isValid() const;
+	// Gets how many bytes are left to emit into
+	size_t getFree() const;
+	// Gets where the next byte will be emitted
+	const uint8_t* getCursor() const;
+
+	// Makes the buffer writable
+	void beginWrite();
+	// Makes the buffer executable again
+	void endWrite();
+	// Drops everything emitted. The buffer must be writable.
+	void reset();
+
+	// Raw bytes, little endian
+	void emit8(uint8_t value);
+	void emit16(uint16_t value);
+	void emit32(uint32_t value);
+	void emit64(uint64_t value);
+
+	// Instructions. Memory operands are always [base + disp32].
+	void push(x86::Reg reg);
+	void pop(x86::Reg reg);
+	void ret();
+	// mov dst, src (64-bit)
+	void movRegReg(x86::Reg dst, x86::Reg src);
+	// mov reg, imm64
+	void movRegImm64(x86::Reg reg, uint64_t value);
+	// mov reg32, imm32, which zero extends
+	void movRegImm32(x86::Reg reg, uint32_t value);
+	// mov al, [base + disp]
+	void movALMem8(x86::Reg base, int32_t disp);
+	// mov [base + disp], al
+	void movMem8AL(x86::Reg base, int32_t disp);
+	// mov byte [base + disp], imm8
+	void movMem8Imm(x86::Reg base, int32_t disp, uint8_t value);
+	// mov word [base + disp], imm16
+	void movMem16Imm(x86::Reg base, int32_t disp, uint16_t value);
+	// mov dword [base + disp], imm32
+	void movMem32Imm(x86::Reg base, int32_t disp, uint32_t value);
+	// inc word [base + disp] or dec word [base + disp]
+	void incMem16(x86::Reg base, int32_t disp);
+	void decMem16(x86::Reg base, int32_t disp);
+	// add reg32, imm32 and add dst32, src32
+	void addRegImm32(x86::Reg reg, uint32_t value);
+	void addRegReg32(x86::Reg dst, x86::Reg src);
+	// and reg32, imm32
+	void andRegImm32(x86::Reg reg, uint32_t value);
+	// sub rsp, imm8 and add rsp, imm8
+	void subRSP(uint8_t value);
+	void addRSP(uint8_t value);
+	// test reg32, reg32
+	void testRegReg32(x86::Reg a, x86::Reg b);
+	// call reg
+	void callReg(x86::Reg reg);
+	// Jumps with a 32-bit displacement, to be set with patchJump(). Return
+	// the offset of the displacement.
+	size_t jmp32();
+	size_t jcc32(x86::Condition condition);
+	// Points a jump emitted earlier at the cursor
+	void patchJump(size_t displacement_offset);
+
+private:
+	uint8_t* memory;
+	size_t size;
+	size_t used;
+
+	// REX prefix for a reg field, base register, and operand width. Skipped
+	// when nothing needs it.
+	void rex(bool wide, int reg, int base);
+	// ModRM (and SIB) for [base + disp32]
+	void modRMMem(int reg, x86::Reg base, int32_t disp);
+	// ModRM for a register operand
+	void modRMReg(int reg, x86::Reg rm);
+};
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 12 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -13,25 +13,56 @@
 
 #include "mmu.hpp"
 
+#include <cerrno>
+#include <cstring>
+
 // Constructor
 MMU::MMU()
 {
+	ROM1 = nullptr;
+	ROM2 = nullptr;
 	ROM2_index = 0;
 	ROM2_bank_amount = 0;
 	ERAM_index = 0;
 	ERAM_bank_amount = 0;
 	ERAM_persistent = false;
+	ERAM_data = nullptr;
+	SavMapping = nullptr;
+	ERAM_size = 0;
 	mbc = 0;
 	IEReg = 0;
+	block_break = false;
+	clock = nullptr;
+	div_reset_cycle = 0;
+	timer_written = false;
 
 	OAM_locked = false;
 	VRAM_locked = false;
+	tracer = nullptr;
+
+	save_sync_interval = std::chrono::milliseconds(1000);
+	last_save_sync = std::chrono::steady_clock::now();
+
+	layoutDirtyBits();
+
+	// Everything starts on the slow path, then the plain memory is mapped in
+	read_pages.fill(nullptr);
+	write_pages.fill(nullptr);
+	write_page_blocks.fill(0);
+
+	mapROM1();
+	mapROM2();
+	mapVRAM();
+	mapERAM();
+	mapWRAM();
 }
 
 // Destructor
 MMU::~MMU()
 {
-	SavFile.close();
+	// Make sure the last writes reach the disk before the mapping goes away
+	syncERAM(true);
+	unmapSavFile();
 }
 
 
@@ -41,6 +72,7 @@ MMU::~MMU()
 void MMU::setROM2Index(int index)
 {
 	ROM2_index = index;
+	mapROM2();
 }
 
 // Gets the current ROM2 bank
@@ -53,6 +85,7 @@ int MMU::getROM2Index()
 void MMU::setERAMIndex(int index)
 {
 	ERAM_index = index;
+	mapERAM();
 }
 
 // Gets the current ERAM bank
@@ -76,7 +109,14 @@ bool MMU::getOAMLocked()
 // Sets the VRAM_locked state
 void MMU::setVRAMLocked(bool value)
 {
+	// The PPU sets this on every mode change, so skip remapping if unchanged
+	if(value == VRAM_locked)
+	{
+		return;
+	}
+
 	VRAM_locked = value;
+	mapVRAM();
 }
 
 // Gets the VRAM_locked state
@@ -85,19 +125,19 @@ bool MMU::getVRAMLocked()
 	return VRAM_locked;
 }
 
-// Sets ROM1 to an array of bytes
-void MMU::setROM1(std::array<uint8_t, 0x4000>& bank)
+// Points ROM1 at a 16KB bank
+void MMU::setROM1(const uint8_t* bank)
 {
-	// Copy the passed bank into ROM1 so that the Cartridge can free its memory
-	std::copy(bank.begin(), bank.end(), ROM1.begin());
+	ROM1 = bank;
+	mapROM1();
 }
 
-// Sets ROM2 to a 2D array of bytes
-void MMU::setROM2(std::vector<std::array<uint8_t, 0x4000>>& banks,
-				  int bank_amount)
+// Points ROM2 at bank_amount back to back 16KB banks
+void MMU::setROM2(const uint8_t* banks, int bank_amount)
 {
 	ROM2 = banks;
 	ROM2_bank_amount = bank_amount;
+	mapROM2();
 }
 
 // Sets and initializes ERAM
@@ -106,57 +146,275 @@ void MMU::setERAM(int bank_amount,
 				  const std::string& sav_path,
 				  int mbc_id)
 {
+	// Flush and drop whatever a previous cartridge left behind, while the
+	// fields still describe its save
+	syncERAM(true);
+	unmapSavFile();
+
 	ERAM_bank_amount = bank_amount;
 	ERAM_persistent = persistent;
 	sav_file_path = sav_path;
 	mbc = mbc_id;
 
-	if(ERAM_persistent)
+	ERAM.clear();
+	ERAM_data = nullptr;
+	ERAM_size = ERAM_bank_amount > 0 ? ERAM_bank_amount * 0x2000 : 0;
+
+	// Whether the vector starts from the .sav file, if it ends up used
+	bool read_sav = ERAM_persistent;
+
+	if(ERAM_persistent && ERAM_size > 0)
 	{
-		// If persistent, open a .sav file for writing
+		switch(mapSavFile())
+		{
+		case SAV_MAPPED:
+		{
+			ERAM_data = SavMapping;
+			break;
+		}
 
-		// HACK: Figure out a better way to create the file if it doesn't exist.
-		std::ofstream temp(sav_file_path, std::fstream::out);
-		temp.close();
+		case SAV_IN_USE:
+		{
+			// Sharing the mapping would let every instance see the others'
+			// writes, and saving a copy would race the owner for the file
+			Logger::instance().log("MEM: .sav file is in use by another "
+								   "instance. This one gets a private copy "
+								   "that won't be saved.",
+								   Logger::VERBOSE);
+			ERAM_persistent = false;
+			break;
+		}
 
-		// Since this also uses the "in" flag, it will not create the file
-		SavFile.open(sav_file_path,
-					 std::fstream ::out
-					 | std::fstream::in
-					 | std::fstream::binary);
-		// Check to see that the file was created
-		if(!SavFile)
+		case SAV_FAILED:
 		{
-			Logger::instance().log("MEM: Could not open .sav file! "
-								   "Saves will not be permanent!",
+			Logger::instance().log("MEM: Could not map .sav file! "
+								   "Saves will only be written on sync.",
 								   Logger::ERRORS);
+			break;
 		}
+		}
+	}
 
-		// Ensure that the .sav file is the correct size
-		uint64_t target_size = ERAM_bank_amount * 0x2000;
-		if(SavFile && std::filesystem::file_size(sav_file_path) < target_size)
+	// Use the volatile memory if the memory isn't persistent or the .sav file
+	// could not be mapped.
+	if(ERAM_data == nullptr)
+	{
+		ERAM.assign(ERAM_size, 0);
+		ERAM_data = ERAM.data();
+
+		// Load the existing save so that the fallback still keeps progress
+		if(read_sav && std::filesystem::exists(sav_file_path))
 		{
-				std::filesystem::resize_file(sav_file_path, target_size);
+			std::ifstream sav(sav_file_path, std::ifstream::binary);
+			sav.read(reinterpret_cast<char*>(ERAM.data()), ERAM_size);
 		}
 	}
 
+	last_save_sync = std::chrono::steady_clock::now();
+	layoutDirtyBits();
+	mapERAM();
+}
 
-	// Use the volatile memory if the memory isn't persistent or the .sav file
-	// could not be opened/created.
-	if(!ERAM_persistent || !SavFile)
+// Sets how often persistent ERAM is flushed to its .sav file
+void MMU::setSaveSyncInterval(std::chrono::milliseconds interval)
+{
+	save_sync_interval = interval;
+}
+
+// Gets an I/O register $FF00-$FF7F
+uint8_t MMU::getIOReg(uint16_t address)
+{
+	if(address == 0xFF04)
 	{
-		for(int i = 0; i < ERAM_bank_amount; i++)
+		return (uint8_t)(getDIVCounter() >> 8);
+	}
+
+	return IOReg[(address - 0xFF00) & 0x7F];
+}
+
+// Sets an I/O register $FF00-$FF7F without CPU write side effects
+void MMU::setIOReg(uint16_t address, uint8_t value)
+{
+	IOReg[(address - 0xFF00) & 0x7F] = value;
+	markDirty(REGION_IOREG, 0);
+}
+
+// Gives the MMU the system's cycle counter
+void MMU::setClock(const uint64_t* cycle_count)
+{
+	clock = cycle_count;
+}
+
+// Gets the cycles counted since DIV was last reset
+uint64_t MMU::getDIVCounter() const
+{
+	return (clock ? *clock : 0) - div_reset_cycle;
+}
+
+// Gets the Interrupt Enable register $FFFF
+uint8_t MMU::getIEReg() const
+{
+	return IEReg;
+}
+
+// End SGetters //
+
+
+
+// Save Functions //
+
+// Flushes persistent ERAM to its .sav file
+void MMU::syncERAM(bool blocking)
+{
+	last_save_sync = std::chrono::steady_clock::now();
+
+	if(!ERAM_persistent || ERAM_size == 0)
+	{
+		return;
+	}
+
+	if(SavMapping != nullptr)
+	{
+#ifdef _WIN32
+		// Only starts the write back, Windows has no blocking form for a view
+		(void)blocking;
+		bool synced = FlushViewOfFile(SavMapping, ERAM_size) != 0;
+#else
+		bool synced = msync(SavMapping, ERAM_size,
+							blocking ? MS_SYNC : MS_ASYNC) == 0;
+#endif
+		if(!synced)
 		{
-			// Every bank is an array of 0x2000 bytes
-			std::array<uint8_t, 0x2000> bank{};
-			bank.fill(0);
-			ERAM.push_back(bank);
+			Logger::instance().log("MEM: Could not sync .sav file!",
+								   Logger::ERRORS);
 		}
+		return;
 	}
 
+	// Fallback, write the whole volatile ERAM out
+	std::ofstream sav(sav_file_path,
+					  std::ofstream::binary | std::ofstream::trunc);
+	sav.write(reinterpret_cast<const char*>(ERAM.data()), ERAM_size);
+	if(!sav)
+	{
+		Logger::instance().log("MEM: Could not write .sav file!",
+							   Logger::ERRORS);
+	}
 }
 
-// End SGetters //
+// Flushes persistent ERAM if the sync interval has passed
+void MMU::syncERAMIfDue()
+{
+	if(std::chrono::steady_clock::now() - last_save_sync >= save_sync_interval)
+	{
+		syncERAM(false);
+	}
+}
+
+// Maps the .sav file over ERAM_size bytes, and locks it for as long as it
+// stays mapped
+MMU::SavMapResult MMU::mapSavFile()
+{
+#ifdef _WIN32
+	// Not shared at all. The mapping keeps the file open, so nothing else can
+	// open it until it is unmapped.
+	HANDLE file = CreateFileA(sav_file_path.c_str(),
+							  GENERIC_READ | GENERIC_WRITE, 0,
+							  nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+							  nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return GetLastError() == ERROR_SHARING_VIOLATION ? SAV_IN_USE
+														 : SAV_FAILED;
+	}
+
+	// Mapping more than the file holds grows it to the ERAM size. A bigger
+	// save is left as it is.
+	HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+											 0, (DWORD)ERAM_size, nullptr);
+
+	// The mapping holds its own reference to the file
+	CloseHandle(file);
+
+	if(file_mapping == nullptr)
+	{
+		return SAV_FAILED;
+	}
+
+	void* mapping = MapViewOfFile(file_mapping, FILE_MAP_WRITE,
+								  0, 0, ERAM_size);
+
+	// And the view holds its own reference to the mapping
+	CloseHandle(file_mapping);
+
+	if(mapping == nullptr)
+	{
+		return SAV_FAILED;
+	}
+
+	SavMapping = static_cast<uint8_t*>(mapping);
+	return SAV_MAPPED;
+#else
+	int fd = open(sav_file_path.c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+	{
+		return SAV_FAILED;
+	}
+
+	// flock() locks belong to the open file, not the process, so this also
+	// keeps out other MMUs in this process. The mapping keeps the file open,
+	// so the lock lasts until it is unmapped.
+	if(flock(fd, LOCK_EX | LOCK_NB) != 0)
+	{
+		bool in_use = errno == EWOULDBLOCK;
+		close(fd);
+		return in_use ? SAV_IN_USE : SAV_FAILED;
+	}
+
+	// Grow the file to the ERAM size, never shrink a bigger save
+	struct stat info{};
+	if(fstat(fd, &info) != 0
+	   || ((size_t)info.st_size < ERAM_size && ftruncate(fd, ERAM_size) != 0))
+	{
+		close(fd);
+		return SAV_FAILED;
+	}
+
+	void* mapping = mmap(nullptr, ERAM_size,
+						 PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	// The mapping holds its own reference to the file
+	close(fd);
+
+	if(mapping == MAP_FAILED)
+	{
+		return SAV_FAILED;
+	}
+
+	SavMapping = static_cast<uint8_t*>(mapping);
+	return SAV_MAPPED;
+#endif
+}
+
+// Syncs and releases the .sav mapping
+void MMU::unmapSavFile()
+{
+	if(SavMapping == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(SavMapping);
+#else
+	munmap(SavMapping, ERAM_size);
+#endif
+	SavMapping = nullptr;
+	ERAM_data = nullptr;
+	mapERAM();
+}
+
+// End Save Functions //
 
 
 
@@ -173,43 +431,56 @@ uint8_t MMU::readByte(uint16_t address)
 // Reads a byte from memory, can ignore PPU locks
 uint8_t MMU::readByte(uint16_t address, bool is_ppu)
 {
-	Logger::instance().log(
-			fmt::format("MEM: Reading value from ${:04X}.",
-						address),
-			Logger::EXTREME);
+	ASCIIBOY_LOG(EXTREME, "MEM: Reading value from ${:04X}.", address);
 
+	// Plain memory is a single lookup
+	const uint8_t* page = read_pages[address >> 8];
+	if(page)
+	{
+		return page[address & 0xFF];
+	}
+
+	return readByteSlow(address, is_ppu);
+}
+
+
+
+// Reads a byte from a page that isn't in the page table
+uint8_t MMU::readByteSlow(uint16_t address, bool is_ppu)
+{
 	// Check for ECHO RAM
 	if(address >= 0xE000 && address <= 0xFDFF)
 	{
 		// Echos memory between $C000-$DDFF
 		uint16_t relative_address = address - 0x2000;
-		return readByte(relative_address, is_ppu);
+		return readByteSlow(relative_address, is_ppu);
 	}
 
 	// Check for unmapped memory
 	if(address >= 0xFEA0 && address <= 0xFEFF)
 	{
-		Logger::instance().log(
-				"MEM: Attempted read of undefined memory.",
-				Logger::DEBUG);
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted read of undefined memory.");
 		return 0xFF; // Usually returns 0xFF from the bus on hardware
 	}
 
 	// ROM1
 	if(address <= 0x3FFF)
 	{
-		return ROM1[address]; // Guaranteed to be in-bounds at compile time
+		if(ROM1 == nullptr)
+		{
+			return 0xFF; // No cartridge loaded
+		}
+
+		return ROM1[address]; // Always in-bounds, the Cartridge checks the size
 	}
 
 	// ROM2
 	if(address >= 0x4000 && address <= 0x7FFF)
 	{
 		// Bounds checking
-		if(ROM2_index < 0 || ROM2_index >= ROM2_bank_amount)
+		if(ROM2 == nullptr || ROM2_index < 0 || ROM2_index >= ROM2_bank_amount)
 		{
-			Logger::instance().log(
-					"MEM: Attempted read of invalid ROM2 bank.",
-					Logger::DEBUG);
+			ASCIIBOY_LOG(DEBUG, "MEM: Attempted read of invalid ROM2 bank.");
 
 			return 0xFF;
 		}
@@ -217,7 +488,7 @@ uint8_t MMU::readByte(uint16_t address, bool is_ppu)
 		uint16_t relative_address = address - 0x4000;
 		
 		// Read byte at address in bank
-		return ROM2[ROM2_index][relative_address];
+		return ROM2[ROM2_index * 0x4000 + relative_address];
 	}
 
 	// VRAM
@@ -240,9 +511,7 @@ uint8_t MMU::readByte(uint16_t address, bool is_ppu)
 		// Bounds checking
 		if(ERAM_index < 0 || ERAM_index >= ERAM_bank_amount)
 		{
-			Logger::instance().log(
-					"MEM: Attempted read of invalid ERAM bank.",
-					Logger::DEBUG);
+			ASCIIBOY_LOG(DEBUG, "MEM: Attempted read of invalid ERAM bank.");
 
 			return 0xFF;
 		}
@@ -276,9 +545,7 @@ uint8_t MMU::readByte(uint16_t address, bool is_ppu)
 	// IOReg
 	if(address >= 0xFF00 && address <= 0xFF7F)
 	{
-		uint16_t relative_address = address - 0xFF00;
-
-		return IOReg[relative_address];
+		return getIOReg(address);
 	}
 
 	// HRAM
@@ -297,7 +564,7 @@ uint8_t MMU::readByte(uint16_t address, bool is_ppu)
 
 	// This should not be an accessible branch.
 	Logger::instance().log(
-			"MEM: Invalid address provided to readByte()!",
+			"MEM: Invalid address provided to readByteSlow()!",
 			Logger::ERRORS);
 
 	return 0xFF;
@@ -315,46 +582,70 @@ void MMU::writeByte(uint16_t address, uint8_t value)
 // Writes a byte to memory, can ignore PPU locks
 void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 {
-	// TODO: Handle writes to ROM as MBC controls
+	ASCIIBOY_LOG(EXTREME, "MEM: Writing value 0x{:02X} to ${:04X}.",
+				 value, address);
 
-	Logger::instance().log(
-			fmt::format("MEM: Writing value 0x{:02X} to ${:04X}.",
-						value, address),
-			Logger::EXTREME);
+#ifdef ASCIIBOY_TRACE
+	if(tracer && !is_ppu)
+	{
+		tracer->recordWrite(address, value);
+	}
+#endif
+
+	// Plain memory is a single lookup
+	uint8_t* page = write_pages[address >> 8];
+	if(page)
+	{
+		page[address & 0xFF] = value;
+		markBlockDirty(write_page_blocks[address >> 8] + ((address >> 7) & 1));
+		return;
+	}
+
+	writeByteSlow(address, value, is_ppu);
+}
+
+
+
+// Writes a byte to a page that isn't in the page table
+void MMU::writeByteSlow(uint16_t address, uint8_t value, bool is_ppu)
+{
+	// TODO: Handle writes to ROM as MBC controls
 
 	// Check for ECHO RAM
 	if(address >= 0xE000 && address <= 0xFDFF)
 	{
 		// Echos memory between $C000-$DDFF
 		uint16_t relative_address = address - 0x2000;
-		writeByte(relative_address, value, is_ppu);
+		writeByteSlow(relative_address, value, is_ppu);
 		return;
 	}
 
+	// Writing over cached code. Only WRAM and HRAM pages are ever marked.
+	int page = address >> 8;
+	if(code_pages[page] && (address & 0xFF) >= code_first[page]
+	   && (address & 0xFF) <= code_last[page])
+	{
+		invalidateCode(page);
+	}
+
 	// Check for unmapped memory
 	if(address >= 0xFEA0 && address <= 0xFEFF)
 	{
-		Logger::instance().log(
-				"MEM: Attempted write of undefined memory.",
-				Logger::DEBUG);
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted write of undefined memory.");
 		return;
 	}
 
 	// ROM1
 	if(address <= 0x3FFF)
 	{
-		Logger::instance().log(
-				"MEM: Attempted write of ROM1.",
-				Logger::DEBUG);
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted write of ROM1.");
 		return;
 	}
 
 	// ROM2
 	if(address >= 0x4000 && address <= 0x7FFF)
 	{
-		Logger::instance().log(
-				"MEM: Attempted write of ROM2.",
-				Logger::DEBUG);
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted write of ROM2.");
 
 		return;
 	}
@@ -371,6 +662,13 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 		uint16_t relative_address = address - 0x8000;
 
 		VRAM[relative_address] = value;
+		markDirty(REGION_VRAM, relative_address);
+
+		int tile = relative_address / 16;
+		if(tile < TILE_AMOUNT)
+		{
+			dirty_tiles[tile / 64] |= 1ull << (tile % 64);
+		}
 		return;
 	}
 
@@ -380,9 +678,7 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 		// Bounds checking
 		if(ERAM_index < 0 || ERAM_index >= ERAM_bank_amount)
 		{
-			Logger::instance().log(
-					"MEM: Attempted write to invalid ERAM bank.",
-					Logger::DEBUG);
+			ASCIIBOY_LOG(DEBUG, "MEM: Attempted write to invalid ERAM bank.");
 
 			return;
 		}
@@ -399,6 +695,7 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 		uint16_t relative_address = address - 0xC000;
 
 		WRAM[relative_address] = value;
+		markDirty(REGION_WRAM, relative_address);
 		return;
 	}
 
@@ -414,6 +711,7 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 		uint16_t relative_address = address - 0xFE00;
 
 		OAM[relative_address] = value;
+		markDirty(REGION_OAM, relative_address);
 		return;
 	}
 
@@ -422,7 +720,31 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 	{
 		uint16_t relative_address = address - 0xFF00;
 
+		// Any write to DIV resets it, along with the timer's phase
+		if(address == 0xFF04)
+		{
+			value = 0;
+			div_reset_cycle = clock ? *clock : 0;
+			timer_written = true;
+		}
+
+		// The timer only has an event while TAC enables it. Changing it has
+		// to stop the CPU's current block, so the event can come before the
+		// block was meant to end.
+		if(address == 0xFF07)
+		{
+			timer_written = true;
+			block_break = true;
+		}
+
+		// Requesting an interrupt has to stop the CPU's current block
+		if(address == 0xFF0F)
+		{
+			block_break = true;
+		}
+
 		IOReg[relative_address] = value;
+		markDirty(REGION_IOREG, relative_address);
 		return;
 	}
 
@@ -432,6 +754,7 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 		uint16_t relative_address = address - 0xFF80;
 
 		HRAM[relative_address] = value;
+		markDirty(REGION_HRAM, relative_address);
 		return;
 	}
 
@@ -439,17 +762,185 @@ void MMU::writeByte(uint16_t address, uint8_t value, bool is_ppu)
 	if(address == 0xFFFF)
 	{
 		IEReg = value;
+		markDirty(REGION_HRAM, 0x7F);
+		block_break = true;
 		return;
 	}
 
 	// This should not be an accessible branch.
 	Logger::instance().log(
-			"MEM: Invalid address provided to writeByte()!",
+			"MEM: Invalid address provided to writeByteSlow()!",
 			Logger::ERRORS);
 }
 
 
 
+// Page Tables //
+
+// Points the page table entries from first_page at memory, or clears them
+void MMU::mapPages(std::array<const uint8_t*, PAGE_COUNT>& table,
+				   int first_page, int page_amount, const uint8_t* memory)
+{
+	for(int i = 0; i < page_amount; i++)
+	{
+		table[first_page + i] = memory ? memory + (i * PAGE_SIZE) : nullptr;
+	}
+}
+
+void MMU::mapPages(std::array<uint8_t*, PAGE_COUNT>& table,
+				   int first_page, int page_amount, uint8_t* memory)
+{
+	for(int i = 0; i < page_amount; i++)
+	{
+		table[first_page + i] = memory ? memory + (i * PAGE_SIZE) : nullptr;
+	}
+}
+
+// Points write_page_blocks from first_page at a region's blocks
+void MMU::mapDirtyBlocks(int first_page, int page_amount,
+						 Region region, size_t offset)
+{
+	uint32_t block = region_first_block[region] + offset / DIRTY_BLOCK_SIZE;
+	for(int i = 0; i < page_amount; i++)
+	{
+		write_page_blocks[first_page + i] =
+				block + i * (PAGE_SIZE / DIRTY_BLOCK_SIZE);
+	}
+}
+
+
+// ROM1 $0000-$3FFF. Writes are MBC controls, so they stay on the slow path.
+void MMU::mapROM1()
+{
+	mapPages(read_pages, 0x00, 0x40, ROM1);
+}
+
+
+// ROM2 $4000-$7FFF. Invalid banks read 0xFF through the slow path.
+void MMU::mapROM2()
+{
+	bool valid = ROM2 != nullptr
+				 && ROM2_index >= 0 && ROM2_index < ROM2_bank_amount;
+
+	mapPages(read_pages, 0x40, 0x40,
+			 valid ? ROM2 + ROM2_index * 0x4000 : nullptr);
+}
+
+
+// VRAM $8000-$9FFF. Unmapped while locked, so the CPU sees 0xFF. Writes to
+// tile data always take the slow path, to mark the tile dirty.
+void MMU::mapVRAM()
+{
+	uint8_t* memory = VRAM_locked ? nullptr : VRAM.data();
+	int tile_pages = TILE_AMOUNT * 16 / PAGE_SIZE;
+
+	mapPages(read_pages, 0x80, 0x20, memory);
+	mapPages(write_pages, 0x80, tile_pages, nullptr);
+	mapPages(write_pages, 0x80 + tile_pages, 0x20 - tile_pages,
+			 memory ? memory + tile_pages * PAGE_SIZE : nullptr);
+	mapDirtyBlocks(0x80, 0x20, REGION_VRAM, 0);
+}
+
+
+// ERAM $A000-$BFFF. Points straight into the .sav mapping when persistent.
+void MMU::mapERAM()
+{
+	bool valid = ERAM_index >= 0 && ERAM_index < ERAM_bank_amount;
+
+	uint8_t* memory = nullptr;
+	if(valid && ERAM_data != nullptr)
+	{
+		memory = ERAM_data + ERAM_index * 0x2000;
+		mapDirtyBlocks(0xA0, 0x20, REGION_ERAM, ERAM_index * 0x2000);
+	}
+
+	mapPages(read_pages, 0xA0, 0x20, memory);
+	mapPages(write_pages, 0xA0, 0x20, memory);
+}
+
+
+// WRAM $C000-$DFFF, and its echo at $E000-$FDFF
+void MMU::mapWRAM()
+{
+	mapPages(read_pages, 0xC0, 0x20, WRAM.data());
+	mapPages(write_pages, 0xC0, 0x20, WRAM.data());
+
+	// $FE00-$FEFF is OAM and unmapped memory, so the echo stops a page short
+	mapPages(read_pages, 0xE0, 0x1E, WRAM.data());
+	mapPages(write_pages, 0xE0, 0x1E, WRAM.data());
+
+	mapDirtyBlocks(0xC0, 0x20, REGION_WRAM, 0);
+	mapDirtyBlocks(0xE0, 0x1E, REGION_WRAM, 0);
+
+	// Pages with cached code stay on the slow path, echo included
+	for(int page = 0xC0; page <= 0xDF; page++)
+	{
+		if(code_pages[page])
+		{
+			write_pages[page] = nullptr;
+			if(page + 0x20 < 0xFE) { write_pages[page + 0x20] = nullptr; }
+		}
+	}
+}
+
+// End Page Tables //
+
+
+
+// Code Tracking //
+
+// Gets if code at an address can be cached
+bool MMU::isCodeCacheable(uint16_t address)
+{
+	return address <= 0x7FFF
+		   || (address >= 0xC000 && address <= 0xDFFF)
+		   || (address >= 0xFF80 && address <= 0xFFFE);
+}
+
+
+// Marks first to last, in one page of WRAM or HRAM, as cached code
+void MMU::protectCode(uint16_t first, uint16_t last)
+{
+	int page = first >> 8;
+	if(!code_pages[page])
+	{
+		code_pages[page] = true;
+		code_first[page] = first & 0xFF;
+		code_last[page] = last & 0xFF;
+
+		// HRAM's page is always on the slow path. WRAM's has an echo.
+		if(page >= 0xC0 && page <= 0xDF)
+		{
+			write_pages[page] = nullptr;
+			if(page + 0x20 < 0xFE) { write_pages[page + 0x20] = nullptr; }
+		}
+		return;
+	}
+
+	code_first[page] = std::min<uint8_t>(code_first[page], first & 0xFF);
+	code_last[page] = std::max<uint8_t>(code_last[page], last & 0xFF);
+}
+
+
+// Drops a page's cached code
+void MMU::invalidateCode(int page)
+{
+	code_generations[page]++;
+	code_pages[page] = false;
+	block_break = true;
+
+	if(page >= 0xC0 && page <= 0xDF)
+	{
+		uint8_t* memory = WRAM.data() + (page - 0xC0) * PAGE_SIZE;
+		write_pages[page] = memory;
+		if(page + 0x20 < 0xFE) { write_pages[page + 0x20] = memory; }
+	}
+}
+
+// End Code Tracking //
+
+
+
 // Reads a byte from memory, without logging. For dumping memory.
 inline uint8_t MMU::getByte(uint16_t address)
 {
@@ -470,14 +961,19 @@ inline uint8_t MMU::getByte(uint16_t address)
 	// ROM1
 	if(address <= 0x3FFF)
 	{
-		return ROM1[address]; // Guaranteed to be in-bounds at compile time
+		if(ROM1 == nullptr)
+		{
+			return 0xFF; // No cartridge loaded
+		}
+
+		return ROM1[address]; // Always in-bounds, the Cartridge checks the size
 	}
 
 	// ROM2
 	if(address >= 0x4000 && address <= 0x7FFF)
 	{
 		// Bounds checking
-		if(ROM2_index < 0 || ROM2_index >= ROM2_bank_amount)
+		if(ROM2 == nullptr || ROM2_index < 0 || ROM2_index >= ROM2_bank_amount)
 		{
 			return 0x00;
 		}
@@ -485,7 +981,7 @@ inline uint8_t MMU::getByte(uint16_t address)
 		uint16_t relative_address = address - 0x4000;
 		
 		// Read byte at address in bank
-		return ROM2[ROM2_index][relative_address];
+		return ROM2[ROM2_index * 0x4000 + relative_address];
 	}
 
 	// VRAM
@@ -528,9 +1024,7 @@ inline uint8_t MMU::getByte(uint16_t address)
 	// IOReg
 	if(address >= 0xFF00 && address <= 0xFF7F)
 	{
-		uint16_t relative_address = address - 0xFF00;
-
-		return IOReg[relative_address];
+		return getIOReg(address);
 	}
 
 	// HRAM
@@ -557,27 +1051,280 @@ inline uint8_t MMU::getByte(uint16_t address)
 
 
 
-// Reads a byte from external RAM
-uint8_t MMU::readERAMByte(int bank, uint16_t address)
+// Writes every RAM region, bank index, and lock into a save state
+void MMU::saveState(savestate::StateWriter& state) const
 {
-	if(bank > ERAM_bank_amount)
+	state.write(ROM2_index);
+	state.write(ERAM_index);
+	state.write(VRAM);
+	state.write(WRAM);
+	state.write(OAM);
+	state.write(IOReg);
+	state.write(HRAM);
+	state.write(IEReg);
+	state.write(OAM_locked);
+	state.write(VRAM_locked);
+	state.write(div_reset_cycle);
+
+	// Battery-backed ERAM too, so a loaded state sees its own save data
+	uint32_t eram_size = ERAM_size;
+	state.write(eram_size);
+	if(ERAM_size > 0)
 	{
-		Logger::instance().log("MEM: Attempted read of invalid ERAM bank.",
-							   Logger::DEBUG);
-		return 0xFF;
+		state.writeBytes(ERAM_data, ERAM_size);
 	}
+}
 
-	// If persistent, read from the SAV file
-	if(ERAM_persistent && SavFile)
+// Reads back what saveState() wrote
+void MMU::loadState(savestate::StateReader& state)
+{
+	state.read(ROM2_index);
+	state.read(ERAM_index);
+	state.read(VRAM);
+	state.read(WRAM);
+	state.read(OAM);
+	state.read(IOReg);
+	state.read(HRAM);
+	state.read(IEReg);
+	state.read(OAM_locked);
+	state.read(VRAM_locked);
+	state.read(div_reset_cycle);
+
+	// checkState() already made sure it matches
+	state.skip<uint32_t>();
+	if(ERAM_size > 0)
 	{
-		int absolute_address = bank * address;
+		state.readBytes(ERAM_data, ERAM_size);
+	}
 
-		SavFile.seekg(absolute_address);
-		return SavFile.get();
+	// Everything may have changed
+	markAllDirty();
+	for(int page = 0; page < PAGE_COUNT; page++)
+	{
+		if(code_pages[page]) { invalidateCode(page); }
 	}
 
-	// Otherwise, read from the vector
-	return ERAM[bank][address];
+	// Banks and locks changed underneath the page tables
+	mapROM2();
+	mapVRAM();
+	mapERAM();
+}
+
+// Moves past what saveState() wrote without loading it, checking that it
+// fits this cartridge
+void MMU::checkState(savestate::StateReader& state) const
+{
+	// 0 is where the MMU starts, so it is fine even with no banks
+	int rom2_index = 0;
+	int eram_index = 0;
+	bool loaded_lock = false;
+	state.read(rom2_index);
+	state.read(eram_index);
+	if(rom2_index < 0 || (rom2_index >= ROM2_bank_amount && rom2_index != 0)
+	   || eram_index < 0 || (eram_index >= ERAM_bank_amount && eram_index != 0))
+	{
+		throw std::invalid_argument("Save state has a bank that doesn't "
+									"exist.");
+	}
+
+	state.skip<decltype(VRAM)>();
+	state.skip<decltype(WRAM)>();
+	state.skip<decltype(OAM)>();
+	state.skip<decltype(IOReg)>();
+	state.skip<decltype(HRAM)>();
+	state.skip<decltype(IEReg)>();
+	state.read(loaded_lock); // OAM_locked
+	state.read(loaded_lock); // VRAM_locked
+	state.skip<decltype(div_reset_cycle)>();
+
+	uint32_t eram_size = 0;
+	state.read(eram_size);
+	if(eram_size != ERAM_size)
+	{
+		throw std::invalid_argument("Save state ERAM size doesn't match.");
+	}
+	state.skipBytes(ERAM_size);
+}
+
+
+
+// Dirty Tracking //
+
+// Gets a region's memory
+const uint8_t* MMU::getRegionData(Region region) const
+{
+	switch(region)
+	{
+		case REGION_VRAM: return VRAM.data();
+		case REGION_ERAM: return ERAM_data;
+		case REGION_WRAM: return WRAM.data();
+		case REGION_OAM: return OAM.data();
+		case REGION_IOREG: return IOReg.data();
+		case REGION_HRAM: return HRAM.data();
+		default: break;
+	}
+
+	throw std::invalid_argument("Invalid memory region.");
+}
+
+// Gets a region's size in bytes
+size_t MMU::getRegionSize(Region region) const
+{
+	switch(region)
+	{
+		case REGION_VRAM: return VRAM.size();
+		case REGION_ERAM: return ERAM_size;
+		case REGION_WRAM: return WRAM.size();
+		case REGION_OAM: return OAM.size();
+		case REGION_IOREG: return IOReg.size();
+		case REGION_HRAM: return HRAM.size();
+		default: break;
+	}
+
+	throw std::invalid_argument("Invalid memory region.");
+}
+
+// Gets how many dirty blocks a region is split into
+size_t MMU::getBlockAmount(Region region) const
+{
+	return region_block_amount.at(region);
+}
+
+
+
+// Gets if any block of a region was written since it was last cleared
+bool MMU::isDirty(Region region) const
+{
+	for(size_t i = 0; i < getBlockAmount(region); i++)
+	{
+		if(isBlockDirty(region, i))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Gets if one block of a region was written since it was last cleared
+bool MMU::isBlockDirty(Region region, size_t block) const
+{
+	if(block >= getBlockAmount(region))
+	{
+		throw std::invalid_argument("Dirty block is out of range.");
+	}
+
+	uint32_t bit = region_first_block[region] + block;
+	return (dirty_bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+// Replaces blocks with the index of every dirty block in a region
+void MMU::getDirtyBlocks(Region region, std::vector<size_t>& blocks) const
+{
+	blocks.clear();
+	for(size_t i = 0; i < getBlockAmount(region); i++)
+	{
+		if(isBlockDirty(region, i))
+		{
+			blocks.push_back(i);
+		}
+	}
+}
+
+// Clears every dirty bit
+void MMU::clearDirty()
+{
+	std::fill(dirty_bits.begin(), dirty_bits.end(), 0);
+}
+
+// Clears the dirty bits of one region
+void MMU::clearDirty(Region region)
+{
+	uint32_t first = region_first_block.at(region);
+	for(uint32_t bit = first; bit < first + region_block_amount[region]; bit++)
+	{
+		dirty_bits[bit >> 6] &= ~(1ull << (bit & 63));
+	}
+}
+
+// Sets every dirty bit
+void MMU::markAllDirty()
+{
+	std::fill(dirty_bits.begin(), dirty_bits.end(), ~0ull);
+	dirty_tiles.fill(~0ull);
+}
+
+
+// Moves the bits of every VRAM tile written since the last call into tiles
+void MMU::takeDirtyTiles(std::array<uint64_t, TILE_AMOUNT / 64>& tiles)
+{
+	tiles = dirty_tiles;
+	dirty_tiles.fill(0);
+}
+
+
+
+// Numbers every region's blocks and resizes the bitmap
+void MMU::layoutDirtyBits()
+{
+	// ERAM goes last, since it is the only region that changes size
+	const Region order[REGION_COUNT] = {
+		REGION_VRAM, REGION_WRAM, REGION_OAM,
+		REGION_IOREG, REGION_HRAM, REGION_ERAM,
+	};
+
+	uint32_t block = 0;
+	for(Region region : order)
+	{
+		size_t size = getRegionSize(region);
+
+		region_first_block[region] = block;
+		region_block_amount[region] =
+				(size + DIRTY_BLOCK_SIZE - 1) / DIRTY_BLOCK_SIZE;
+		block += region_block_amount[region];
+	}
+
+	dirty_bits.assign((block + 63) / 64, 0);
+	markAllDirty();
+}
+
+// Sets the dirty bit of the block at offset bytes into a region
+void MMU::markDirty(Region region, size_t offset)
+{
+	markBlockDirty(region_first_block[region] + offset / DIRTY_BLOCK_SIZE);
+}
+
+// End Dirty Tracking //
+
+
+
+// Sets the Tracer that CPU writes are recorded to
+void MMU::setTracer(Tracer* new_tracer)
+{
+	tracer = new_tracer;
+}
+
+
+
+// Reads a byte without logging or PPU locks. For debuggers and tracing.
+uint8_t MMU::peekByte(uint16_t address)
+{
+	return getByte(address);
+}
+
+
+
+// Reads a byte from external RAM
+uint8_t MMU::readERAMByte(int bank, uint16_t address)
+{
+	if(bank < 0 || bank >= ERAM_bank_amount || ERAM_data == nullptr)
+	{
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted read of invalid ERAM bank.");
+		return 0xFF;
+	}
+
+	// Either the .sav mapping or the vector, both are plain memory
+	return ERAM_data[bank * 0x2000 + address];
 }
 
 
@@ -585,25 +1332,165 @@ uint8_t MMU::readERAMByte(int bank, uint16_t address)
 // Writes a byte to external RAM
 void MMU::writeERAMByte(int bank, uint16_t address, uint8_t value)
 {
-	if(bank > ERAM_bank_amount)
+	if(bank < 0 || bank >= ERAM_bank_amount || ERAM_data == nullptr)
 	{
-		Logger::instance().log("MEM: Attempted write of invalid ERAM bank.",
-							   Logger::DEBUG);
+		ASCIIBOY_LOG(DEBUG, "MEM: Attempted write of invalid ERAM bank.");
 		return;
 	}
 
-	// If persistent, write to the SAV file
-	if(ERAM_persistent && SavFile)
+	// Either the .sav mapping or the vector, both are plain memory
+	ERAM_data[bank * 0x2000 + address] = value;
+	markDirty(REGION_ERAM, bank * 0x2000 + address);
+}
+
+
+
+// Dump Functions //
+
+namespace
+{
+	constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+	// Both hex digits of every byte value, so formatting a byte is one lookup
+	struct HexTable
 	{
-		int absolute_address = bank * address;
+		char digits[256][2];
 
-		SavFile.seekp(absolute_address);
-		SavFile.put((char)(value));
-		return;
+		constexpr HexTable() : digits()
+		{
+			for(int i = 0; i < 256; i++)
+			{
+				digits[i][0] = HEX_DIGITS[i >> 4];
+				digits[i][1] = HEX_DIGITS[i & 0xF];
+			}
+		}
+	};
+	constexpr HexTable HEX_TABLE{};
+
+	constexpr char DUMP_HEADER[] = "--BEGIN MEMORY DUMP--\n";
+	constexpr char DUMP_FOOTER[] = "\n\n--END MEMORY DUMP--";
+	constexpr size_t DUMP_LINE_BYTES = 32;
+	// "\n$XXXX " before every line
+	constexpr size_t DUMP_LABEL_SIZE = 7;
+	// Room on the stack for dumps written to a file descriptor
+	constexpr size_t DUMP_CHUNK_SIZE = 4096;
+
+	// Writes all of data to a file descriptor. Returns false on an error.
+	bool writeAll(int fd, const char* data, size_t size)
+	{
+		while(size > 0)
+		{
+#ifdef _WIN32
+			int written = _write(fd, data, (unsigned int)size);
+#else
+			ssize_t written = write(fd, data, size);
+#endif
+			if(written < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+
+			data += written;
+			size -= written;
+		}
+
+		return true;
 	}
 
-	// Otherwise, write to the vector
-	ERAM[bank][address] = value;
+	// Collects dump output in a fixed buffer. With a file descriptor the
+	// buffer is written out and reused whenever it fills, otherwise whatever
+	// doesn't fit is dropped.
+	class DumpWriter
+	{
+	public:
+		DumpWriter(char* buffer, size_t capacity, int fd)
+				: buffer(buffer), capacity(capacity), used(0), fd(fd),
+				  failed(false) {}
+
+		void put(const char* data, size_t size)
+		{
+			while(size > 0)
+			{
+				if(used == capacity && (fd < 0 || !flush()))
+				{
+					failed = true;
+					return;
+				}
+
+				size_t amount = std::min(size, capacity - used);
+				std::memcpy(buffer + used, data, amount);
+				used += amount;
+				data += amount;
+				size -= amount;
+			}
+		}
+
+		// Writes out what is buffered. Returns false if anything failed.
+		bool flush()
+		{
+			if(fd >= 0)
+			{
+				if(!writeAll(fd, buffer, used))
+				{
+					failed = true;
+				}
+				used = 0;
+			}
+
+			return !failed;
+		}
+
+		// Gets how much of the buffer is used
+		size_t size() const { return used; }
+
+	private:
+		char* buffer;
+		size_t capacity;
+		size_t used;
+		int fd;
+		bool failed;
+	};
+
+	// Writes amount bytes from read() as hex lines. Lines are labelled from
+	// label_first, and break on the same 32-byte boundaries as a full dump.
+	template<typename ByteReader>
+	void writeHexDump(DumpWriter& output, uint32_t label_first, size_t amount,
+					  int label_digits, ByteReader read)
+	{
+		output.put(DUMP_HEADER, sizeof(DUMP_HEADER) - 1);
+
+		char line[DUMP_LABEL_SIZE + 1 + DUMP_LINE_BYTES * 3];
+		size_t i = 0;
+		while(i < amount)
+		{
+			size_t length = 0;
+			line[length++] = '\n';
+			line[length++] = '$';
+
+			uint32_t label = label_first + i;
+			for(int digit = label_digits - 1; digit >= 0; digit--)
+			{
+				line[length++] = HEX_DIGITS[(label >> (digit * 4)) & 0xF];
+			}
+			line[length++] = ' ';
+
+			do {
+				const char* digits = HEX_TABLE.digits[read(i)];
+				line[length++] = digits[0];
+				line[length++] = digits[1];
+				line[length++] = ' ';
+				i++;
+			} while(i < amount && (label_first + i) % DUMP_LINE_BYTES != 0);
+
+			output.put(line, length);
+		}
+
+		output.put(DUMP_FOOTER, sizeof(DUMP_FOOTER) - 1);
+	}
 }
 
 
@@ -611,25 +1498,117 @@ void MMU::writeERAMByte(int bank, uint16_t address, uint8_t value)
 // Dumps the entire memory address space into a formatted string.
 std::string MMU::dumpMemory()
 {
-	std::string output{};
+	std::string output(getDumpSize(DUMP_HEX), '\0');
+	output.resize(dumpMemory(output.data(), output.size(), DUMP_HEX));
 
-	output.append("--BEGIN MEMORY DUMP--\n");
+	return output;
+}
 
-	// Iterate through entire address space
-	for(int i = 0; i <= 0xFFFF; i++)
+// Dumps addresses first to last into output
+size_t MMU::dumpMemory(char* output, size_t output_size, DumpFormat format,
+					   uint16_t first, uint16_t last)
+{
+	if(first > last)
 	{
-		// Add newline and address every 32 bytes
-		if(i % 32 == 0)
+		return 0;
+	}
+
+	DumpWriter writer(output, output_size, -1);
+	size_t amount = last - first + 1;
+
+	if(format == DUMP_HEX)
+	{
+		writeHexDump(writer, first, amount, 4,
+					 [&](size_t i) { return getByte(first + i); });
+	}
+	else
+	{
+		for(size_t i = 0; i < amount; i++)
 		{
-			output.append( fmt::format("\n${:04X} ", i) );
+			char value = (char)getByte(first + i);
+			writer.put(&value, 1);
 		}
+	}
+
+	return writer.size();
+}
 
-		uint8_t value = getByte(i);
-		// Format data as hexadecimal number
-		output.append( fmt::format("{:02X} ", value) );
+// Writes a dump of addresses first to last to a file descriptor
+bool MMU::dumpMemory(int fd, DumpFormat format, uint16_t first, uint16_t last)
+{
+	if(first > last)
+	{
+		return false;
 	}
 
-	output.append("\n\n--END MEMORY DUMP--");
+	char chunk[DUMP_CHUNK_SIZE];
+	DumpWriter writer(chunk, sizeof(chunk), fd);
+	size_t amount = last - first + 1;
 
-	return output;
+	if(format == DUMP_HEX)
+	{
+		writeHexDump(writer, first, amount, 4,
+					 [&](size_t i) { return getByte(first + i); });
+	}
+	else
+	{
+		// Goes through getByte() a line at a time, for the banks and echo RAM
+		char line[DUMP_LINE_BYTES];
+		for(size_t i = 0; i < amount; i += DUMP_LINE_BYTES)
+		{
+			size_t length = std::min(DUMP_LINE_BYTES, amount - i);
+			for(size_t j = 0; j < length; j++)
+			{
+				line[j] = (char)getByte(first + i + j);
+			}
+			writer.put(line, length);
+		}
+	}
+
+	return writer.flush();
 }
+
+// Writes a dump of a whole region to a file descriptor
+bool MMU::dumpRegion(int fd, Region region, DumpFormat format)
+{
+	const uint8_t* data = getRegionData(region);
+	size_t size = data ? getRegionSize(region) : 0;
+
+	char chunk[DUMP_CHUNK_SIZE];
+	DumpWriter writer(chunk, sizeof(chunk), fd);
+
+	if(format == DUMP_HEX)
+	{
+		// Every ERAM bank together can take more than four digits
+		int label_digits = size > 0x10000 ? 5 : 4;
+		writeHexDump(writer, 0, size, label_digits,
+					 [&](size_t i) { return data[i]; });
+	}
+	else
+	{
+		writer.put(reinterpret_cast<const char*>(data), size);
+	}
+
+	return writer.flush();
+}
+
+// Gets how many bytes dumping addresses first to last takes
+size_t MMU::getDumpSize(DumpFormat format, uint16_t first, uint16_t last)
+{
+	if(first > last)
+	{
+		return 0;
+	}
+
+	size_t amount = last - first + 1;
+	if(format == DUMP_BINARY)
+	{
+		return amount;
+	}
+
+	size_t lines = (last / DUMP_LINE_BYTES) - (first / DUMP_LINE_BYTES) + 1;
+	return (sizeof(DUMP_HEADER) - 1) + (sizeof(DUMP_FOOTER) - 1)
+		   + lines * DUMP_LABEL_SIZE + amount * 3;
+}
+
+// End Dump Functions //
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -15,10 +15,37 @@
 
 #include "../core.hpp"
 #include "gbstructs.hpp"
+#include "tracer.hpp"
+#include "savestate.hpp"
 
 class MMU
 {
 public:
+	// The writable memory regions, as tracked by the dirty bitmap
+	enum Region : uint8_t
+	{
+		REGION_VRAM = 0,
+		REGION_ERAM,  // Every bank, back to back
+		REGION_WRAM,
+		REGION_OAM,
+		REGION_IOREG,
+		REGION_HRAM,  // IEReg counts as the last byte of HRAM
+
+		REGION_COUNT
+	};
+
+	// How dumpMemory() writes memory out
+	enum DumpFormat : uint8_t
+	{
+		DUMP_HEX,    // 32 bytes per line, each line labelled by its address
+		DUMP_BINARY, // The raw bytes
+	};
+
+	// Regions are split into blocks this big, each with a dirty bit
+	static constexpr int DIRTY_BLOCK_SIZE = 0x80;
+	// 16-byte tiles in VRAM $8000-$97FF, which the PPU decodes and caches
+	static constexpr int TILE_AMOUNT = 384;
+
 	MMU();
 	~MMU();
 
@@ -40,17 +67,25 @@ public:
 	// Gets the current ERAM index
 	int getERAMIndex();
 
-	// Sets ROM1 to an array of bytes
-	void setROM1(std::array<uint8_t, 0x4000>& bank);
-	// Sets ROM2 to a 2D array of bytes
-	void setROM2(std::vector<std::array<uint8_t, 0x4000>>& banks,
-				 int bank_amount);
+	// Points ROM1 at a 16KB bank. Not copied, so it must outlive the MMU's use.
+	void setROM1(const uint8_t* bank);
+	// Points ROM2 at bank_amount back to back 16KB banks. Not copied either.
+	void setROM2(const uint8_t* banks, int bank_amount);
 	// Sets and initializes ERAM
 	void setERAM(int bank_amount,
 				 bool persistent,
 				 const std::string& sav_file_path,
 				 int mbc_id);
 
+	// Sets how often persistent ERAM is flushed to its .sav file
+	void setSaveSyncInterval(std::chrono::milliseconds interval);
+	// Flushes persistent ERAM to its .sav file. Waits for the write to finish
+	// if blocking, otherwise only schedules it.
+	void syncERAM(bool blocking);
+	// Flushes persistent ERAM if the sync interval has passed since the last
+	// flush. Cheap enough to call once per frame.
+	void syncERAMIfDue();
+
 	// Sets the ORAM_locked state
 	void setOAMLocked(bool value);
 	// Gets the ORAM_locked state
@@ -60,27 +95,170 @@ public:
 	// Gets the VRAM_locked state
 	bool getVRAMLocked();
 
+	// Gets an I/O register $FF00-$FF7F. For hardware components.
+	uint8_t getIOReg(uint16_t address);
+	// Sets an I/O register $FF00-$FF7F without the side effects of a CPU
+	// write. For hardware components.
+	void setIOReg(uint16_t address, uint8_t value);
+	// Gets the Interrupt Enable register $FFFF. For hardware components.
+	uint8_t getIEReg() const;
+
+	// Gives the MMU the system's cycle counter. DIV isn't stored, it is read
+	// off this.
+	void setClock(const uint64_t* cycle_count);
+	// Gets the cycles counted since DIV was last reset. DIV is bits 8-15, and
+	// the timer ticks on its edges.
+	uint64_t getDIVCounter() const;
+	// Gets if DIV or TAC were written since the last call, and clears it.
+	// The timer has to be rescheduled when they are.
+	bool takeTimerWrite()
+	{
+		bool value = timer_written;
+		timer_written = false;
+		return value;
+	}
+
+	// Writes every RAM region, bank index, and lock into a save state. ROM
+	// isn't included, it never changes.
+	void saveState(savestate::StateWriter& state) const;
+	// Reads back what saveState() wrote. Check it with checkState() first,
+	// this trusts the banks and ERAM size in it.
+	void loadState(savestate::StateReader& state);
+	// Moves past what saveState() wrote without loading it. Throws if the
+	// state is cut short, its banks don't exist here, or its ERAM size
+	// differs.
+	void checkState(savestate::StateReader& state) const;
+
+	// Gets a region's memory, for copying or diffing its dirty blocks
+	const uint8_t* getRegionData(Region region) const;
+	// Gets a region's size in bytes
+	size_t getRegionSize(Region region) const;
+	// Gets how many dirty blocks a region is split into
+	size_t getBlockAmount(Region region) const;
+
+	// Gets if any block of a region was written since it was last cleared
+	bool isDirty(Region region) const;
+	// Gets if one block of a region was written since it was last cleared
+	bool isBlockDirty(Region region, size_t block) const;
+	// Replaces blocks with the index of every dirty block in a region
+	void getDirtyBlocks(Region region, std::vector<size_t>& blocks) const;
+	// Clears every dirty bit, starting a new checkpoint
+	void clearDirty();
+	// Clears the dirty bits of one region
+	void clearDirty(Region region);
+	// Sets every dirty bit, for when memory changes all at once
+	void markAllDirty();
+	// Moves the bits of every VRAM tile written since the last call into
+	// tiles, one bit per tile, and clears them. Separate from the dirty
+	// bitmap, so clearing one doesn't hide writes from the other.
+	void takeDirtyTiles(std::array<uint64_t, TILE_AMOUNT / 64>& tiles);
+
+	// Code tracking, for the CPU's block cache //
+
+	// Gets if code at an address can be cached: ROM, WRAM, or HRAM
+	static bool isCodeCacheable(uint16_t address);
+	// Marks first to last, in one page of WRAM or HRAM, as cached code. Writes
+	// to that page leave the fast path, and any that land on the code bump its
+	// generation.
+	void protectCode(uint16_t first, uint16_t last);
+	// Gets how many times cached code in an address's page has been written
+	// over. Checked before every cached block runs, so it is inline.
+	uint32_t getCodeGeneration(uint16_t address) const
+	{
+		return code_generations[address >> 8];
+	}
+	// Gets if cached code or the interrupt registers were written since the
+	// last call, and clears it. Checked after every cached instruction.
+	bool takeBlockBreak()
+	{
+		bool value = block_break;
+		block_break = false;
+		return value;
+	}
+
+	// Sets the Tracer that CPU writes are recorded to, or nullptr. Only used
+	// when built with ASCIIBOY_TRACE.
+	void setTracer(Tracer* tracer);
+
+	// Reads a byte without logging or PPU locks. For debuggers and tracing.
+	uint8_t peekByte(uint16_t address);
+
 	// Dumps the entire memory address space into a formatted string.
 	std::string dumpMemory();
+	// Dumps addresses first to last into output, truncating if it is smaller
+	// than getDumpSize(). Doesn't allocate. Returns the bytes written.
+	size_t dumpMemory(char* output, size_t output_size, DumpFormat format,
+					  uint16_t first = 0x0000, uint16_t last = 0xFFFF);
+	// Writes a dump of addresses first to last straight to a file descriptor.
+	// Only reads memory and calls write(), so it is safe to call from a
+	// signal handler. Returns false if a write fails.
+	bool dumpMemory(int fd, DumpFormat format,
+					uint16_t first = 0x0000, uint16_t last = 0xFFFF);
+	// Writes a dump of a whole region to a file descriptor, including banks
+	// that aren't mapped in. Hex dumps are labelled by offset into the region.
+	bool dumpRegion(int fd, Region region, DumpFormat format);
+	// Gets how many bytes dumping addresses first to last takes
+	static size_t getDumpSize(DumpFormat format,
+							  uint16_t first = 0x0000, uint16_t last = 0xFFFF);
 
 private:
+	// Page tables. One host pointer per 256-byte page of the address space.
+	// nullptr means the page has side effects or is locked, and accesses go
+	// through readByteSlow()/writeByteSlow() instead.
+	static constexpr int PAGE_SIZE = 0x100;
+	static constexpr int PAGE_COUNT = 0x100;
+	std::array<const uint8_t*, PAGE_COUNT> read_pages{};
+	std::array<uint8_t*, PAGE_COUNT> write_pages{};
+	// The dirty bit of the first block in each writable page, so the fast
+	// path can mark a write without knowing which region it is in
+	std::array<uint32_t, PAGE_COUNT> write_page_blocks{};
+
+	// Pages holding cached code, the range of offsets in each that is code,
+	// and how many times each has been written over
+	std::array<bool, PAGE_COUNT> code_pages{};
+	std::array<uint8_t, PAGE_COUNT> code_first{};
+	std::array<uint8_t, PAGE_COUNT> code_last{};
+	std::array<uint32_t, PAGE_COUNT> code_generations{};
+	bool block_break;
+
+	// DIV counts up from the cycle it was last written on. Inside a block,
+	// clock is still where the block started, so DIV can lag by part of one.
+	const uint64_t* clock;
+	uint64_t div_reset_cycle;
+	bool timer_written;
+
+	// Dirty bitmap. Every region's blocks are numbered back to back, starting
+	// at region_first_block.
+	std::vector<uint64_t> dirty_bits;
+	std::array<uint32_t, REGION_COUNT> region_first_block{};
+	std::array<uint32_t, REGION_COUNT> region_block_amount{};
+	// Written VRAM tiles. Tile data stays on the slow path so every write to
+	// it is seen here.
+	std::array<uint64_t, TILE_AMOUNT / 64> dirty_tiles{};
+
 	// Memory banks
-	std::array<uint8_t, 0x4000> ROM1{}; // Static ROM $0000-$3FFF
+	// ROM is a view into the Cartridge's ROM image, nullptr until one is set.
+	const uint8_t* ROM1; // Static ROM $0000-$3FFF
 
-	std::vector< std::array<uint8_t, 0x4000> > ROM2{}; // Banked ROM $4000-$7FFF
+	const uint8_t* ROM2; // Banked ROM $4000-$7FFF, bank i at ROM2 + i * 0x4000
 	int ROM2_index; // Which ROM2 bank the MMU uses
-	int ROM2_bank_amount{}; // Amount of ROM banks that exist
+	int ROM2_bank_amount{}; // Amount of switchable ROM banks that exist
 
 	std::array<uint8_t, 0x4000> VRAM{}; // VRAM $8000-$9FFF
 
 	// External RAM $A000-BFFF.
-	// Either a file on disk if persistent, or just an array if not.
+	// Persistent ERAM is the .sav file mapped straight into memory, so the
+	// page tables point at the file and the OS writes it back. If the file
+	// can't be mapped, ERAM falls back to the vector and is written out on sync.
+	// A mapped .sav is locked, so only one MMU in any process owns it. Later
+	// ones get a copy of it in the vector that is never written back.
 	std::string sav_file_path;
-	// TODO: This should be a memory mapped file instead.
 	int mbc;
-	std::fstream SavFile;
 	bool ERAM_persistent;
-	std::vector< std::array<uint8_t, 0x2000> > ERAM{};
+	std::vector<uint8_t> ERAM{}; // Volatile banks, back to back
+	uint8_t* ERAM_data; // Bank 0 of either ERAM or SavMapping
+	uint8_t* SavMapping; // nullptr unless the .sav file is mapped
+	size_t ERAM_size; // Bytes in every bank together
 	int ERAM_index; // Which ERAM bank the MMU uses
 	int ERAM_bank_amount{}; // Amount of ERAM banks that exist
 
@@ -98,13 +276,70 @@ private:
 					 
 	uint8_t IEReg; // Interrupt Enable Register $FFFF
 
+	Tracer* tracer;
+
 	// ORAM and VRAM access is locked during some PPU states
 	bool OAM_locked;
 	bool VRAM_locked;
 
+	// .sav flushing
+	std::chrono::milliseconds save_sync_interval;
+	std::chrono::steady_clock::time_point last_save_sync;
+
 	// Reads a byte from memory, without logging. For dumping memory.
 	inline uint8_t getByte(uint16_t address);
 
+	// Reads a byte from a page that isn't in the page table
+	uint8_t readByteSlow(uint16_t address, bool is_ppu);
+	// Writes a byte to a page that isn't in the page table
+	void writeByteSlow(uint16_t address, uint8_t value, bool is_ppu);
+
+	// Points the page table entries from first_page at memory, or clears them
+	// if memory is nullptr
+	void mapPages(std::array<const uint8_t*, PAGE_COUNT>& table,
+				  int first_page, int page_amount, const uint8_t* memory);
+	void mapPages(std::array<uint8_t*, PAGE_COUNT>& table,
+				  int first_page, int page_amount, uint8_t* memory);
+	// Points write_page_blocks from first_page at a region's blocks, starting
+	// from the block at offset bytes into it
+	void mapDirtyBlocks(int first_page, int page_amount,
+						Region region, size_t offset);
+	// Repoints the page tables for each region after a bank or lock change
+	void mapROM1();
+	void mapROM2();
+	void mapVRAM();
+	void mapERAM();
+	void mapWRAM();
+
+	// Drops a page's cached code by bumping its generation, and puts the page
+	// back on the fast path
+	void invalidateCode(int page);
+
+	// Numbers every region's blocks and resizes the bitmap. Everything starts
+	// dirty.
+	void layoutDirtyBits();
+	// Sets the dirty bit of the block at offset bytes into a region
+	void markDirty(Region region, size_t offset);
+	// Sets a dirty bit by its number
+	inline void markBlockDirty(uint32_t block)
+	{
+		dirty_bits[block >> 6] |= 1ull << (block & 63);
+	}
+
+	// What mapSavFile() managed
+	enum SavMapResult
+	{
+		SAV_MAPPED,
+		SAV_IN_USE, // Another MMU has it mapped
+		SAV_FAILED,
+	};
+
+	// Maps the .sav file over ERAM_size bytes, and locks it for as long as
+	// it stays mapped
+	SavMapResult mapSavFile();
+	// Syncs and releases the .sav mapping
+	void unmapSavFile();
+
 	// Reads a byte from external RAM
 	uint8_t readERAMByte(int bank, uint16_t address);
 	// Writes a byte to external RAM
@@ -0,0 +1,374 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/ppu.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Picture Processing Unit of the Gameboy. Renders the background, window, and
+ sprites into a framebuffer, one scanline at a time.
+ ******************************************************************************/
+
+#include "ppu.hpp"
+#include "tiledecode.hpp"
+
+#include <cstring>
+
+// LCD registers
+static constexpr uint16_t LCDC_ADDRESS = 0xFF40;
+static constexpr uint16_t SCY_ADDRESS = 0xFF42;
+static constexpr uint16_t SCX_ADDRESS = 0xFF43;
+static constexpr uint16_t BGP_ADDRESS = 0xFF47;
+static constexpr uint16_t OBP0_ADDRESS = 0xFF48;
+static constexpr uint16_t OBP1_ADDRESS = 0xFF49;
+static constexpr uint16_t WY_ADDRESS = 0xFF4A;
+static constexpr uint16_t WX_ADDRESS = 0xFF4B;
+
+// LCDC bits
+static constexpr uint8_t LCDC_BG_ENABLE = 0x01;
+static constexpr uint8_t LCDC_OBJ_ENABLE = 0x02;
+static constexpr uint8_t LCDC_OBJ_TALL = 0x04;
+static constexpr uint8_t LCDC_BG_MAP = 0x08;
+static constexpr uint8_t LCDC_UNSIGNED_TILES = 0x10;
+static constexpr uint8_t LCDC_WINDOW_ENABLE = 0x20;
+static constexpr uint8_t LCDC_WINDOW_MAP = 0x40;
+
+// Sprite attribute bits
+static constexpr uint8_t OBJ_PALETTE = 0x10;
+static constexpr uint8_t OBJ_X_FLIP = 0x20;
+static constexpr uint8_t OBJ_Y_FLIP = 0x40;
+static constexpr uint8_t OBJ_BEHIND_BG = 0x80;
+
+// Tile maps, as offsets into VRAM
+static constexpr int MAP_0 = 0x1800;
+static constexpr int MAP_1 = 0x1C00;
+
+static constexpr int SPRITE_AMOUNT = 40;
+static constexpr int MAX_LINE_SPRITES = 10;
+
+// Gets the tile a map entry points at. With unsigned tiles the entry counts
+// from $8000, otherwise it is signed and counts from $9000.
+static int getMapTile(uint8_t entry, uint8_t lcdc)
+{
+	return (lcdc & LCDC_UNSIGNED_TILES) ? entry : 256 + (int8_t)entry;
+}
+
+// Gets the shade a palette gives a color index
+static uint8_t getShade(uint8_t palette, uint8_t color)
+{
+	return (palette >> (color * 2)) & 0b11;
+}
+
+
+
+
+
+// Constructor
+PPU::PPU()
+{
+	frame_count = 0;
+	lcd_off = false;
+	window_line = 0;
+}
+
+
+
+// Renders one line of the framebuffer
+void PPU::renderLine(int line, MMU& mem)
+{
+	if(line < 0 || line >= HEIGHT)
+	{
+		return;
+	}
+
+	lcd_off = false;
+	refreshTiles(mem);
+
+	uint8_t lcdc = mem.getIOReg(LCDC_ADDRESS);
+	uint8_t* row = framebuffer.data() + line * WIDTH;
+
+	// Color indices, with a tile's worth of slack on either side
+	std::array<uint8_t, WIDTH + 16> line_buffer{};
+	uint8_t* bg = line_buffer.data() + 8;
+
+	// With BG off, the background and window are blank, and sprites always
+	// show over them
+	if(lcdc & LCDC_BG_ENABLE)
+	{
+		renderBackground(line, lcdc, mem, bg);
+		renderWindow(line, lcdc, mem, bg);
+
+		uint8_t bgp = mem.getIOReg(BGP_ADDRESS);
+		for(int x = 0; x < WIDTH; x++)
+		{
+			row[x] = getShade(bgp, bg[x]);
+		}
+	}
+	else
+	{
+		std::memset(row, 0, WIDTH);
+	}
+
+	if(lcdc & LCDC_OBJ_ENABLE)
+	{
+		renderSprites(line, lcdc, mem, bg, row);
+	}
+}
+
+
+// Call as VBlank starts
+void PPU::endFrame()
+{
+	frame_count++;
+	window_line = 0;
+}
+
+
+// Call while the LCD is off
+void PPU::setLCDOff()
+{
+	if(lcd_off)
+	{
+		return;
+	}
+
+	lcd_off = true;
+	framebuffer.fill(0);
+	frame_count++;
+	window_line = 0;
+}
+
+
+
+// Gets the framebuffer
+const std::array<uint8_t, PPU::WIDTH * PPU::HEIGHT>& PPU::getFramebuffer() const
+{
+	return framebuffer;
+}
+
+// Gets how many frames have finished
+uint64_t PPU::getFrameCount() const
+{
+	return frame_count;
+}
+
+
+
+// Drops every decoded tile
+void PPU::invalidateTiles()
+{
+	tile_valid.fill(false);
+}
+
+
+// Marks the tiles the MMU saw written as needing to be decoded again
+void PPU::refreshTiles(MMU& mem)
+{
+	std::array<uint64_t, MMU::TILE_AMOUNT / 64> dirty{};
+	mem.takeDirtyTiles(dirty);
+
+	// Usually nothing was written, so skip a word at a time
+	for(size_t word = 0; word < dirty.size(); word++)
+	{
+		if(dirty[word] == 0)
+		{
+			continue;
+		}
+
+		for(int bit = 0; bit < 64; bit++)
+		{
+			if(dirty[word] & (1ull << bit))
+			{
+				tile_valid[word * 64 + bit] = false;
+			}
+		}
+	}
+}
+
+
+// Gets 8 color indices of a tile row
+const uint8_t* PPU::getTileRow(int tile, int row, const uint8_t* vram)
+{
+	if(!tile_valid[tile])
+	{
+		decodeTile(tile, vram);
+	}
+
+	return tiles[tile].data() + row * 8;
+}
+
+
+// Decodes a tile from its 16 bytes of 2bpp data
+void PPU::decodeTile(int tile, const uint8_t* vram)
+{
+	tiledecode::decode(vram + tile * 16, tiles[tile].data());
+	tile_valid[tile] = true;
+}
+
+
+
+// Renders the scrolled background
+void PPU::renderBackground(int line, uint8_t lcdc, MMU& mem,
+						   uint8_t* line_pixels)
+{
+	const uint8_t* vram = mem.getRegionData(MMU::REGION_VRAM);
+
+	uint8_t scx = mem.getIOReg(SCX_ADDRESS);
+	int y = (line + mem.getIOReg(SCY_ADDRESS)) & 0xFF;
+
+	const uint8_t* map = vram + ((lcdc & LCDC_BG_MAP) ? MAP_1 : MAP_0)
+						 + (y / 8) * 32;
+
+	// The first tile starts up to 7 pixels off the left edge. The map wraps.
+	int map_x = scx / 8;
+	for(int x = -(scx & 7); x < WIDTH; x += 8)
+	{
+		int tile = getMapTile(map[map_x & 31], lcdc);
+		std::memcpy(line_pixels + x, getTileRow(tile, y & 7, vram), 8);
+		map_x++;
+	}
+}
+
+
+// Renders the window over the background, if it covers this line
+void PPU::renderWindow(int line, uint8_t lcdc, MMU& mem, uint8_t* line_pixels)
+{
+	if(!(lcdc & LCDC_WINDOW_ENABLE))
+	{
+		return;
+	}
+
+	// WX is offset by 7, so the window can start up to 7 pixels off screen
+	int window_x = mem.getIOReg(WX_ADDRESS) - 7;
+	if(line < mem.getIOReg(WY_ADDRESS) || window_x >= WIDTH)
+	{
+		return;
+	}
+
+	const uint8_t* vram = mem.getRegionData(MMU::REGION_VRAM);
+	const uint8_t* map = vram + ((lcdc & LCDC_WINDOW_MAP) ? MAP_1 : MAP_0)
+						 + (window_line / 8) * 32;
+
+	int map_x = 0;
+	for(int x = window_x; x < WIDTH; x += 8)
+	{
+		int tile = getMapTile(map[map_x], lcdc);
+		std::memcpy(line_pixels + x,
+					getTileRow(tile, window_line & 7, vram), 8);
+		map_x++;
+	}
+
+	window_line++;
+}
+
+
+// Draws the line's sprites
+void PPU::renderSprites(int line, uint8_t lcdc, MMU& mem,
+						const uint8_t* bg, uint8_t* row)
+{
+	const uint8_t* vram = mem.getRegionData(MMU::REGION_VRAM);
+	const uint8_t* oam = mem.getRegionData(MMU::REGION_OAM);
+	int height = (lcdc & LCDC_OBJ_TALL) ? 16 : 8;
+
+	// Only the first 10 sprites in OAM that cover the line are drawn
+	std::array<int, MAX_LINE_SPRITES> visible{};
+	int visible_amount = 0;
+	for(int i = 0; i < SPRITE_AMOUNT && visible_amount < MAX_LINE_SPRITES; i++)
+	{
+		int y = oam[i * 4] - 16;
+		if(line >= y && line < y + height)
+		{
+			visible[visible_amount++] = i;
+		}
+	}
+
+	// The sprite furthest left is on top, then the first in OAM
+	std::stable_sort(visible.begin(), visible.begin() + visible_amount,
+					 [oam](int a, int b) {
+						 return oam[a * 4 + 1] < oam[b * 4 + 1];
+					 });
+
+	uint8_t palettes[2] = {mem.getIOReg(OBP0_ADDRESS),
+						   mem.getIOReg(OBP1_ADDRESS)};
+
+	// Once a sprite has an opaque pixel somewhere, the ones under it can't
+	// show there, even if it is hidden behind the background
+	std::array<bool, WIDTH> covered{};
+
+	for(int v = 0; v < visible_amount; v++)
+	{
+		const uint8_t* sprite = oam + visible[v] * 4;
+		int x = sprite[1] - 8;
+		uint8_t flags = sprite[3];
+
+		int sprite_row = line - (sprite[0] - 16);
+		if(flags & OBJ_Y_FLIP)
+		{
+			sprite_row = height - 1 - sprite_row;
+		}
+
+		// Tall sprites are two tiles, the first with its low bit cleared
+		int tile = sprite[2];
+		if(height == 16)
+		{
+			tile = (tile & 0xFE) + sprite_row / 8;
+		}
+
+		const uint8_t* pixels = getTileRow(tile, sprite_row & 7, vram);
+		uint8_t palette = palettes[(flags & OBJ_PALETTE) ? 1 : 0];
+
+		for(int i = 0; i < 8; i++)
+		{
+			int screen_x = x + i;
+			if(screen_x < 0 || screen_x >= WIDTH || covered[screen_x])
+			{
+				continue;
+			}
+
+			uint8_t color = pixels[(flags & OBJ_X_FLIP) ? 7 - i : i];
+			if(color == 0)
+			{
+				continue; // Transparent
+			}
+
+			covered[screen_x] = true;
+			if((flags & OBJ_BEHIND_BG) && bg[screen_x] != 0)
+			{
+				continue;
+			}
+
+			row[screen_x] = getShade(palette, color);
+		}
+	}
+}
+
+
+
+// Writes the mid-frame state into a save state
+void PPU::saveState(savestate::StateWriter& state) const
+{
+	state.write(window_line);
+	state.write(lcd_off);
+}
+
+// Reads back what saveState() wrote
+void PPU::loadState(savestate::StateReader& state)
+{
+	state.read(window_line);
+	state.read(lcd_off);
+
+	// VRAM was replaced wholesale
+	invalidateTiles();
+}
+
+// Moves past what saveState() wrote without loading it
+void PPU::checkState(savestate::StateReader& state) const
+{
+	bool loaded_lcd_off = false;
+
+	state.skip<decltype(window_line)>();
+	state.read(loaded_lcd_off);
+}
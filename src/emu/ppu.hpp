@@ -0,0 +1,89 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/ppu.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Picture Processing Unit of the Gameboy. Renders the background, window, and
+ sprites into a framebuffer, one scanline at a time.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "mmu.hpp"
+#include "savestate.hpp"
+
+// GBSystem handles the PPU's timing, and calls renderLine() as each visible
+// line's pixel transfer ends. Tiles are decoded from 2bpp once, then kept
+// until the MMU reports a write to their 16 bytes.
+class PPU
+{
+public:
+	static constexpr int WIDTH = 160;
+	static constexpr int HEIGHT = 144;
+
+	PPU();
+
+	// Renders one line of the framebuffer from the current VRAM, OAM, and
+	// LCD registers
+	void renderLine(int line, MMU& mem);
+	// Call as VBlank starts. The framebuffer holds a whole frame until the
+	// next line is rendered.
+	void endFrame();
+	// Call while the LCD is off. Blanks the screen once.
+	void setLCDOff();
+
+	// Gets the framebuffer. One shade per pixel, 0 (lightest) to 3 (darkest),
+	// row by row.
+	const std::array<uint8_t, WIDTH * HEIGHT>& getFramebuffer() const;
+	// Gets how many frames have finished, counting the blank one from
+	// turning the LCD off
+	uint64_t getFrameCount() const;
+
+	// Drops every decoded tile
+	void invalidateTiles();
+
+	// Writes the mid-frame state into a save state. The framebuffer isn't
+	// included, it is output.
+	void saveState(savestate::StateWriter& state) const;
+	// Reads back what saveState() wrote
+	void loadState(savestate::StateReader& state);
+	// Moves past what saveState() wrote without loading it. Throws if the
+	// state is cut short.
+	void checkState(savestate::StateReader& state) const;
+
+private:
+	std::array<uint8_t, WIDTH * HEIGHT> framebuffer{};
+	uint64_t frame_count;
+	bool lcd_off;
+
+	// The window has its own line counter, which only moves on lines it was
+	// drawn on
+	int window_line;
+
+	// Decoded tile cache. Each tile's pixels are color indices 0-3, row by row.
+	std::array<std::array<uint8_t, 64>, MMU::TILE_AMOUNT> tiles{};
+	std::array<bool, MMU::TILE_AMOUNT> tile_valid{};
+
+	// Marks the tiles the MMU saw written as needing to be decoded again
+	void refreshTiles(MMU& mem);
+	// Gets 8 color indices of a tile row, decoding the tile if needed
+	const uint8_t* getTileRow(int tile, int row, const uint8_t* vram);
+	// Decodes a tile from its 16 bytes of 2bpp data
+	void decodeTile(int tile, const uint8_t* vram);
+
+	// Each of these writes color indices into line_pixels, which starts 8
+	// pixels early and ends 8 late, so whole tile rows can be copied in
+	void renderBackground(int line, uint8_t lcdc, MMU& mem,
+						  uint8_t* line_pixels);
+	void renderWindow(int line, uint8_t lcdc, MMU& mem, uint8_t* line_pixels);
+	// Draws the line's sprites over a finished row of shades. bg holds the
+	// background's color indices, for priority.
+	void renderSprites(int line, uint8_t lcdc, MMU& mem,
+					   const uint8_t* bg, uint8_t* row);
+};
@@ -0,0 +1,381 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/rewind.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Keeps a history of save states to rewind through, delta compressed into a
+ fixed-size ring buffer.
+ ******************************************************************************/
+
+#include "rewind.hpp"
+
+#include <cstring>
+
+// Encoded snapshots are the decoded size as a uint32, then pairs of
+// (zero run, literal run) lengths as LEB128 varints, each followed by the
+// literal bytes. Anything past the last pair is zeros.
+
+// Literal runs only end at a zero run at least this long, since a shorter
+// one costs more in varints than it saves
+static constexpr size_t MIN_ZERO_RUN = 4;
+
+// Appends a LEB128 varint
+static void writeVarint(std::vector<uint8_t>& output, size_t value)
+{
+	while(value >= 0x80)
+	{
+		output.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	output.push_back((uint8_t)value);
+}
+
+// Reads a LEB128 varint, advancing position
+static size_t readVarint(const uint8_t* data, size_t& position)
+{
+	size_t value = 0;
+	int shift = 0;
+	uint8_t byte = 0;
+	do {
+		byte = data[position++];
+		value |= (size_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while(byte & 0x80);
+
+	return value;
+}
+
+
+
+// Constructor
+Rewinder::Rewinder(size_t buffer_size,
+				   int frames_per_snapshot,
+				   int snapshots_per_keyframe)
+{
+	buffer.resize(buffer_size);
+	bytes_used = 0;
+
+	this->frames_per_snapshot = std::max(frames_per_snapshot, 1);
+	this->snapshots_per_keyframe = std::max(snapshots_per_keyframe, 1);
+	frames_until_snapshot = this->frames_per_snapshot;
+	snapshots_until_keyframe = 0;
+	next_id = 0;
+	keyframe_id = 0;
+}
+
+
+
+// Call once per emulated frame
+void Rewinder::onFrame(GBSystem& gb)
+{
+	frames_until_snapshot--;
+	if(frames_until_snapshot > 0)
+	{
+		return;
+	}
+
+	frames_until_snapshot = frames_per_snapshot;
+	capture(gb);
+}
+
+
+
+// Restores the newest snapshot and drops it
+bool Rewinder::rewind(GBSystem& gb)
+{
+	if(snapshots.empty())
+	{
+		return false;
+	}
+
+	Snapshot newest = snapshots.back();
+	decode(newest, state);
+
+	snapshots.pop_back();
+	bytes_used -= newest.size;
+
+	gb.loadState(state);
+
+	// If that was the keyframe new deltas were made against, fall back to the
+	// one before it
+	if(newest.id == keyframe_id)
+	{
+		keyframe.clear();
+		if(!snapshots.empty())
+		{
+			keyframe_id = snapshots.back().keyframe_id;
+			auto it = std::lower_bound(
+					snapshots.begin(), snapshots.end(), keyframe_id,
+					[](const Snapshot& s, uint64_t id) { return s.id < id; });
+			decode(*it, keyframe);
+		}
+	}
+
+	frames_until_snapshot = frames_per_snapshot;
+	return true;
+}
+
+
+
+// Drops every snapshot
+void Rewinder::clear()
+{
+	snapshots.clear();
+	bytes_used = 0;
+	keyframe.clear();
+	snapshots_until_keyframe = 0;
+	frames_until_snapshot = frames_per_snapshot;
+}
+
+
+
+// Gets how many snapshots can be rewound through
+size_t Rewinder::getSnapshotAmount() const
+{
+	return snapshots.size();
+}
+
+// Gets how many bytes of the buffer the snapshots take up
+size_t Rewinder::getBytesUsed() const
+{
+	return bytes_used;
+}
+
+
+
+// Saves, encodes, and stores a snapshot
+void Rewinder::capture(GBSystem& gb)
+{
+	gb.saveState(state);
+
+	// Deltas need their keyframe to still be in the buffer
+	bool keyframe_stored = !keyframe.empty() && !snapshots.empty()
+						   && snapshots.front().id <= keyframe_id;
+	bool is_keyframe = snapshots_until_keyframe <= 0 || !keyframe_stored
+					   || keyframe.size() != state.size();
+
+	encode(state, is_keyframe ? nullptr : &keyframe, encoded);
+
+	if(!store(is_keyframe))
+	{
+		if(is_keyframe)
+		{
+			keyframe.clear(); // Bigger than the whole buffer
+			return;
+		}
+
+		// Making room dropped this delta's keyframe, so start a new one
+		is_keyframe = true;
+		encode(state, nullptr, encoded);
+		if(!store(true))
+		{
+			keyframe.clear();
+			return;
+		}
+	}
+
+	if(is_keyframe)
+	{
+		keyframe = state;
+		keyframe_id = next_id - 1;
+		snapshots_until_keyframe = snapshots_per_keyframe;
+	}
+	snapshots_until_keyframe--;
+}
+
+
+
+// Copies encoded into the ring, making room if needed
+bool Rewinder::store(bool is_keyframe)
+{
+	size_t size = encoded.size();
+	if(size > buffer.size())
+	{
+		return false;
+	}
+
+	// Snapshots go right after the newest one, or back at the start if they
+	// don't fit before the end. Whatever is in the way is the oldest.
+	size_t position = 0;
+	if(!snapshots.empty())
+	{
+		position = snapshots.back().offset + snapshots.back().size;
+	}
+
+	if(position + size > buffer.size())
+	{
+		// Everything between here and the end is about to be skipped over
+		while(!snapshots.empty() && snapshots.front().offset >= position)
+		{
+			dropOldestKeyframe();
+		}
+		position = 0;
+	}
+
+	while(!snapshots.empty()
+		  && snapshots.front().offset >= position
+		  && snapshots.front().offset < position + size)
+	{
+		dropOldestKeyframe();
+	}
+
+	if(!is_keyframe
+	   && (snapshots.empty() || snapshots.front().id > keyframe_id))
+	{
+		return false;
+	}
+
+	std::memcpy(buffer.data() + position, encoded.data(), size);
+
+	uint64_t id = next_id++;
+	snapshots.push_back({id, is_keyframe ? id : keyframe_id, position, size});
+	bytes_used += size;
+
+	return true;
+}
+
+
+
+// Drops the oldest keyframe, and every delta that depends on it
+void Rewinder::dropOldestKeyframe()
+{
+	do {
+		bytes_used -= snapshots.front().size;
+		snapshots.pop_front();
+	} while(!snapshots.empty()
+			&& snapshots.front().id != snapshots.front().keyframe_id);
+}
+
+
+
+// Decodes a snapshot into output
+void Rewinder::decode(const Snapshot& snapshot, std::vector<uint8_t>& output)
+{
+	const uint8_t* data = buffer.data() + snapshot.offset;
+
+	if(snapshot.id == snapshot.keyframe_id)
+	{
+		uint32_t size = 0;
+		std::memcpy(&size, data, sizeof(size));
+		output.assign(size, 0);
+	}
+	else if(snapshot.keyframe_id == keyframe_id && !keyframe.empty())
+	{
+		output = keyframe;
+	}
+	else
+	{
+		// An older keyframe than the cached one. Decode it first.
+		auto it = std::lower_bound(
+				snapshots.begin(), snapshots.end(), snapshot.keyframe_id,
+				[](const Snapshot& s, uint64_t id) { return s.id < id; });
+		decode(*it, output);
+	}
+
+	applyDelta(data + sizeof(uint32_t), snapshot.size - sizeof(uint32_t),
+			   output);
+}
+
+
+
+// XORs data against base (or nothing) and run-length encodes the zeros
+void Rewinder::encode(const std::vector<uint8_t>& data,
+					  const std::vector<uint8_t>* base,
+					  std::vector<uint8_t>& output)
+{
+	const uint8_t* current = data.data();
+	const uint8_t* previous = base ? base->data() : nullptr;
+	size_t size = data.size();
+
+	auto difference = [&](size_t i) -> uint8_t {
+		return previous ? current[i] ^ previous[i] : current[i];
+	};
+
+	uint32_t header = size;
+	output.resize(sizeof(header));
+	std::memcpy(output.data(), &header, sizeof(header));
+
+	size_t i = 0;
+	while(i < size)
+	{
+		// Zero run. Most of the state is unchanged, so skip a word at a time.
+		size_t zero_start = i;
+		while(i + 8 <= size)
+		{
+			uint64_t a = 0;
+			uint64_t b = 0;
+			std::memcpy(&a, current + i, 8);
+			if(previous) { std::memcpy(&b, previous + i, 8); }
+			if(a != b) { break; }
+			i += 8;
+		}
+		while(i < size && difference(i) == 0)
+		{
+			i++;
+		}
+
+		if(i == size)
+		{
+			break; // Trailing zeros are implied
+		}
+
+		// Literal run, up to the next zero run worth a pair of its own
+		size_t literal_start = i;
+		while(i < size)
+		{
+			if(difference(i) != 0)
+			{
+				i++;
+				continue;
+			}
+
+			size_t zeros_end = i;
+			while(zeros_end < size && zeros_end - i < MIN_ZERO_RUN
+				  && difference(zeros_end) == 0)
+			{
+				zeros_end++;
+			}
+			if(zeros_end - i >= MIN_ZERO_RUN || zeros_end == size)
+			{
+				break;
+			}
+			i = zeros_end;
+		}
+
+		writeVarint(output, literal_start - zero_start);
+		writeVarint(output, i - literal_start);
+		for(size_t j = literal_start; j < i; j++)
+		{
+			output.push_back(difference(j));
+		}
+	}
+}
+
+
+
+// Undoes encode() on top of output, which must hold the base
+void Rewinder::applyDelta(const uint8_t* delta, size_t size,
+						  std::vector<uint8_t>& output)
+{
+	size_t position = 0;
+	size_t target = 0;
+
+	while(position < size)
+	{
+		target += readVarint(delta, position);
+		size_t literal_size = readVarint(delta, position);
+
+		for(size_t j = 0; j < literal_size; j++)
+		{
+			output[target + j] ^= delta[position + j];
+		}
+
+		position += literal_size;
+		target += literal_size;
+	}
+}
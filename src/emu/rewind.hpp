@@ -0,0 +1,98 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/rewind.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Keeps a history of save states to rewind through, delta compressed into a
+ fixed-size ring buffer.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "gbsystem.hpp"
+
+#include <deque>
+
+// Every few frames, the whole system is saved and XORed against the last
+// keyframe, so everything that didn't change becomes zeros. The zero runs are
+// then run-length encoded. Keyframes are encoded the same way against
+// nothing. Snapshots are packed into one preallocated buffer, and the oldest
+// keyframe is dropped along with its deltas when space runs out.
+class Rewinder
+{
+public:
+	static constexpr size_t DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+	static constexpr int DEFAULT_FRAMES_PER_SNAPSHOT = 2;
+	static constexpr int DEFAULT_SNAPSHOTS_PER_KEYFRAME = 64;
+
+	Rewinder(size_t buffer_size = DEFAULT_BUFFER_SIZE,
+			 int frames_per_snapshot = DEFAULT_FRAMES_PER_SNAPSHOT,
+			 int snapshots_per_keyframe = DEFAULT_SNAPSHOTS_PER_KEYFRAME);
+
+	// Call once per emulated frame. Takes a snapshot every
+	// frames_per_snapshot frames.
+	void onFrame(GBSystem& gb);
+
+	// Restores the newest snapshot and drops it. Returns false if there are
+	// none left.
+	bool rewind(GBSystem& gb);
+
+	// Drops every snapshot
+	void clear();
+
+	// Gets how many snapshots can be rewound through
+	size_t getSnapshotAmount() const;
+	// Gets how many bytes of the buffer the snapshots take up
+	size_t getBytesUsed() const;
+
+	// XORs data against base (or nothing) and run-length encodes the zeros
+	static void encode(const std::vector<uint8_t>& data,
+					   const std::vector<uint8_t>* base,
+					   std::vector<uint8_t>& output);
+	// Undoes encode() on top of output, which must hold the base. delta
+	// starts after encode()'s size header.
+	static void applyDelta(const uint8_t* delta, size_t size,
+						   std::vector<uint8_t>& output);
+
+private:
+	// Where a snapshot is in the buffer
+	struct Snapshot
+	{
+		uint64_t id;
+		uint64_t keyframe_id; // Equal to id for keyframes
+		size_t offset;
+		size_t size;
+	};
+
+	std::vector<uint8_t> buffer; // The ring. Snapshots never wrap around.
+	std::deque<Snapshot> snapshots; // Oldest first, always a keyframe
+	size_t bytes_used;
+
+	int frames_per_snapshot;
+	int snapshots_per_keyframe;
+	int frames_until_snapshot;
+	int snapshots_until_keyframe;
+	uint64_t next_id;
+
+	// Scratch space, kept between snapshots so capturing doesn't allocate
+	std::vector<uint8_t> state; // The state being saved or restored
+	std::vector<uint8_t> encoded; // state, encoded
+	std::vector<uint8_t> keyframe; // The newest keyframe, decoded
+	uint64_t keyframe_id; // Which snapshot keyframe holds
+
+	// Saves, encodes, and stores a snapshot
+	void capture(GBSystem& gb);
+	// Copies encoded into the ring, making room if needed. Returns false if
+	// it can't fit, or the keyframe it depends on had to be dropped.
+	bool store(bool is_keyframe);
+	// Drops the oldest keyframe, and every delta that depends on it
+	void dropOldestKeyframe();
+	// Decodes a snapshot into output
+	void decode(const Snapshot& snapshot, std::vector<uint8_t>& output);
+};
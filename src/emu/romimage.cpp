@@ -0,0 +1,195 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/romimage.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ An immutable, in-memory copy of a ROM file. The file is mapped read-only
+ where possible, so loading a ROM copies nothing. Images are shared between
+ every Cartridge of the same file.
+ ******************************************************************************/
+
+#include "romimage.hpp"
+
+// Gets the image of the file at rom_path, shared with everything else that
+// has it loaded
+std::shared_ptr<const RomImage> RomImage::load(const std::string& rom_path)
+{
+	// Weak, so an image is unmapped as soon as the last Cartridge using it goes
+	static std::mutex cache_mutex;
+	static std::unordered_map<std::string, std::weak_ptr<const RomImage>> cache;
+
+	// Key on the canonical path, so "./roms/a.gb" and "roms/a.gb" are one image
+	std::string key = std::filesystem::weakly_canonical(rom_path).string();
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+
+	std::shared_ptr<const RomImage> image = cache[key].lock();
+	if(image == nullptr)
+	{
+		image = std::make_shared<const RomImage>(rom_path);
+		cache[key] = image;
+	}
+
+	return image;
+}
+
+
+
+// Constructor
+RomImage::RomImage(const std::string& rom_path)
+{
+	rom_data = nullptr;
+	rom_size = 0;
+	mapping = nullptr;
+
+	if(!mapFile(rom_path))
+	{
+		Logger::instance().log("CART: Could not map ROM file, reading it "
+							   "into memory instead.",
+							   Logger::VERBOSE);
+		readFile(rom_path);
+	}
+}
+
+// Destructor
+RomImage::~RomImage()
+{
+	if(mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, rom_size);
+#endif
+	}
+}
+
+
+
+// Gets the first byte of the ROM
+const uint8_t* RomImage::data() const
+{
+	return rom_data;
+}
+
+// Gets the size of the ROM in bytes
+size_t RomImage::size() const
+{
+	return rom_size;
+}
+
+// Gets if the ROM is a file mapping rather than a heap copy
+bool RomImage::isMapped() const
+{
+	return mapping != nullptr;
+}
+
+
+
+// Maps the file read-only. Returns false if it can't.
+bool RomImage::mapFile(const std::string& rom_path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(rom_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+							  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+							  nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER info{};
+	if(!GetFileSizeEx(file, &info) || info.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY,
+											 0, 0, nullptr);
+
+	// The mapping holds its own reference to the file
+	CloseHandle(file);
+
+	if(file_mapping == nullptr)
+	{
+		return false;
+	}
+
+	size_t file_size = info.QuadPart;
+	void* view = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+
+	// And the view holds its own reference to the mapping
+	CloseHandle(file_mapping);
+
+	if(view == nullptr)
+	{
+		return false;
+	}
+
+	mapping = view;
+	rom_data = static_cast<const uint8_t*>(view);
+	rom_size = file_size;
+	return true;
+#else
+	int fd = open(rom_path.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info{};
+	if(fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	size_t file_size = info.st_size;
+	void* file_mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping holds its own reference to the file
+	close(fd);
+
+	if(file_mapping == MAP_FAILED)
+	{
+		return false;
+	}
+
+	mapping = file_mapping;
+	rom_data = static_cast<const uint8_t*>(file_mapping);
+	rom_size = file_size;
+	return true;
+#endif
+}
+
+// Reads the file into buffer with a single read. Throws on failure.
+void RomImage::readFile(const std::string& rom_path)
+{
+	std::ifstream rom_file(rom_path, std::ios::binary | std::ios::ate);
+	if(!rom_file)
+	{
+		throw std::runtime_error("Could not open ROM file.");
+	}
+
+	std::streamsize file_size = rom_file.tellg();
+	if(file_size <= 0)
+	{
+		throw std::runtime_error("ROM file is empty.");
+	}
+
+	buffer.resize(file_size);
+	rom_file.seekg(0);
+	if(!rom_file.read(reinterpret_cast<char*>(buffer.data()), file_size))
+	{
+		throw std::runtime_error("Could not read ROM file.");
+	}
+
+	rom_data = buffer.data();
+	rom_size = buffer.size();
+}
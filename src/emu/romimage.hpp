@@ -0,0 +1,55 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/romimage.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ An immutable, in-memory copy of a ROM file. The file is mapped read-only
+ where possible, so loading a ROM copies nothing. Images are shared between
+ every Cartridge of the same file.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+
+class RomImage
+{
+public:
+	// Gets the image of the file at rom_path, shared with everything else that
+	// has it loaded. Only maps the file if nothing does. Throws if it can't be
+	// read.
+	static std::shared_ptr<const RomImage> load(const std::string& rom_path);
+
+	// Maps or reads the whole file at rom_path. Throws if it can't be read.
+	// Prefer load(), this always makes a new image.
+	explicit RomImage(const std::string& rom_path);
+	~RomImage();
+
+	// The MMU holds pointers into the image, so it never moves
+	RomImage(const RomImage&) = delete;
+	RomImage& operator=(const RomImage&) = delete;
+
+	// Gets the first byte of the ROM
+	const uint8_t* data() const;
+	// Gets the size of the ROM in bytes
+	size_t size() const;
+	// Gets if the ROM is a file mapping rather than a heap copy
+	bool isMapped() const;
+
+private:
+	const uint8_t* rom_data;
+	size_t rom_size;
+
+	void* mapping; // nullptr unless the file is mapped
+	std::vector<uint8_t> buffer; // Fallback copy when mapping fails
+
+	// Maps the file read-only. Returns false if it can't.
+	bool mapFile(const std::string& rom_path);
+	// Reads the file into buffer with a single read. Throws on failure.
+	void readFile(const std::string& rom_path);
+};
@@ -0,0 +1,132 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/savestate.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Reads and writes save states. A save state is one contiguous buffer that
+ every component copies its plain data into, in a fixed order.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace savestate
+{
+	constexpr char MAGIC[4] = {'A', 'B', 'S', 'S'};
+	// Bump whenever anything a component writes changes
+	constexpr uint16_t VERSION = 4;
+
+	struct StateHeader
+	{
+		char magic[4];
+		uint16_t version;
+		// The ROM's checksums and size, so states only load into the game
+		// they came from
+		uint16_t rom_checksum; // Global checksum from the ROM header
+		uint32_t rom_size;
+		uint32_t size; // Whole state in bytes, header included
+		uint8_t header_checksum; // Header checksum from the ROM header
+		uint8_t reserved[3];
+	};
+
+	// Appends plain data to a state buffer. Clearing a reused buffer keeps
+	// its capacity, so saving again doesn't allocate.
+	class StateWriter
+	{
+	public:
+		explicit StateWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+		template<typename T>
+		void write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value,
+						  "Save state values are copied as raw bytes");
+			writeBytes(&value, sizeof(T));
+		}
+
+		void writeBytes(const void* data, size_t size)
+		{
+			size_t offset = buffer.size();
+			buffer.resize(offset + size);
+			std::memcpy(buffer.data() + offset, data, size);
+		}
+
+		size_t size() const { return buffer.size(); }
+
+	private:
+		std::vector<uint8_t>& buffer;
+	};
+
+	// Reads plain data back out of a state buffer, in the order it was
+	// written. Throws if the buffer runs out. Copies are cheap, so a state
+	// can be walked once to check it and again to load it.
+	class StateReader
+	{
+	public:
+		StateReader(const uint8_t* data, size_t size)
+				: data(data), size(size), offset(0) {}
+
+		template<typename T>
+		void read(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value,
+						  "Save state values are copied as raw bytes");
+			readBytes(&value, sizeof(T));
+		}
+
+		// Only 0 and 1 are bools, anything else would be undefined to load
+		void read(bool& value)
+		{
+			uint8_t byte = 0;
+			read(byte);
+			if(byte > 1)
+			{
+				throw std::invalid_argument("Save state has a bad bool.");
+			}
+			value = byte != 0;
+		}
+
+		void readBytes(void* destination, size_t amount)
+		{
+			if(amount > size - offset)
+			{
+				throw std::runtime_error("Save state is truncated.");
+			}
+			std::memcpy(destination, data + offset, amount);
+			offset += amount;
+		}
+
+		// Moves past a value without reading it
+		template<typename T>
+		void skip()
+		{
+			skipBytes(sizeof(T));
+		}
+
+		void skipBytes(size_t amount)
+		{
+			if(amount > size - offset)
+			{
+				throw std::runtime_error("Save state is truncated.");
+			}
+			offset += amount;
+		}
+
+		// Gets how many bytes are left unread
+		size_t remaining() const { return size - offset; }
+
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t offset;
+	};
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/scheduler.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Orders timed hardware events by the absolute cycle they happen on, so the CPU
+ can run in bursts between them instead of ticking components every cycle.
+ ******************************************************************************/
+
+#include "scheduler.hpp"
+
+// Constructor
+Scheduler::Scheduler()
+{
+	// A few more than the event types, so replacing events rarely reallocates
+	heap.reserve(EVENT_TYPE_COUNT * 4);
+	due.fill(NO_EVENT);
+}
+
+
+
+// Schedules an event on an absolute cycle
+void Scheduler::schedule(EventType type, uint64_t cycle)
+{
+	due[type] = cycle;
+
+	heap.push_back({cycle, type});
+	std::push_heap(heap.begin(), heap.end(), later);
+
+	dropStale();
+}
+
+// Drops the pending event of a type
+void Scheduler::cancel(EventType type)
+{
+	due[type] = NO_EVENT;
+	dropStale();
+}
+
+// Drops every pending event
+void Scheduler::clear()
+{
+	heap.clear();
+	due.fill(NO_EVENT);
+}
+
+
+
+// Gets if an event of a type is pending
+bool Scheduler::isScheduled(EventType type) const
+{
+	return due[type] != NO_EVENT;
+}
+
+// Gets the absolute cycle of the next pending event
+uint64_t Scheduler::nextEventCycle() const
+{
+	// dropStale() keeps the top of the heap pending
+	return heap.empty() ? NO_EVENT : heap.front().cycle;
+}
+
+
+
+// Pops the next pending event if it is due on or before cycle
+bool Scheduler::popDue(uint64_t cycle, Event& event)
+{
+	if(heap.empty() || heap.front().cycle > cycle)
+	{
+		return false;
+	}
+
+	event = heap.front();
+	std::pop_heap(heap.begin(), heap.end(), later);
+	heap.pop_back();
+
+	due[event.type] = NO_EVENT;
+	dropStale();
+
+	return true;
+}
+
+
+
+// Writes every pending event into a save state
+void Scheduler::saveState(savestate::StateWriter& state) const
+{
+	// due[] is the whole schedule, the heap can be rebuilt from it
+	state.write(due);
+}
+
+// Replaces every pending event with what saveState() wrote
+void Scheduler::loadState(savestate::StateReader& state)
+{
+	std::array<uint64_t, EVENT_TYPE_COUNT> loaded{};
+	state.read(loaded);
+
+	clear();
+	for(int type = 0; type < EVENT_TYPE_COUNT; type++)
+	{
+		if(loaded[type] != NO_EVENT)
+		{
+			schedule((EventType)type, loaded[type]);
+		}
+	}
+}
+
+// Moves past what saveState() wrote without loading it
+void Scheduler::checkState(savestate::StateReader& state) const
+{
+	state.skip<decltype(due)>();
+}
+
+
+
+// Orders the heap so the earliest event is at the front
+bool Scheduler::later(const Event& a, const Event& b)
+{
+	if(a.cycle != b.cycle)
+	{
+		return a.cycle > b.cycle;
+	}
+
+	return a.type > b.type;
+}
+
+// Pops stale events until the top of the heap is a pending one
+void Scheduler::dropStale()
+{
+	while(!heap.empty() && due[heap.front().type] != heap.front().cycle)
+	{
+		std::pop_heap(heap.begin(), heap.end(), later);
+		heap.pop_back();
+	}
+}
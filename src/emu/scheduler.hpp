@@ -0,0 +1,83 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/scheduler.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Orders timed hardware events by the absolute cycle they happen on, so the CPU
+ can run in bursts between them instead of ticking components every cycle.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "savestate.hpp"
+
+class Scheduler
+{
+public:
+	// Every kind of hardware event. Each type has at most one pending event.
+	// Events due on the same cycle are dispatched in this order.
+	// Serial, DMA and the APU get their own types when they exist. DIV has
+	// none, the MMU works it out from the cycle count when it is read.
+	enum EventType : uint8_t
+	{
+		TIMER_TICK = 0, // TIMA increments, or overflows into TMA. Only
+						// scheduled while TAC enables the timer.
+		PPU_MODE,       // The PPU moves to its next mode or scanline
+
+		EVENT_TYPE_COUNT
+	};
+
+	// An event that is due, as handed out by popDue()
+	struct Event
+	{
+		uint64_t cycle; // Absolute cycle the event was due on
+		EventType type;
+	};
+
+	static constexpr uint64_t NO_EVENT = UINT64_MAX;
+
+	Scheduler();
+
+	// Schedules an event on an absolute cycle, replacing any pending event of
+	// the same type
+	void schedule(EventType type, uint64_t cycle);
+	// Drops the pending event of a type, if there is one
+	void cancel(EventType type);
+	// Drops every pending event
+	void clear();
+
+	// Gets if an event of a type is pending
+	bool isScheduled(EventType type) const;
+	// Gets the absolute cycle of the next pending event, or NO_EVENT
+	uint64_t nextEventCycle() const;
+
+	// Pops the next pending event if it is due on or before cycle. Returns
+	// false if nothing is due.
+	bool popDue(uint64_t cycle, Event& event);
+
+	// Writes every pending event into a save state
+	void saveState(savestate::StateWriter& state) const;
+	// Replaces every pending event with what saveState() wrote
+	void loadState(savestate::StateReader& state);
+	// Moves past what saveState() wrote without loading it. Throws if the
+	// state is cut short.
+	void checkState(savestate::StateReader& state) const;
+
+private:
+	// Min-heap on (cycle, type). Replaced or cancelled events stay in the heap
+	// and are skipped when they reach the top, since due[] no longer matches.
+	std::vector<Event> heap;
+	std::array<uint64_t, EVENT_TYPE_COUNT> due{};
+
+	// Orders the heap so the earliest event is at the front
+	static bool later(const Event& a, const Event& b);
+
+	// Pops stale events until the top of the heap is a pending one
+	void dropStale();
+};
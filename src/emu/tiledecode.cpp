@@ -0,0 +1,142 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/tiledecode.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Decodes the PPU's 2bpp tiles into color indices
+ ******************************************************************************/
+
+#include "tiledecode.hpp"
+
+#include <array>
+#include <cstring>
+
+// SSE2 is part of x86-64, so any 64-bit x86 build can decode with it
+#if defined(__SSE2__) || defined(_M_X64)
+#define ASCIIBOY_SSE2_TILES
+#include <emmintrin.h>
+#endif
+
+// The lookup table is laid out for a little endian host
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ASCIIBOY_BIG_ENDIAN
+#endif
+
+// Decodes bit by bit. The reference the faster decoders are checked against.
+void tiledecode::decodeScalar(const uint8_t* data, uint8_t* pixels)
+{
+	for(int row = 0; row < 8; row++)
+	{
+		uint8_t low = data[row * 2];
+		uint8_t high = data[row * 2 + 1];
+
+		for(int x = 0; x < 8; x++)
+		{
+			int bit = 7 - x;
+			pixels[row * 8 + x] = ((low >> bit) & 1)
+								  | (((high >> bit) & 1) << 1);
+		}
+	}
+}
+
+
+#ifdef ASCIIBOY_SSE2_TILES
+
+// Decodes two rows at a time. Each plane byte is spread across the 8 lanes
+// of its row, then every lane keeps the one bit it stands for.
+static void decodeTileSIMD(const uint8_t* data, uint8_t* pixels)
+{
+	__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+	// Split the planes: the low bytes of all 8 rows, then the high bytes
+	__m128i low = _mm_and_si128(bytes, _mm_set1_epi16(0x00FF));
+	__m128i high = _mm_srli_epi16(bytes, 8);
+	__m128i planes = _mm_packus_epi16(low, high);
+
+	// Repeat each byte until it fills 8 lanes. lows[0] ends up as row 0's
+	// low byte 8 times, then row 1's, and so on.
+	__m128i low_pairs = _mm_unpacklo_epi8(planes, planes);
+	__m128i high_pairs = _mm_unpackhi_epi8(planes, planes);
+	__m128i low_quads[2] = {_mm_unpacklo_epi16(low_pairs, low_pairs),
+							_mm_unpackhi_epi16(low_pairs, low_pairs)};
+	__m128i high_quads[2] = {_mm_unpacklo_epi16(high_pairs, high_pairs),
+							 _mm_unpackhi_epi16(high_pairs, high_pairs)};
+
+	__m128i lows[4];
+	__m128i highs[4];
+	for(int i = 0; i < 2; i++)
+	{
+		lows[i * 2] = _mm_unpacklo_epi32(low_quads[i], low_quads[i]);
+		lows[i * 2 + 1] = _mm_unpackhi_epi32(low_quads[i], low_quads[i]);
+		highs[i * 2] = _mm_unpacklo_epi32(high_quads[i], high_quads[i]);
+		highs[i * 2 + 1] = _mm_unpackhi_epi32(high_quads[i], high_quads[i]);
+	}
+
+	// The bit each lane stands for, leftmost pixel first
+	const __m128i bits = _mm_set_epi8(
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80);
+	const __m128i ones = _mm_set1_epi8(1);
+	const __m128i twos = _mm_set1_epi8(2);
+
+	for(int i = 0; i < 4; i++)
+	{
+		// 0xFF in every lane whose bit is set
+		__m128i low_set = _mm_cmpeq_epi8(_mm_and_si128(lows[i], bits), bits);
+		__m128i high_set = _mm_cmpeq_epi8(_mm_and_si128(highs[i], bits), bits);
+
+		__m128i colors = _mm_or_si128(_mm_and_si128(low_set, ones),
+									  _mm_and_si128(high_set, twos));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 16), colors);
+	}
+}
+
+#elif !defined(ASCIIBOY_BIG_ENDIAN)
+
+// Gets a byte's 8 bits spread into a byte each, leftmost pixel first
+static constexpr std::array<uint64_t, 256> buildSpreadTable()
+{
+	std::array<uint64_t, 256> table{};
+	for(int value = 0; value < 256; value++)
+	{
+		for(int x = 0; x < 8; x++)
+		{
+			uint64_t bit = (value >> (7 - x)) & 1;
+			table[value] |= bit << (x * 8);
+		}
+	}
+	return table;
+}
+
+static constexpr std::array<uint64_t, 256> SPREAD_TABLE = buildSpreadTable();
+
+// Decodes a row at a time with two lookups
+static void decodeTileTable(const uint8_t* data, uint8_t* pixels)
+{
+	for(int row = 0; row < 8; row++)
+	{
+		uint64_t colors = SPREAD_TABLE[data[row * 2]]
+						  | (SPREAD_TABLE[data[row * 2 + 1]] << 1);
+		std::memcpy(pixels + row * 8, &colors, 8);
+	}
+}
+
+#endif
+
+
+// Decodes with the fastest decoder the build has
+void tiledecode::decode(const uint8_t* data, uint8_t* pixels)
+{
+#if defined(ASCIIBOY_SSE2_TILES)
+	decodeTileSIMD(data, pixels);
+#elif defined(ASCIIBOY_BIG_ENDIAN)
+	decodeScalar(data, pixels);
+#else
+	decodeTileTable(data, pixels);
+#endif
+}
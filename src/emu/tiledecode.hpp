@@ -0,0 +1,30 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/tiledecode.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Decodes the PPU's 2bpp tiles into color indices
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+// Each decoder turns a tile's 16 bytes of 2bpp data into 64 color indices,
+// row by row. A row is two bytes: the first holds bit 0 of every pixel's
+// color, the second bit 1, and the leftmost pixel is bit 7.
+namespace tiledecode
+{
+	// Decodes bit by bit. The reference the faster decoders are checked
+	// against, by asciiboy-tilecheck.
+	void decodeScalar(const uint8_t* data, uint8_t* pixels);
+
+	// Decodes with the fastest decoder the build has: SSE2 on x86-64, a
+	// lookup table elsewhere
+	void decode(const uint8_t* data, uint8_t* pixels);
+}
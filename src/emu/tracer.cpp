@@ -0,0 +1,207 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/tracer.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Records executed CPU instructions into a ring buffer for later inspection, and
+ streams them to a compact binary trace file for long runs.
+ ******************************************************************************/
+
+#include "tracer.hpp"
+
+// Constructor
+Tracer::Tracer()
+{
+	head = 0;
+	count = 0;
+	enabled = false;
+
+	trace_file = nullptr;
+	snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL;
+	until_snapshot = 0;
+	next_pc = 0;
+}
+
+// Destructor
+Tracer::~Tracer()
+{
+	closeFile();
+}
+
+
+
+// Allocates the ring buffer and starts recording
+void Tracer::enable(size_t capacity)
+{
+	if(capacity == 0)
+	{
+		throw std::invalid_argument("Trace buffer capacity must not be 0.");
+	}
+
+	// Only reallocate when the size changes, so re-enabling is cheap
+	if(buffer.size() != capacity)
+	{
+		buffer.assign(capacity, TraceRecord{});
+		head = 0;
+		count = 0;
+	}
+
+	enabled = true;
+}
+
+
+
+// Stops recording. Buffered records are kept until clear().
+void Tracer::disable()
+{
+	enabled = false;
+}
+
+
+
+// Starts streaming a binary trace to a file
+void Tracer::openFile(const std::string& path, uint16_t interval)
+{
+	closeFile();
+
+	trace_file = std::fopen(path.c_str(), "wb");
+	if(!trace_file)
+	{
+		throw std::runtime_error("Could not open trace file.");
+	}
+
+	file_buffer.clear();
+	file_buffer.reserve(FILE_BUFFER_SIZE);
+
+	snapshot_interval = interval > 0 ? interval : 1;
+	until_snapshot = 0; // The first instruction always gets a snapshot
+	next_pc = 0;
+
+	traceformat::TraceFileHeader header{};
+	std::copy(std::begin(traceformat::MAGIC), std::end(traceformat::MAGIC),
+			  header.magic);
+	header.version = traceformat::VERSION;
+	header.snapshot_interval = snapshot_interval;
+	writeBytes(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+}
+
+
+
+// Flushes and closes the trace file
+void Tracer::closeFile()
+{
+	if(!trace_file)
+	{
+		return;
+	}
+
+	flushFile();
+	std::fclose(trace_file);
+	trace_file = nullptr;
+}
+
+
+
+// Encodes an instruction, and a register snapshot if one is due
+void Tracer::writeInstruction(const gbstructs::RegisterSet& regs,
+							  uint8_t opcode, uint8_t byte1, uint8_t byte2)
+{
+	uint8_t bytes[16];
+	size_t size = 0;
+
+	if(until_snapshot == 0)
+	{
+		until_snapshot = snapshot_interval;
+
+		bytes[size++] = traceformat::REGISTERS;
+		for(uint16_t reg : {regs.af, regs.bc, regs.de, regs.hl,
+							regs.sp, regs.pc})
+		{
+			bytes[size++] = reg & 0xFF;
+			bytes[size++] = reg >> 8;
+		}
+
+		next_pc = regs.pc;
+	}
+	until_snapshot--;
+
+	// Straight-line code is the common case, and costs no PC bytes at all
+	int delta = (int)regs.pc - (int)next_pc;
+	if(delta == 0)
+	{
+		bytes[size++] = traceformat::INSTRUCTION_NEXT;
+	}
+	else if(delta >= INT8_MIN && delta <= INT8_MAX)
+	{
+		bytes[size++] = traceformat::INSTRUCTION_DELTA;
+		bytes[size++] = (uint8_t)(int8_t)delta;
+	}
+	else
+	{
+		bytes[size++] = traceformat::INSTRUCTION_ABS;
+		bytes[size++] = regs.pc & 0xFF;
+		bytes[size++] = regs.pc >> 8;
+	}
+
+	uint8_t length = gbstructs::OPCODE_INFO[opcode].length;
+	bytes[size++] = opcode;
+	if(length > 1) { bytes[size++] = byte1; }
+	if(length > 2) { bytes[size++] = byte2; }
+
+	next_pc = regs.pc + length;
+
+	writeBytes(bytes, size);
+}
+
+
+
+// Writes the file buffer out
+void Tracer::flushFile()
+{
+	if(trace_file && !file_buffer.empty())
+	{
+		std::fwrite(file_buffer.data(), 1, file_buffer.size(), trace_file);
+	}
+	file_buffer.clear();
+}
+
+
+
+// Discards every buffered record
+void Tracer::clear()
+{
+	head = 0;
+	count = 0;
+}
+
+
+
+// Formats every buffered record into a string, oldest first
+std::string Tracer::dump() const
+{
+	std::string output{};
+
+	output.append("--BEGIN INSTRUCTION TRACE--\n");
+
+	// The oldest record is head when the buffer has wrapped, or 0 if not
+	size_t start = (count < buffer.size()) ? 0 : head;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		const TraceRecord& rec = buffer[(start + i) % buffer.size()];
+
+		output.append(fmt::format("${:04X}: {:<16} {}\n",
+				rec.regs.pc,
+				gbstructs::disassemble(rec.opcode, rec.byte1, rec.byte2),
+				gbstructs::registerToString(rec.regs)));
+	}
+
+	output.append("--END INSTRUCTION TRACE--");
+
+	return output;
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : emu/tracer.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Records executed CPU instructions into a ring buffer for later inspection, and
+ streams them to a compact binary trace file for long runs.
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "gbstructs.hpp"
+
+// One executed instruction. Plain data, so recording it is just a copy.
+struct TraceRecord
+{
+	gbstructs::RegisterSet regs; // Registers before the instruction ran
+	uint8_t opcode;
+	uint8_t byte1; // The two bytes following the opcode
+	uint8_t byte2;
+};
+
+// Binary trace files. Little-endian. A TraceFileHeader, then a stream of
+// records that each start with a TraceTag byte:
+//   INSTRUCTION_NEXT   opcode bytes. PC is the last PC plus its length.
+//   INSTRUCTION_DELTA  int8 PC delta from that prediction, opcode bytes
+//   INSTRUCTION_ABS    uint16 PC, opcode bytes
+//   REGISTERS          af, bc, de, hl, sp, pc as uint16s. Before the
+//                      instruction at pc, which then predicts from pc.
+//   MEMORY_WRITE       uint16 address, uint8 value. From the last instruction.
+// The amount of opcode bytes comes from gbstructs::OPCODE_INFO.
+namespace traceformat
+{
+	constexpr char MAGIC[4] = {'A', 'B', 'T', 'R'};
+	constexpr uint16_t VERSION = 1;
+
+	struct TraceFileHeader
+	{
+		char magic[4];
+		uint16_t version;
+		uint16_t snapshot_interval; // Instructions between REGISTERS records
+	};
+
+	enum TraceTag : uint8_t
+	{
+		INSTRUCTION_NEXT = 0x01,
+		INSTRUCTION_DELTA = 0x02,
+		INSTRUCTION_ABS = 0x03,
+		REGISTERS = 0x04,
+		MEMORY_WRITE = 0x05,
+	};
+}
+
+// The CPU and MMU only call record()/recordWrite() when built with
+// ASCIIBOY_TRACE and the Tracer is enabled. Nothing is formatted until dump()
+// is called, and the trace file is written in large blocks.
+class Tracer
+{
+public:
+	static constexpr size_t DEFAULT_CAPACITY = 4096;
+	static constexpr uint16_t DEFAULT_SNAPSHOT_INTERVAL = 1024;
+
+	Tracer();
+	~Tracer();
+
+	// Allocates the ring buffer and starts recording
+	void enable(size_t capacity = DEFAULT_CAPACITY);
+	// Stops recording. Buffered records are kept until clear().
+	void disable();
+	// Returns if the Tracer is recording to the ring buffer or a file
+	bool isEnabled() const { return enabled || trace_file; }
+
+	// Starts streaming a binary trace to a file, with a register snapshot
+	// every snapshot_interval instructions. Throws if it can't be opened.
+	void openFile(const std::string& path,
+				  uint16_t snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL);
+	// Flushes and closes the trace file
+	void closeFile();
+
+	// Records an instruction, overwriting the oldest once the buffer is full
+	void record(const gbstructs::RegisterSet& regs,
+				uint8_t opcode, uint8_t byte1, uint8_t byte2)
+	{
+		if(enabled)
+		{
+			TraceRecord& rec = buffer[head];
+			rec.regs = regs;
+			rec.opcode = opcode;
+			rec.byte1 = byte1;
+			rec.byte2 = byte2;
+
+			head++;
+			if(head == buffer.size()) { head = 0; }
+			if(count < buffer.size()) { count++; }
+		}
+
+		if(trace_file)
+		{
+			writeInstruction(regs, opcode, byte1, byte2);
+		}
+	}
+
+	// Records a memory write made by the last recorded instruction
+	void recordWrite(uint16_t address, uint8_t value)
+	{
+		if(trace_file)
+		{
+			uint8_t bytes[4] = {traceformat::MEMORY_WRITE,
+								(uint8_t)(address & 0xFF),
+								(uint8_t)(address >> 8), value};
+			writeBytes(bytes, sizeof(bytes));
+		}
+	}
+
+	// Discards every buffered record
+	void clear();
+
+	// Formats every buffered record into a string, oldest first
+	std::string dump() const;
+
+private:
+	std::vector<TraceRecord> buffer;
+	size_t head; // Index the next record is written to
+	size_t count; // Amount of valid records in the buffer
+	bool enabled;
+
+	// Trace file
+	static constexpr size_t FILE_BUFFER_SIZE = 1 << 16;
+	std::FILE* trace_file;
+	std::vector<uint8_t> file_buffer; // Written out whenever it fills up
+	uint16_t snapshot_interval;
+	uint16_t until_snapshot; // Instructions left before the next snapshot
+	uint16_t next_pc; // Where the next instruction is predicted to be
+
+	// Encodes an instruction, and a register snapshot if one is due
+	void writeInstruction(const gbstructs::RegisterSet& regs,
+						  uint8_t opcode, uint8_t byte1, uint8_t byte2);
+	// Appends bytes to the file buffer, writing it out if full
+	void writeBytes(const uint8_t* bytes, size_t amount)
+	{
+		if(file_buffer.size() + amount > FILE_BUFFER_SIZE)
+		{
+			flushFile();
+		}
+		file_buffer.insert(file_buffer.end(), bytes, bytes + amount);
+	}
+	// Writes the file buffer out
+	void flushFile();
+};
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 12 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -13,56 +13,232 @@
 
 #include "main.hpp"
 
-// Debug Stuff. Dump your own ROMs, kids.
-auto gb = std::make_unique<GBSystem>("./roms/Tetris.gb");
+std::unique_ptr<GBSystem> gb;
+std::unique_ptr<RenderThread> renderer;
 
-int main()
+static const char* USAGE =
+        "Usage: ASCII-Boy [rom path] [--headless] [--frames N] "
+        "[--trace-file F] [--engine interpreter|jit] "
+        "[--render ascii|braille|half256|halfrgb]";
+
+int main(int argc, char** argv)
 {
-// Handle exit signals
-#ifdef _WIN32
-    // NOTE: This doesn't seem to work terribly well.
-    SetConsoleCtrlHandler(reinterpret_cast<PHANDLER_ROUTINE>(exitHandler), TRUE);
-#else
+    // Debug Stuff. Dump your own ROMs, kids.
+    std::string rom_path = "./roms/Tetris.gb";
+    // Headless runs unthrottled with no output, for using the emulator as a
+    // simulation engine. frame_limit stops it after that many frames.
+    bool headless = false;
+    long frame_limit = -1;
+    // Streams a binary trace here, for builds with ASCIIBOY_TRACE
+    std::string trace_file_path;
+    // How the CPU runs code. "interpreter" or "jit".
+    std::string engine_name = "interpreter";
+    // How frames are drawn into the terminal. "ascii", "braille", "half256",
+    // or "halfrgb".
+    std::string render_name = "ascii";
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if(arg == "--headless")
+        {
+            headless = true;
+        }
+        else if(arg == "--frames" && i + 1 < argc)
+        {
+            // Nothing is set up yet, so a bad count just stops here
+            const char* count = argv[++i];
+            char* count_end = nullptr;
+            errno = 0;
+            frame_limit = std::strtol(count, &count_end, 10);
+            if(count_end == count || *count_end != '\0' || errno == ERANGE
+               || frame_limit < 0)
+            {
+                ASCIIBOY_LOG(ERRORS, "\"{}\" isn't a frame count.", count);
+                Logger::instance().log(USAGE, Logger::ERRORS);
+                exit(1);
+            }
+        }
+        else if(arg == "--trace-file" && i + 1 < argc)
+        {
+            trace_file_path = argv[++i];
+        }
+        else if(arg == "--engine" && i + 1 < argc)
+        {
+            engine_name = argv[++i];
+        }
+        else if(arg == "--render" && i + 1 < argc)
+        {
+            render_name = argv[++i];
+        }
+        else
+        {
+            rom_path = arg;
+        }
+    }
+
+    gb = std::make_unique<GBSystem>(rom_path);
+
+    if(engine_name == "jit")
+    {
+        if(!gb->cpu.setEngine(CPU::ENGINE_JIT))
+        {
+            Logger::instance().log(
+                    "The JIT isn't available on this build or host. "
+                    "Interpreting instead.", Logger::ERRORS);
+        }
+    }
+    else if(engine_name != "interpreter")
+    {
+        ASCIIBOY_LOG(ERRORS, "Unknown engine \"{}\". Interpreting instead.",
+                     engine_name);
+    }
+
+    // Handle exit signals. The Windows CRT raises SIGINT for Ctrl+C too, and
+    // exitHandler only sets a flag, so it is fine on the thread it uses.
     signal(SIGINT, exitHandler);
-#endif
+    signal(SIGTERM, exitHandler);
 
     programState = RUNNING;
 
 	Logger::instance().log("ASCII-Boy Started.", Logger::VERBOSE);
 
+#ifdef ASCIIBOY_TRACE
+	// Keep the last few thousand instructions around for the exit dump
+	gb->cpu.getTracer().enable();
+
+	if(!trace_file_path.empty())
+	{
+		gb->cpu.getTracer().openFile(trace_file_path);
+	}
+#else
+	if(!trace_file_path.empty())
+	{
+		Logger::instance().log("Tracing needs a build with ASCIIBOY_TRACE.",
+							   Logger::ERRORS);
+	}
+#endif
+
+    // Log messages would land in the middle of the picture, so they only go
+    // to the LogFile while it is drawn
+    uint64_t last_submitted_frame = 0;
+    if(!headless)
+    {
+        TerminalRenderer::Mode render_mode = TerminalRenderer::MODE_ASCII;
+        if(render_name == "braille")
+        {
+            render_mode = TerminalRenderer::MODE_BRAILLE;
+        }
+        else if(render_name == "half256")
+        {
+            render_mode = TerminalRenderer::MODE_HALF_BLOCK_256;
+        }
+        else if(render_name == "halfrgb")
+        {
+            render_mode = TerminalRenderer::MODE_HALF_BLOCK_RGB;
+        }
+        else if(render_name != "ascii")
+        {
+            ASCIIBOY_LOG(ERRORS, "Unknown render mode \"{}\". Using ascii.",
+                         render_name);
+        }
+
+        Logger::instance().setConsoleOutput(false);
+        renderer = std::make_unique<RenderThread>(render_mode);
+    }
+
     using std::this_thread::sleep_for;
     using std::chrono::milliseconds;
+    using Clock = std::chrono::steady_clock;
+
+    // Real-time pacing only. The emulation itself never waits on the clock.
+    FramePacer pacer(gb->getCyclesPerFrame(), gb->getInternalSpeed());
+    ProgramState last_state = programState;
+
+    // Headless throughput reporting
+    long frames_run = 0;
+    auto report_start = Clock::now();
+    uint64_t report_instructions = 0;
+    long report_frames = 0;
 
     while(programState != EXITING)
     {
+        if(exitSignal != 0)
+        {
+            programState = EXITING;
+        }
+
         // TODO: Input handling
 
+        // Time spent paused isn't a stall to catch up on
+        if(programState == RUNNING && last_state != RUNNING)
+        {
+            pacer.start();
+        }
+        last_state = programState;
+
         switch(programState)
         {
         case RUNNING:
         {
-            int cycles_per_frame = gb->getCyclesPerFrame();
+            try {
+                gb->runFrame();
+                frames_run++;
 
-            for(int i = 0; i < cycles_per_frame; i++)
-            {
-                try {
-                    gb->step();
-                    sleep_for(milliseconds(100));
+            } catch(std::invalid_argument& ex) {
+
+                ASCIIBOY_LOG(ERRORS, "!EXCEPTION!: {}", ex.what());
+
+            } catch(std::runtime_error& ex) {
+
+                ASCIIBOY_LOG(ERRORS, "!EXCEPTION!: {}", ex.what());
+
+                programState = STOPPED;
+            }
 
-                } catch(std::invalid_argument& ex) {
+            // Flush battery-backed saves every so often, not every write
+            gb->mem.syncERAMIfDue();
 
-                    Logger::instance().log(
-							fmt::format("!EXCEPTION!: {}", ex.what()),
-							Logger::ERRORS);
+            if(frame_limit >= 0 && frames_run >= frame_limit)
+            {
+                programState = EXITING;
+            }
 
-                } catch(std::runtime_error& ex) {
+            if(headless)
+            {
+                // Report throughput about once a second
+                auto elapsed = std::chrono::duration<double>(
+                        Clock::now() - report_start).count();
+                if(elapsed >= 1.0 || programState != RUNNING)
+                {
+                    uint64_t instructions = gb->getInstructionCount();
+                    ASCIIBOY_LOG(VERBOSE,
+                                 "HEADLESS: {} frames, {:.1f} fps, {:.2f} MIPS",
+                                 frames_run,
+                                 (frames_run - report_frames) / elapsed,
+                                 (instructions - report_instructions)
+                                         / elapsed / 1e6);
 
-					Logger::instance().log(
-							fmt::format("!EXCEPTION!: {}", ex.what()),
-							Logger::ERRORS);
+                    report_start = Clock::now();
+                    report_instructions = instructions;
+                    report_frames = frames_run;
+                }
+            }
+            else
+            {
+                pacer.waitForNextFrame();
 
-					programState = STOPPED;
-				}
+                // Report the pacing about every 10 seconds
+                if(frames_run % 600 == 0)
+                {
+                    ASCIIBOY_LOG(VERBOSE,
+                                 "PACER: {:.3f}ms drift, {} frames skipped, "
+                                 "{} frames too late to draw",
+                                 pacer.getDrift().count() / 1e6,
+                                 pacer.getSkippedFrames(),
+                                 renderer->getDroppedFrames());
+                }
             }
 
             break;
@@ -77,6 +253,7 @@ int main()
         case STOPPED:
         {
             // Destroy the GBSystem and go to prompts/menu
+            closeRenderer();
             gb.reset();
 
             // TODO: Get user prompts
@@ -90,20 +267,66 @@ int main()
 
         } // End Switch
 
-        // TODO: Rendering
+        // Hand each frame over once, as soon as the PPU finishes it. The
+        // render thread draws it whenever the terminal keeps up.
+        if(renderer && gb->ppu.getFrameCount() != last_submitted_frame)
+        {
+            last_submitted_frame = gb->ppu.getFrameCount();
+            renderer->submit(gb->ppu.getFramebuffer());
+        }
     }
 
+    closeRenderer();
+
+    if(exitSignal != 0)
+    {
+        dumpState();
+        ASCIIBOY_LOG(VERBOSE, "ASCII-Boy exited on signal {}.",
+                     (int)exitSignal);
+    }
+
+    // Destroy the GBSystem while the Logger is still around to hear about it
+    gb.reset();
+
 	exit(0);
 }
 
 
-// Safely exits the program when an exit signal is called
+// Asks the main loop to exit when an exit signal is called. Nothing else is
+// safe here: the signal can land while a thread holds the Logger's queue or
+// a frame is half handed to the renderer.
 void exitHandler(int signal)
 {
-    Logger::instance().log(gb->mem.dumpMemory(), Logger::DEBUG);
+    exitSignal = signal;
+}
 
-    Logger::instance().log("ASCII-Boy exited with code " + signal,
-                           Logger::VERBOSE);
 
-    exit(0);
+// Dumps the memory and instruction trace, if DEBUG logging is on
+void dumpState()
+{
+    if(!gb || !Logger::instance().isEnabled(Logger::DEBUG))
+    {
+        return;
+    }
+
+    // The memory dump is long, so it goes straight to stderr instead of
+    // through the log queue
+    Logger::instance().flush();
+    gb->mem.dumpMemory(fileno(stderr), MMU::DUMP_HEX);
+
+    ASCIIBOY_LOG(DEBUG, "{}", gb->cpu.getTracer().dump());
+}
+
+
+// Gives the terminal back, and the console back to the Logger
+void closeRenderer()
+{
+    if(renderer)
+    {
+        renderer.reset();
+
+        // Whatever was logged while drawing stays in the LogFile only
+        Logger::instance().flush();
+        Logger::instance().setConsoleOutput(true);
+    }
 }
\ No newline at end of file
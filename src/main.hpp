@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 3 Dec 2022
- EDITED : 11 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -15,9 +15,15 @@
 
 #include "core.hpp"
 #include "emu/gbsystem.hpp"
+#include "util/framepacer.hpp"
+#include "render/renderthread.hpp"
 
-// Safely exits the program when an exit signal is called
+// Asks the main loop to exit when an exit signal is called
 void exitHandler(int signal);
+// Dumps the memory and instruction trace, if DEBUG logging is on
+void dumpState();
+// Gives the terminal back, and the console back to the Logger
+void closeRenderer();
 
 enum ProgramState
 {
@@ -27,4 +33,8 @@ enum ProgramState
     EXITING, // Program is preparing to exit
 };
 
-ProgramState programState = STOPPED;
\ No newline at end of file
+ProgramState programState = STOPPED;
+
+// The exit signal received, or 0. exitHandler only sets this, and the main
+// loop shuts down outside of the signal handler.
+volatile std::sig_atomic_t exitSignal = 0;
\ No newline at end of file
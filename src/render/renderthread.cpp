@@ -0,0 +1,110 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : render/renderthread.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Draws frames into the terminal on its own thread, so a slow terminal never
+ holds up the emulation
+ ******************************************************************************/
+
+#include "renderthread.hpp"
+#include "../util/signalblock.hpp"
+
+// Constructor
+RenderThread::RenderThread(TerminalRenderer::Mode mode) : renderer(mode)
+{
+	back = 0;
+	front = 1;
+	middle.store(2);
+	dropped_frames = 0;
+
+	drawer_sleeping.store(false);
+	running.store(true);
+	{
+		// Exit signals are handled on the main thread
+		ExitSignalBlock block;
+		drawer = std::thread(&RenderThread::drawerLoop, this);
+	}
+}
+
+// Destructor
+RenderThread::~RenderThread()
+{
+	running.store(false);
+	wake.notify_one();
+	drawer.join();
+
+	// The renderer gives the terminal back once nothing is drawing
+}
+
+
+
+// Hands a finished frame to the render thread
+void RenderThread::submit(const Framebuffer& framebuffer)
+{
+	buffers[back] = framebuffer;
+
+	uint8_t previous = middle.exchange(back | FRESH,
+									   std::memory_order_acq_rel);
+	back = previous & INDEX_MASK;
+
+	if(previous & FRESH)
+	{
+		dropped_frames++;
+	}
+
+	// Notifying doesn't take the mutex, so this can't wait on the drawer
+	if(drawer_sleeping.load(std::memory_order_relaxed))
+	{
+		wake.notify_one();
+	}
+}
+
+
+// Gets how many submitted frames were replaced before being drawn
+uint64_t RenderThread::getDroppedFrames() const
+{
+	return dropped_frames;
+}
+
+
+
+// Render thread loop
+void RenderThread::drawerLoop()
+{
+	while(running.load())
+	{
+		if(middle.load(std::memory_order_acquire) & FRESH)
+		{
+			uint8_t previous = middle.exchange(front,
+											   std::memory_order_acq_rel);
+			front = previous & INDEX_MASK;
+
+			renderer.draw(buffers[front]);
+			continue;
+		}
+
+		// Nothing new. Sleep until a frame is submitted. The timeout covers
+		// one that lands between the check and the wait, and is short enough
+		// that such a frame is still drawn in time.
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		drawer_sleeping.store(true);
+		wake.wait_for(lock, std::chrono::milliseconds(4), [this]() {
+			return !running.load()
+				   || (middle.load(std::memory_order_acquire) & FRESH);
+		});
+		drawer_sleeping.store(false);
+	}
+
+	// Draw the last frame on exit
+	if(middle.load(std::memory_order_acquire) & FRESH)
+	{
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		renderer.draw(buffers[front]);
+	}
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : render/renderthread.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Draws frames into the terminal on its own thread, so a slow terminal never
+ holds up the emulation
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "terminal.hpp"
+
+#include <atomic>
+#include <condition_variable>
+
+// Frames are handed over through a triple buffer. The emulation fills the
+// back buffer and swaps it with the middle one, the render thread swaps the
+// middle one with the front buffer it draws from. Neither side ever waits on
+// the other. A frame still in the middle when the next one is submitted was
+// never drawn, and is dropped: the terminal only sees the newest frame.
+class RenderThread
+{
+public:
+	using Framebuffer = TerminalRenderer::Framebuffer;
+
+	// Takes over the terminal and starts drawing
+	explicit RenderThread(TerminalRenderer::Mode mode);
+	// Stops drawing and gives the terminal back
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// Hands a finished frame to the render thread. Never blocks. Only call
+	// from one thread.
+	void submit(const Framebuffer& framebuffer);
+
+	// Gets how many submitted frames were replaced before being drawn
+	uint64_t getDroppedFrames() const;
+
+private:
+	// Marks the middle buffer as submitted but not yet drawn
+	static constexpr uint8_t FRESH = 0x04;
+	static constexpr uint8_t INDEX_MASK = 0x03;
+
+	TerminalRenderer renderer;
+
+	std::array<Framebuffer, 3> buffers{};
+	int back;  // Only used by the emulation
+	int front; // Only used by the render thread
+	// The buffer between the two, with FRESH if it holds an undrawn frame
+	std::atomic<uint8_t> middle;
+
+	uint64_t dropped_frames;
+
+	std::thread drawer;
+	std::atomic<bool> running;
+	std::atomic<bool> drawer_sleeping;
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+
+	// Render thread loop
+	void drawerLoop();
+};
@@ -0,0 +1,543 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : render/terminal.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Draws the PPU's framebuffer into the terminal as characters
+ ******************************************************************************/
+
+#include "terminal.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+
+// Characters from the darkest block to the brightest. Shade 0 is the lightest
+// Gameboy color, and on a dark terminal that needs the densest character.
+static constexpr char RAMP[] = " .:-=+*#%@";
+static constexpr int RAMP_LENGTH = sizeof(RAMP) - 1;
+
+// The highest a 2x4 cell's shades can add up to
+static constexpr int MAX_CELL_SHADE = 3 * 2 * 4;
+
+// Gets the character for every total of a cell's shades
+static constexpr std::array<char, MAX_CELL_SHADE + 1> buildShadeTable()
+{
+	std::array<char, MAX_CELL_SHADE + 1> table{};
+	for(int total = 0; total <= MAX_CELL_SHADE; total++)
+	{
+		int brightness = MAX_CELL_SHADE - total;
+		table[total] = RAMP[brightness * (RAMP_LENGTH - 1) / MAX_CELL_SHADE];
+	}
+	return table;
+}
+
+static constexpr std::array<char, MAX_CELL_SHADE + 1> SHADE_TABLE =
+		buildShadeTable();
+
+
+// The dot each pixel of a 2x4 cell stands for, by row, then by which of the
+// row's two pixels are lit. Braille numbers its dots down the left column
+// first, with the bottom row added later.
+static constexpr uint8_t BRAILLE_DOTS[4][4] = {
+	{0x00, 0x01, 0x08, 0x09},
+	{0x00, 0x02, 0x10, 0x12},
+	{0x00, 0x04, 0x20, 0x24},
+	{0x00, 0x40, 0x80, 0xC0},
+};
+
+// Gets the UTF-8 for every braille pattern, U+2800 to U+28FF
+static constexpr std::array<std::array<char, 3>, 256> buildBrailleTable()
+{
+	std::array<std::array<char, 3>, 256> table{};
+	for(int dots = 0; dots < 256; dots++)
+	{
+		int codepoint = 0x2800 + dots;
+		table[dots][0] = (char)(0xE0 | (codepoint >> 12));
+		table[dots][1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		table[dots][2] = (char)(0x80 | (codepoint & 0x3F));
+	}
+	return table;
+}
+
+static constexpr std::array<std::array<char, 3>, 256> BRAILLE_TABLE =
+		buildBrailleTable();
+
+
+// Half blocks, in UTF-8
+static constexpr char UPPER_HALF[] = "▀";
+static constexpr char LOWER_HALF[] = "▄";
+static constexpr char FULL_BLOCK[] = "█";
+
+
+// Gets the closest color of the xterm 256 color palette. Skips the first 16,
+// which terminals often change.
+static int getXtermColor(const TerminalRenderer::Color& color)
+{
+	// The 6x6x6 cube's levels
+	static constexpr int LEVELS[6] = {0, 95, 135, 175, 215, 255};
+
+	auto distance = [&color](int r, int g, int b) {
+		return (color.r - r) * (color.r - r) + (color.g - g) * (color.g - g)
+			   + (color.b - b) * (color.b - b);
+	};
+	auto closest_level = [](int value) {
+		int best = 0;
+		for(int i = 1; i < 6; i++)
+		{
+			if(std::abs(value - LEVELS[i]) < std::abs(value - LEVELS[best]))
+			{
+				best = i;
+			}
+		}
+		return best;
+	};
+
+	int r = closest_level(color.r);
+	int g = closest_level(color.g);
+	int b = closest_level(color.b);
+	int best = 16 + r * 36 + g * 6 + b;
+	int best_distance = distance(LEVELS[r], LEVELS[g], LEVELS[b]);
+
+	// The 24 grays
+	for(int i = 0; i < 24; i++)
+	{
+		int gray = 8 + i * 10;
+		if(distance(gray, gray, gray) < best_distance)
+		{
+			best = 232 + i;
+			best_distance = distance(gray, gray, gray);
+		}
+	}
+
+	return best;
+}
+
+
+// Appends a number in decimal, without allocating
+static void appendNumber(std::string& text, int value)
+{
+	char digits[12];
+	int length = 0;
+	do
+	{
+		digits[length++] = '0' + value % 10;
+		value /= 10;
+	} while(value > 0);
+
+	while(length > 0)
+	{
+		text.push_back(digits[--length]);
+	}
+}
+
+
+
+// Constructor
+TerminalRenderer::TerminalRenderer(Mode mode)
+{
+	last_frame_size = 0;
+	palette = DMG_PALETTE;
+
+#ifdef _WIN32
+	// The console only follows escape sequences and UTF-8 when asked to
+	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD console_mode = 0;
+	if(GetConsoleMode(console, &console_mode))
+	{
+		SetConsoleMode(console,
+					   console_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	}
+	SetConsoleOutputCP(CP_UTF8);
+#endif
+
+	// Hide the cursor. setMode() has the first draw() clear the screen.
+	send("\x1b[?25l");
+	setMode(mode);
+}
+
+// Destructor
+TerminalRenderer::~TerminalRenderer()
+{
+	// Reset the colors, leave the cursor under the picture, and show it
+	output = "\x1b[0m";
+	appendMove(rows, 0);
+	output += "\x1b[?25h";
+	send(output);
+}
+
+
+
+// Draws a frame of shades, sending only the cells that changed
+void TerminalRenderer::draw(const Framebuffer& framebuffer)
+{
+	switch(mode)
+	{
+	case MODE_ASCII:
+		buildASCIICells(framebuffer);
+		break;
+	case MODE_BRAILLE:
+		buildBrailleCells(framebuffer);
+		break;
+	case MODE_HALF_BLOCK_256:
+	case MODE_HALF_BLOCK_RGB:
+		buildHalfBlockCells(framebuffer);
+		break;
+	}
+
+	output.clear();
+
+	if(clear_pending)
+	{
+		// Also resets the colors, so they are unknown until set again
+		output += "\x1b[0m\x1b[2J";
+		foreground = -1;
+		background = -1;
+		clear_pending = false;
+	}
+
+	// Where the terminal's cursor is. A character moves it one cell right.
+	int cursor_row = -1;
+	int cursor_column = -1;
+
+	for(int row = 0; row < rows; row++)
+	{
+		const uint8_t* line = cells.data() + row * columns;
+		const uint8_t* previous_line = previous.data() + row * columns;
+
+		for(int column = 0; column < columns; column++)
+		{
+			if(!full_redraw && line[column] == previous_line[column])
+			{
+				continue;
+			}
+
+			if(row == cursor_row
+			   && column - cursor_column <= max_rewritten_gap)
+			{
+				for(int i = cursor_column; i < column; i++)
+				{
+					appendCell(line[i]);
+				}
+			}
+			else
+			{
+				appendMove(row, column);
+			}
+
+			appendCell(line[column]);
+			cursor_row = row;
+			cursor_column = column + 1;
+		}
+	}
+
+	previous.swap(cells);
+	full_redraw = false;
+	last_frame_size = output.size();
+
+	if(!output.empty())
+	{
+		send(output);
+	}
+}
+
+
+// Makes the next draw() send every cell
+void TerminalRenderer::invalidate()
+{
+	full_redraw = true;
+}
+
+
+
+// Switches modes
+void TerminalRenderer::setMode(Mode mode)
+{
+	this->mode = mode;
+
+	if(mode == MODE_ASCII || mode == MODE_BRAILLE)
+	{
+		columns = PPU::WIDTH / 2;
+		rows = PPU::HEIGHT / 4;
+	}
+	else
+	{
+		columns = PPU::WIDTH;
+		rows = PPU::HEIGHT / 2;
+	}
+
+	// How many cells cost less to send again than a cursor move. A braille
+	// pattern is 3 bytes, and a half block is 3 plus any color changes.
+	switch(mode)
+	{
+	case MODE_ASCII:
+		max_rewritten_gap = 5;
+		break;
+	case MODE_BRAILLE:
+		max_rewritten_gap = 2;
+		break;
+	default:
+		max_rewritten_gap = 1;
+		break;
+	}
+
+	cells.assign(columns * rows, 0);
+	previous.assign(columns * rows, 0);
+	full_redraw = true;
+	clear_pending = true;
+
+	buildColorTables();
+}
+
+// Gets the current mode
+TerminalRenderer::Mode TerminalRenderer::getMode() const
+{
+	return mode;
+}
+
+
+// Sets the colors of the shades
+void TerminalRenderer::setPalette(const Palette& palette)
+{
+	this->palette = palette;
+	buildColorTables();
+	full_redraw = true;
+}
+
+
+
+// Gets the width of the picture in cells
+int TerminalRenderer::getColumns() const
+{
+	return columns;
+}
+
+// Gets the height of the picture in cells
+int TerminalRenderer::getRows() const
+{
+	return rows;
+}
+
+// Gets how many bytes the last draw() sent
+size_t TerminalRenderer::getLastFrameSize() const
+{
+	return last_frame_size;
+}
+
+
+
+// Cell Builders //
+
+void TerminalRenderer::buildASCIICells(const Framebuffer& framebuffer)
+{
+	for(int row = 0; row < rows; row++)
+	{
+		const uint8_t* pixels = framebuffer.data() + row * 4 * PPU::WIDTH;
+
+		for(int column = 0; column < columns; column++)
+		{
+			const uint8_t* block = pixels + column * 2;
+			int total = 0;
+			for(int y = 0; y < 4; y++)
+			{
+				total += block[y * PPU::WIDTH] + block[y * PPU::WIDTH + 1];
+			}
+
+			cells[row * columns + column] = total;
+		}
+	}
+}
+
+
+void TerminalRenderer::buildBrailleCells(const Framebuffer& framebuffer)
+{
+	for(int row = 0; row < rows; row++)
+	{
+		const uint8_t* pixels = framebuffer.data() + row * 4 * PPU::WIDTH;
+
+		for(int column = 0; column < columns; column++)
+		{
+			const uint8_t* block = pixels + column * 2;
+			uint8_t dots = 0;
+			for(int y = 0; y < 4; y++)
+			{
+				int pair = lit[block[y * PPU::WIDTH]]
+						   | (lit[block[y * PPU::WIDTH + 1]] << 1);
+				dots |= BRAILLE_DOTS[y][pair];
+			}
+
+			cells[row * columns + column] = dots;
+		}
+	}
+}
+
+
+void TerminalRenderer::buildHalfBlockCells(const Framebuffer& framebuffer)
+{
+	for(int row = 0; row < rows; row++)
+	{
+		const uint8_t* top = framebuffer.data() + row * 2 * PPU::WIDTH;
+		const uint8_t* bottom = top + PPU::WIDTH;
+		uint8_t* line = cells.data() + row * columns;
+
+		for(int column = 0; column < columns; column++)
+		{
+			line[column] = top[column] | (bottom[column] << 2);
+		}
+	}
+}
+
+
+// Rebuilds the tables that depend on the palette and mode
+void TerminalRenderer::buildColorTables()
+{
+	for(int shade = 0; shade < 4; shade++)
+	{
+		const Color& color = palette[shade];
+
+		// Braille lights the brighter half of the shades
+		int luma = color.r * 299 + color.g * 587 + color.b * 114;
+		lit[shade] = luma >= 128 * 1000 ? 1 : 0;
+
+		for(int layer = 0; layer < 2; layer++)
+		{
+			std::string& escape = layer == 0 ? foreground_colors[shade]
+											 : background_colors[shade];
+			escape = layer == 0 ? "\x1b[38;" : "\x1b[48;";
+
+			if(mode == MODE_HALF_BLOCK_RGB)
+			{
+				escape += "2;";
+				appendNumber(escape, color.r);
+				escape += ';';
+				appendNumber(escape, color.g);
+				escape += ';';
+				appendNumber(escape, color.b);
+			}
+			else
+			{
+				escape += "5;";
+				appendNumber(escape, getXtermColor(color));
+			}
+			escape += 'm';
+		}
+	}
+
+	// The terminal's colors no longer mean the same shades
+	foreground = -1;
+	background = -1;
+}
+
+// End Cell Builders //
+
+
+
+// Appends a cell's character, along with any color changes it needs
+void TerminalRenderer::appendCell(uint8_t key)
+{
+	switch(mode)
+	{
+	case MODE_ASCII:
+		output.push_back(SHADE_TABLE[key]);
+		break;
+	case MODE_BRAILLE:
+		output.append(BRAILLE_TABLE[key].data(), 3);
+		break;
+	case MODE_HALF_BLOCK_256:
+	case MODE_HALF_BLOCK_RGB:
+		appendHalfBlock(key & 0b11, key >> 2);
+		break;
+	}
+}
+
+
+// Appends a half block cell
+void TerminalRenderer::appendHalfBlock(int top, int bottom)
+{
+	// A solid cell is a space in the background color, or a full block in the
+	// foreground color
+	if(top == bottom)
+	{
+		if(top == background)
+		{
+			output.push_back(' ');
+		}
+		else if(top == foreground)
+		{
+			output += FULL_BLOCK;
+		}
+		else
+		{
+			output += background_colors[top];
+			background = top;
+			output.push_back(' ');
+		}
+		return;
+	}
+
+	// The upper half needs the top pixel in front, the lower half the bottom
+	// one. Whichever is closer to the current colors wins.
+	int upper_changes = (foreground != top) + (background != bottom);
+	int lower_changes = (foreground != bottom) + (background != top);
+
+	int front = upper_changes <= lower_changes ? top : bottom;
+	int back = upper_changes <= lower_changes ? bottom : top;
+
+	if(foreground != front)
+	{
+		output += foreground_colors[front];
+		foreground = front;
+	}
+	if(background != back)
+	{
+		output += background_colors[back];
+		background = back;
+	}
+
+	output += upper_changes <= lower_changes ? UPPER_HALF : LOWER_HALF;
+}
+
+
+// Appends an escape sequence that moves the cursor to a cell
+void TerminalRenderer::appendMove(int row, int column)
+{
+	// Terminals count from 1
+	output += "\x1b[";
+	appendNumber(output, row + 1);
+	output += ';';
+	appendNumber(output, column + 1);
+	output += 'H';
+}
+
+
+// Sends text to the terminal, in one write unless the terminal takes it in
+// pieces
+void TerminalRenderer::send(const std::string& text)
+{
+	const char* data = text.data();
+	size_t left = text.size();
+
+	while(left > 0)
+	{
+#ifdef _WIN32
+		int written = _write(1, data, (unsigned int)left);
+#else
+		ssize_t written = write(STDOUT_FILENO, data, left);
+#endif
+		if(written < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return; // Nowhere to draw to
+		}
+
+		data += written;
+		left -= written;
+	}
+}
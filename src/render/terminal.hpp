@@ -0,0 +1,130 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : render/terminal.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Draws the PPU's framebuffer into the terminal as characters
+ ******************************************************************************/
+
+#pragma once
+
+#include "../core.hpp"
+#include "../emu/ppu.hpp"
+
+// Each character cell stands for a block of pixels. How a block becomes a
+// character depends on the mode. The last frame's cells are kept, and only
+// the ones that changed are sent, each run after a cursor move. A frame is
+// sent with a single write.
+class TerminalRenderer
+{
+public:
+	using Framebuffer = std::array<uint8_t, PPU::WIDTH * PPU::HEIGHT>;
+
+	enum Mode
+	{
+		// 2x4 pixels a cell, as characters from a brightness ramp. Works on
+		// any terminal.
+		MODE_ASCII,
+		// 2x4 pixels a cell, as the dots of a braille pattern. Each pixel is
+		// either lit or not.
+		MODE_BRAILLE,
+		// 1x2 pixels a cell, as upper or lower half blocks with the two
+		// pixels' colors as foreground and background
+		MODE_HALF_BLOCK_256,    // From the xterm 256 color palette
+		MODE_HALF_BLOCK_RGB,    // In 24-bit color
+	};
+
+	struct Color
+	{
+		uint8_t r;
+		uint8_t g;
+		uint8_t b;
+	};
+
+	// Colors of shades 0 to 3
+	using Palette = std::array<Color, 4>;
+	static constexpr Palette DMG_PALETTE = {{
+		{224, 248, 208}, {136, 192, 112}, {52, 104, 86}, {8, 24, 32},
+	}};
+
+	// Takes over the terminal: hides the cursor and clears the screen
+	TerminalRenderer(Mode mode = MODE_ASCII);
+	// Gives the terminal back
+	~TerminalRenderer();
+
+	TerminalRenderer(const TerminalRenderer&) = delete;
+	TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+	// Draws a frame of shades, sending only the cells that changed
+	void draw(const Framebuffer& framebuffer);
+	// Makes the next draw() send every cell, for when the screen was changed
+	// behind the renderer's back
+	void invalidate();
+
+	// Switches modes. The next draw() clears the screen and starts over.
+	void setMode(Mode mode);
+	Mode getMode() const;
+	// Sets the colors of the shades, which the color modes draw with and the
+	// braille mode decides which pixels are lit by
+	void setPalette(const Palette& palette);
+
+	// Gets the size of the picture in cells
+	int getColumns() const;
+	int getRows() const;
+	// Gets how many bytes the last draw() sent
+	size_t getLastFrameSize() const;
+
+private:
+	Mode mode;
+	Palette palette;
+
+	// Set by setMode()
+	int columns;
+	int rows;
+	// A gap of unchanged cells this short is sent again instead of jumping
+	// over it, since a cursor move takes at least 6 bytes
+	int max_rewritten_gap;
+
+	// One key per cell, which is all that is needed to pick its character:
+	// the total of its shades in MODE_ASCII, its dots in MODE_BRAILLE, and
+	// its top shade plus 4 times its bottom shade in the half block modes
+	std::vector<uint8_t> cells;
+	std::vector<uint8_t> previous;
+	bool full_redraw;
+	bool clear_pending;
+
+	// Tables rebuilt with the palette
+	std::array<uint8_t, 4> lit{};                 // Braille dots per shade
+	std::array<std::string, 4> foreground_colors; // Escape sequence per shade
+	std::array<std::string, 4> background_colors;
+
+	// The shades the terminal is drawing half blocks with, -1 when unknown
+	int foreground;
+	int background;
+
+	// The frame being sent. Kept, so its memory is reused.
+	std::string output;
+	size_t last_frame_size;
+
+	// Fill cells from a frame, one for each mode
+	void buildASCIICells(const Framebuffer& framebuffer);
+	void buildBrailleCells(const Framebuffer& framebuffer);
+	void buildHalfBlockCells(const Framebuffer& framebuffer);
+	// Rebuilds the tables that depend on the palette and mode
+	void buildColorTables();
+
+	// Appends a cell's character, along with any color changes it needs
+	void appendCell(uint8_t key);
+	// Appends a half block cell, picking whichever character needs the
+	// fewest color changes
+	void appendHalfBlock(int top, int bottom);
+	// Appends an escape sequence that moves the cursor to a cell
+	void appendMove(int row, int column);
+	// Sends text to the terminal
+	static void send(const std::string& text);
+};
@@ -0,0 +1,256 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : tools/rewindcheck.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ asciiboy-rewindcheck: Checks the Rewinder's delta coding round trips, and
+ that rewinding through a ring small enough to wrap around and drop
+ keyframes gives back exactly what saveState() made. Run by ctest.
+ ******************************************************************************/
+
+#include "../emu/rewind.hpp"
+
+#include <random>
+
+static std::mt19937 rng(1);
+
+// Encodes data against base (or nothing), decodes it back, and checks it
+static bool checkRoundTrip(const char* name,
+						   const std::vector<uint8_t>& data,
+						   const std::vector<uint8_t>* base)
+{
+	std::vector<uint8_t> encoded;
+	Rewinder::encode(data, base, encoded);
+
+	std::vector<uint8_t> decoded = base ? *base
+										: std::vector<uint8_t>(data.size(), 0);
+	Rewinder::applyDelta(encoded.data() + sizeof(uint32_t),
+						 encoded.size() - sizeof(uint32_t), decoded);
+
+	if(decoded != data)
+	{
+		std::fprintf(stderr, "Delta round trip failed for %s.\n", name);
+		return false;
+	}
+	return true;
+}
+
+// Gets size random bytes
+static std::vector<uint8_t> randomBytes(size_t size)
+{
+	std::vector<uint8_t> bytes(size);
+	for(uint8_t& byte : bytes)
+	{
+		byte = rng() & 0xFF;
+	}
+	return bytes;
+}
+
+// Checks encode() and applyDelta() on random, sparse, and edge case buffers
+static bool checkDeltas()
+{
+	bool passed = true;
+
+	// Odd sizes too, so the word-at-a-time zero skip has a tail
+	for(size_t size : {0, 1, 7, 8, 9, 4096, 25209})
+	{
+		std::vector<uint8_t> base = randomBytes(size);
+		std::vector<uint8_t> data = randomBytes(size);
+
+		passed &= checkRoundTrip("random keyframe", data, nullptr);
+		passed &= checkRoundTrip("random delta", data, &base);
+		passed &= checkRoundTrip("unchanged", base, &base);
+		passed &= checkRoundTrip("all zeros",
+								 std::vector<uint8_t>(size, 0), nullptr);
+
+		if(size == 0)
+		{
+			continue;
+		}
+
+		// A few changes with zero gaps of every length around MIN_ZERO_RUN,
+		// and the first and last bytes, which start and end runs
+		std::vector<uint8_t> sparse = base;
+		sparse.front() ^= 0x01;
+		sparse.back() ^= 0x80;
+		size_t position = 0;
+		for(size_t gap = 1; position + gap < size; gap = gap % 9 + 1)
+		{
+			position += gap;
+			sparse[position] ^= (rng() & 0xFF) | 1;
+			if(gap == 9)
+			{
+				position += 512;
+			}
+		}
+		passed &= checkRoundTrip("sparse delta", sparse, &base);
+	}
+
+	return passed;
+}
+
+
+
+// A ROM that keeps incrementing the first 1KB of WRAM, so every snapshot has
+// something to delta
+static std::string writeTestROM()
+{
+	std::vector<uint8_t> rom(0x8000, 0);
+
+	const uint8_t entry[] = {0x00, 0xC3, 0x50, 0x01}; // NOP; JP $0150
+	const uint8_t code[] = {
+		0x21, 0x00, 0xC0, // LD HL,$C000
+		0x34,             // INC (HL)
+		0x23,             // INC HL
+		0x7C,             // LD A,H
+		0xFE, 0xC4,       // CP $C4
+		0x20, 0xF9,       // JR NZ,$0153
+		0x18, 0xF4,       // JR $0150
+	};
+	std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+	std::copy(std::begin(code), std::end(code), rom.begin() + 0x150);
+
+	const char title[] = "REWINDCHECK";
+	std::copy(std::begin(title), std::end(title) - 1, rom.begin() + 0x134);
+
+	uint8_t checksum = 0;
+	for(int address = 0x134; address < 0x14D; address++)
+	{
+		checksum = checksum - rom[address] - 1;
+	}
+	rom[0x14D] = checksum;
+
+	std::string path = (std::filesystem::temp_directory_path()
+						/ "asciiboy-rewindcheck.gb").string();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+	return path;
+}
+
+// Runs frames, snapshotting every one, and keeps what saveState() gave for
+// each in history
+static void runFrames(GBSystem& gb, Rewinder& rewinder, int frames,
+					  std::vector<std::vector<uint8_t>>& history)
+{
+	for(int frame = 0; frame < frames; frame++)
+	{
+		gb.runFrame();
+		rewinder.onFrame(gb);
+
+		history.emplace_back();
+		gb.saveState(history.back());
+	}
+}
+
+// Rewinds amount snapshots, checking each against history
+static bool rewindAndCheck(GBSystem& gb, Rewinder& rewinder, size_t amount,
+						   std::vector<std::vector<uint8_t>>& history)
+{
+	std::vector<uint8_t> state;
+	for(size_t i = 0; i < amount; i++)
+	{
+		if(!rewinder.rewind(gb))
+		{
+			std::fprintf(stderr, "Ran out of snapshots early.\n");
+			return false;
+		}
+
+		gb.saveState(state);
+		if(state != history.back())
+		{
+			std::fprintf(stderr, "Rewinding gave back a different state, %zu "
+						 "snapshots from the newest.\n", i);
+			return false;
+		}
+		history.pop_back();
+	}
+	return true;
+}
+
+// Rewinds through a ring that has wrapped around and dropped keyframes
+static bool checkRewinder(const std::string& rom_path)
+{
+	GBSystem gb(rom_path);
+
+	// Deltas here are about as big as keyframes, so a ring of 24 keyframes
+	// holds a few groups of SNAPSHOTS_PER_KEYFRAME, and FRAMES wraps it
+	// around several times
+	Rewinder probe(Rewinder::DEFAULT_BUFFER_SIZE, 1, 1);
+	gb.runFrame();
+	probe.onFrame(gb);
+	size_t buffer_size = probe.getBytesUsed() * 24;
+
+	constexpr int FRAMES = 120;
+	constexpr int SNAPSHOTS_PER_KEYFRAME = 4;
+	Rewinder rewinder(buffer_size, 1, SNAPSHOTS_PER_KEYFRAME);
+	std::vector<std::vector<uint8_t>> history;
+
+	runFrames(gb, rewinder, FRAMES, history);
+	if(rewinder.getSnapshotAmount() >= (size_t)FRAMES
+	   || rewinder.getBytesUsed() > buffer_size)
+	{
+		std::fprintf(stderr, "The ring never filled up and dropped a "
+					 "keyframe.\n");
+		return false;
+	}
+
+	// Go part of the way back, so new deltas are made against an older
+	// keyframe, then run on and fill the ring again
+	if(!rewindAndCheck(gb, rewinder, rewinder.getSnapshotAmount() / 2,
+					   history))
+	{
+		return false;
+	}
+	runFrames(gb, rewinder, FRAMES, history);
+
+	// Everything still held has to come back exactly, across more than one
+	// keyframe
+	size_t held = rewinder.getSnapshotAmount();
+	if(held <= (size_t)SNAPSHOTS_PER_KEYFRAME)
+	{
+		std::fprintf(stderr, "The ring only holds %zu snapshots.\n", held);
+		return false;
+	}
+	if(!rewindAndCheck(gb, rewinder, held, history))
+	{
+		return false;
+	}
+	if(rewinder.rewind(gb))
+	{
+		std::fprintf(stderr, "Rewound past the last snapshot.\n");
+		return false;
+	}
+
+	std::printf("Rewound through %zu snapshots in a %zu byte ring.\n",
+				held, buffer_size);
+	return true;
+}
+
+
+
+int main()
+{
+	bool passed = checkDeltas();
+	if(passed)
+	{
+		std::printf("Delta coding round trips.\n");
+	}
+
+	std::string rom_path = writeTestROM();
+	try {
+		passed &= checkRewinder(rom_path);
+
+	} catch(std::exception& ex) {
+
+		std::fprintf(stderr, "!EXCEPTION!: %s\n", ex.what());
+		passed = false;
+	}
+	std::filesystem::remove(rom_path);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : tools/tilecheck.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ asciiboy-tilecheck: Checks the PPU's fast tile decoder against the reference
+ for every pair of plane bytes. Run by ctest.
+ ******************************************************************************/
+
+#include "../emu/tiledecode.hpp"
+
+#include <array>
+#include <cstdio>
+
+int main()
+{
+	std::array<uint8_t, 16> data{};
+	std::array<uint8_t, 64> expected{};
+	std::array<uint8_t, 64> actual{};
+
+	// 8 pairs to a tile, one in each row
+	for(int first = 0; first < 0x10000; first += 8)
+	{
+		for(int row = 0; row < 8; row++)
+		{
+			int pair = first + row;
+			data[row * 2] = pair & 0xFF;
+			data[row * 2 + 1] = pair >> 8;
+		}
+
+		tiledecode::decodeScalar(data.data(), expected.data());
+		tiledecode::decode(data.data(), actual.data());
+		if(expected != actual)
+		{
+			std::fprintf(stderr, "Tile decoders disagree on the tile starting "
+						 "with plane bytes %04X.\n", first);
+			return 1;
+		}
+	}
+
+	std::printf("Tile decoders agree on all 65536 pairs of plane bytes.\n");
+	return 0;
+}
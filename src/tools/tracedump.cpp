@@ -0,0 +1,191 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : tools/tracedump.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ asciiboy-tracedump: Disassembles a binary trace file from --trace-file back
+ into text. Usage: asciiboy-tracedump <trace file> [output file]
+ ******************************************************************************/
+
+#include "../core.hpp"
+#include "../emu/gbstructs.hpp"
+#include "../emu/tracer.hpp"
+
+// Reads little-endian values from the trace, through stdio's buffering
+class TraceReader
+{
+public:
+	explicit TraceReader(std::FILE* file) : file(file) {}
+
+	// Returns false at the end of the file
+	bool readByte(uint8_t& value)
+	{
+		int c = std::getc(file);
+		value = (uint8_t)c;
+		return c != EOF;
+	}
+
+	bool readShort(uint16_t& value)
+	{
+		uint8_t lsb = 0;
+		uint8_t msb = 0;
+		bool ok = readByte(lsb) && readByte(msb);
+		value = emath::bytesToUShort(msb, lsb);
+		return ok;
+	}
+
+private:
+	std::FILE* file;
+};
+
+
+
+int main(int argc, char** argv)
+{
+	using namespace traceformat;
+
+	if(argc < 2)
+	{
+		std::cerr << "Usage: asciiboy-tracedump <trace file> [output file]\n";
+		return 64; // EX_USAGE
+	}
+
+	std::FILE* input = std::fopen(argv[1], "rb");
+	if(!input)
+	{
+		std::cerr << "ERROR: Cannot open trace file " << argv[1] << "\n";
+		return 66; // EX_NOINPUT
+	}
+
+	std::FILE* output = stdout;
+	if(argc > 2)
+	{
+		output = std::fopen(argv[2], "w");
+		if(!output)
+		{
+			std::cerr << "ERROR: Cannot open output file " << argv[2] << "\n";
+			return 73; // EX_CANTCREAT
+		}
+	}
+
+	TraceFileHeader header{};
+	if(std::fread(&header, sizeof(header), 1, input) != 1
+	   || !std::equal(std::begin(MAGIC), std::end(MAGIC), header.magic))
+	{
+		std::cerr << "ERROR: Not an ASCII-Boy trace file.\n";
+		return 65; // EX_DATAERR
+	}
+	if(header.version != VERSION)
+	{
+		std::cerr << "ERROR: Unsupported trace version " << header.version
+				  << ", expected " << VERSION << ".\n";
+		return 65;
+	}
+
+	TraceReader reader(input);
+	std::string text;
+	uint16_t next_pc = 0;
+	uint64_t instructions = 0;
+
+	uint8_t tag = 0;
+	while(reader.readByte(tag))
+	{
+		bool ok = true;
+
+		switch(tag)
+		{
+		case INSTRUCTION_NEXT:
+		case INSTRUCTION_DELTA:
+		case INSTRUCTION_ABS:
+		{
+			uint16_t pc = next_pc;
+			if(tag == INSTRUCTION_DELTA)
+			{
+				uint8_t delta = 0;
+				ok = reader.readByte(delta);
+				pc = next_pc + (int8_t)delta;
+			}
+			else if(tag == INSTRUCTION_ABS)
+			{
+				ok = reader.readShort(pc);
+			}
+
+			uint8_t bytes[3] = {0, 0, 0};
+			ok = ok && reader.readByte(bytes[0]);
+			uint8_t length = gbstructs::OPCODE_INFO[bytes[0]].length;
+			for(int i = 1; i < length; i++)
+			{
+				ok = ok && reader.readByte(bytes[i]);
+			}
+
+			text.append(fmt::format("${:04X}: {}\n", pc,
+					gbstructs::disassemble(bytes[0], bytes[1], bytes[2])));
+
+			next_pc = pc + length;
+			instructions++;
+			break;
+		}
+
+		case REGISTERS:
+		{
+			gbstructs::RegisterSet regs{};
+			ok = reader.readShort(regs.af) && reader.readShort(regs.bc)
+				 && reader.readShort(regs.de) && reader.readShort(regs.hl)
+				 && reader.readShort(regs.sp) && reader.readShort(regs.pc);
+
+			text.append(fmt::format("       {}\n",
+									gbstructs::registerToString(regs)));
+
+			next_pc = regs.pc;
+			break;
+		}
+
+		case MEMORY_WRITE:
+		{
+			uint16_t address = 0;
+			uint8_t value = 0;
+			ok = reader.readShort(address) && reader.readByte(value);
+
+			text.append(fmt::format("       [${:04X}] <- 0x{:02X}\n",
+									address, value));
+			break;
+		}
+
+		default:
+		{
+			std::cerr << fmt::format("ERROR: Unknown record 0x{:02X} at "
+									 "offset {}.\n",
+									 tag, std::ftell(input) - 1);
+			return 65;
+		}
+		}
+
+		if(!ok)
+		{
+			std::cerr << "WARNING: Trace ends partway through a record.\n";
+			break;
+		}
+
+		// Write out in large blocks
+		if(text.size() > (1 << 16))
+		{
+			std::fwrite(text.data(), 1, text.size(), output);
+			text.clear();
+		}
+	}
+
+	std::fwrite(text.data(), 1, text.size(), output);
+	std::fclose(input);
+	if(output != stdout)
+	{
+		std::fclose(output);
+	}
+
+	std::cerr << instructions << " instructions.\n";
+	return 0;
+}
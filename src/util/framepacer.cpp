@@ -0,0 +1,107 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : util/framepacer.cpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Paces emulated frames to the wall clock, for real-time output
+ ******************************************************************************/
+
+#include "framepacer.hpp"
+
+#include <thread>
+
+// Constructor
+FramePacer::FramePacer(uint64_t cycles_per_frame, uint64_t clock_hz)
+{
+	this->cycles_per_frame = cycles_per_frame;
+	this->clock_hz = clock_hz;
+
+	skipped_frames = 0;
+	skipped_time = std::chrono::nanoseconds(0);
+	start();
+}
+
+
+
+// Starts pacing from now
+void FramePacer::start()
+{
+	epoch = Clock::now();
+	frame_index = 0;
+}
+
+
+
+// Waits until the next frame is due
+void FramePacer::waitForNextFrame()
+{
+	frame_index++;
+	Clock::time_point deadline = epoch + frameTime(frame_index);
+	Clock::time_point now = Clock::now();
+
+	if(now >= deadline)
+	{
+		// Behind. Run the next frames back to back to catch up, unless it's so
+		// far behind that the catch up itself would be noticeable.
+		if(now - deadline > frameTime(MAX_CATCH_UP_FRAMES))
+		{
+			// Move the epoch so this frame is due now. The skipped time still
+			// counts towards the drift.
+			auto behind = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					now - deadline);
+			skipped_frames += behind / frameTime(1);
+			skipped_time += behind;
+			epoch += behind;
+		}
+		return;
+	}
+
+	// Sleep most of the way, then spin past the sleep's wake up jitter
+	if(deadline - now > SPIN_WINDOW)
+	{
+		std::this_thread::sleep_until(deadline - SPIN_WINDOW);
+	}
+
+	while(Clock::now() < deadline)
+	{
+		// Spin
+	}
+}
+
+
+
+// Gets how far the wall clock is ahead of the emulated time
+std::chrono::nanoseconds FramePacer::getDrift() const
+{
+	// Every skip moved the epoch later, so measuring from the frame's deadline
+	// misses them. Add them back.
+	auto behind = Clock::now() - (epoch + frameTime(frame_index));
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(behind)
+		   + skipped_time;
+}
+
+// Gets how many frame deadlines were given up on after stalls
+uint64_t FramePacer::getSkippedFrames() const
+{
+	return skipped_frames;
+}
+
+
+
+// Gets when a frame is due, relative to the epoch
+std::chrono::nanoseconds FramePacer::frameTime(uint64_t frame) const
+{
+	// Split into whole seconds and the remainder so that the multiply by 1e9
+	// can't overflow, however long it runs
+	uint64_t cycles = frame * cycles_per_frame;
+	uint64_t seconds = cycles / clock_hz;
+	uint64_t remainder = cycles % clock_hz;
+
+	return std::chrono::nanoseconds(seconds * 1000000000
+									+ remainder * 1000000000 / clock_hz);
+}
@@ -0,0 +1,59 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : util/framepacer.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Paces emulated frames to the wall clock, for real-time output
+ ******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Frame n is due exactly n * cycles_per_frame / clock_hz seconds after
+// start(), so rounding never adds up. Sleeps until just before each deadline,
+// then spins the rest of the way, since sleeps tend to wake late.
+class FramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Frames this far behind are given up on instead of run back to back
+	static constexpr int MAX_CATCH_UP_FRAMES = 5;
+	// How long before a deadline to stop sleeping and start spinning
+	static constexpr std::chrono::microseconds SPIN_WINDOW{500};
+
+	FramePacer(uint64_t cycles_per_frame, uint64_t clock_hz);
+
+	// Starts pacing from now. Also call after a pause, so the time spent
+	// paused isn't treated as a stall.
+	void start();
+
+	// Waits until the next frame is due. Returns right away if it already is,
+	// so that the emulation catches up after a stall.
+	void waitForNextFrame();
+
+	// Gets how far the wall clock is ahead of the emulated time, counting
+	// frames given up after stalls. Positive means the emulation is behind.
+	std::chrono::nanoseconds getDrift() const;
+	// Gets how many frame deadlines were given up on after stalls
+	uint64_t getSkippedFrames() const;
+
+private:
+	uint64_t cycles_per_frame;
+	uint64_t clock_hz;
+
+	Clock::time_point epoch; // When frame 0 was due
+	uint64_t frame_index; // The frame being waited for
+	uint64_t skipped_frames;
+	std::chrono::nanoseconds skipped_time; // Wall time given up after stalls
+
+	// Gets when a frame is due, relative to the epoch
+	std::chrono::nanoseconds frameTime(uint64_t frame) const;
+};
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 5 Dec 2022
- EDITED : 8 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -12,6 +12,9 @@
  ******************************************************************************/
 
 #include "logger.hpp"
+#include "signalblock.hpp"
+
+#include <cstring>
 
 // Constructor
 Logger::Logger()
@@ -64,12 +67,37 @@ Logger::Logger()
 	log_level = EXTREME;
 	log_to_console = true;
 	log_to_file = true;
+	overflow_policy = DROP;
+
+	// Every slot starts free for the producer position it maps to
+	queue = std::make_unique<Slot[]>(QUEUE_CAPACITY);
+	for(size_t i = 0; i < QUEUE_CAPACITY; i++)
+	{
+		queue[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	enqueue_pos.store(0);
+	dequeue_pos = 0;
+	written_pos.store(0);
+	dropped_amount.store(0);
+
+	writer_sleeping.store(false);
+	running.store(true);
+	{
+		// Exit signals are handled on the main thread
+		ExitSignalBlock block;
+		writer = std::thread(&Logger::writerLoop, this);
+	}
 }
 
 
 // Destructor
 Logger::~Logger()
 {
+	// The writer drains the ring before it returns
+	running.store(false);
+	wake.notify_one();
+	writer.join();
+
 	// Close LogFile before destroying self
 	LogFile.close();
 }
@@ -92,6 +120,23 @@ bool Logger::isLogFileOpen()
 
 
 
+// Sets what log() does when the ring is full
+void Logger::setOverflowPolicy(OverflowPolicy policy)
+{
+	overflow_policy = policy;
+}
+
+
+// Sets if messages are written to the console as well as the LogFile
+void Logger::setConsoleOutput(bool enabled)
+{
+	// The writer thread only checks it while holding this
+	std::lock_guard<std::mutex> lock(output_mutex);
+	log_to_console = enabled;
+}
+
+
+
 // Logs a message with a default level (verbose)
 void Logger::log(std::string message)
 {
@@ -103,33 +148,224 @@ void Logger::log(std::string message)
 // Logs a message with the given level
 void Logger::log(std::string message, LogLevel level)
 {
-	if(level <= log_level)
+	if(level > log_level)
+	{
+		return;
+	}
+
+	if(message.size() > sizeof(LogRecord::text))
+	{
+		// Too long for a record, like memory dumps. Write it directly, once
+		// everything before it is out.
+		flush();
+
+		std::string line = "[" + getTimestamp(std::chrono::system_clock::now())
+						   + "] " + message + "\n";
+		std::lock_guard<std::mutex> lock(output_mutex);
+		writeOutput(line);
+		return;
+	}
+
+	// Errors are never dropped
+	bool block = overflow_policy == BLOCK || level == ERRORS;
+	if(!enqueue(message, block))
+	{
+		dropped_amount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+
+// Waits until everything logged so far has been written
+void Logger::flush()
+{
+	size_t target = enqueue_pos.load(std::memory_order_acquire);
+
+	while(written_pos.load(std::memory_order_acquire) < target)
+	{
+		wake.notify_one();
+		std::this_thread::yield();
+	}
+}
+
+
+
+// Copies a message into the ring. Returns false if it was dropped.
+bool Logger::enqueue(const std::string& message, bool block)
+{
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	Slot* slot = nullptr;
+
+	// Claim a position whose slot is free
+	while(true)
 	{
-		if(log_to_console)
+		slot = &queue[pos & QUEUE_MASK];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+
+		if(difference == 0)
+		{
+			if(enqueue_pos.compare_exchange_weak(pos, pos + 1,
+												 std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(difference < 0)
 		{
-			std::cout << "[" << getTimestamp() << "] ";
-			std::cout << message << "\n";
+			// Full, the writer hasn't freed this slot from the last lap
+			if(!block)
+			{
+				return false;
+			}
+
+			wake.notify_one();
+			std::this_thread::yield();
+			pos = enqueue_pos.load(std::memory_order_relaxed);
 		}
-		if(log_to_file)
+		else
 		{
-			LogFile << "[" << getTimestamp() << "] ";
-			LogFile << message << "\n";
+			// Another producer claimed it first
+			pos = enqueue_pos.load(std::memory_order_relaxed);
 		}
 	}
+
+	LogRecord& record = slot->record;
+	record.time = std::chrono::system_clock::now();
+	record.length = message.size();
+	std::memcpy(record.text, message.data(), message.size());
+
+	// Hand the slot to the writer
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	if(writer_sleeping.load(std::memory_order_relaxed))
+	{
+		wake.notify_one();
+	}
+
+	return true;
 }
 
 
 
-// Gets a timestamp. Used in log()
-std::string Logger::getTimestamp()
+// Formats and writes everything in the ring
+bool Logger::drainQueue(std::string& batch)
+{
+	batch.clear();
+	size_t start_pos = dequeue_pos;
+
+	// Timestamps only have second resolution, so most batches format one
+	std::chrono::system_clock::time_point last_second{};
+	std::string timestamp;
+
+	while(true)
+	{
+		Slot& slot = queue[dequeue_pos & QUEUE_MASK];
+		if(slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+		{
+			break; // Empty, or the next producer isn't done copying yet
+		}
+
+		LogRecord& record = slot.record;
+		auto second = std::chrono::floor<std::chrono::seconds>(record.time);
+		if(timestamp.empty() || second != last_second)
+		{
+			last_second = second;
+			timestamp = getTimestamp(record.time);
+		}
+
+		batch += '[';
+		batch += timestamp;
+		batch += "] ";
+		batch.append(record.text, record.length);
+		batch += '\n';
+
+		// Free the slot for the producer one lap ahead
+		slot.sequence.store(dequeue_pos + QUEUE_CAPACITY,
+							std::memory_order_release);
+		dequeue_pos++;
+	}
+
+	uint64_t dropped = dropped_amount.exchange(0, std::memory_order_relaxed);
+	if(dropped > 0)
+	{
+		batch += fmt::format("[{}] LOG: Dropped {} messages, the queue was "
+							 "full.\n",
+							 getTimestamp(std::chrono::system_clock::now()),
+							 dropped);
+	}
+
+	if(!batch.empty())
+	{
+		std::lock_guard<std::mutex> lock(output_mutex);
+		writeOutput(batch);
+	}
+
+	written_pos.store(dequeue_pos, std::memory_order_release);
+	return dequeue_pos != start_pos;
+}
+
+
+
+// Writes formatted text to the console and LogFile
+void Logger::writeOutput(const std::string& text)
+{
+	if(log_to_console)
+	{
+		std::cout.write(text.data(), text.size());
+		std::cout.flush();
+	}
+	if(log_to_file)
+	{
+		LogFile.write(text.data(), text.size());
+		LogFile.flush();
+	}
+}
+
+
+
+// Writer thread loop
+void Logger::writerLoop()
+{
+	std::string batch;
+	batch.reserve(QUEUE_CAPACITY * 64);
+
+	while(running.load())
+	{
+		if(drainQueue(batch))
+		{
+			continue;
+		}
+
+		// Nothing queued. Sleep until a producer wakes this up. The timeout
+		// covers a wake up that lands between the check and the wait.
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		writer_sleeping.store(true);
+		wake.wait_for(lock, std::chrono::milliseconds(50));
+		writer_sleeping.store(false);
+	}
+
+	// Flush on exit
+	drainQueue(batch);
+}
+
+
+
+// Gets a timestamp. Used by the writer thread.
+std::string Logger::getTimestamp(std::chrono::system_clock::time_point time)
 {
 	// Get time and convert it to local time
-	time_t now = time(0);
-	tm *ltime = localtime(&now);
+	time_t now = std::chrono::system_clock::to_time_t(time);
+	tm ltime{};
+#ifdef _WIN32
+	localtime_s(&ltime, &now);
+#else
+	localtime_r(&now, &ltime);
+#endif
 
 	// Format local time as a string
 	std::string output = fmt::format("{:02d}:{:02d}:{:02d}",
-					ltime->tm_hour, ltime->tm_min, ltime->tm_sec);
+					ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
 
 	return output;
 }
@@ -4,7 +4,7 @@
  AUTHOR : ImpendingMoon
  EDITORS: ImpendingMoon,
  CREATED: 5 Dec 2022
- EDITED : 7 Dec 2022
+ EDITED : 17 Oct 2026
  ******************************************************************************/
 
 /******************************************************************************
@@ -16,11 +16,49 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <fmt/core.h>
 
+// Log calls above this level are compiled out by ASCIIBOY_LOG. Builds with
+// NDEBUG keep up to VERBOSE, so the MMU and CPU hot paths log nothing.
+// Override with -DASCIIBOY_MAX_LOG_LEVEL=<0-4>.
+#ifndef ASCIIBOY_MAX_LOG_LEVEL
+#ifdef NDEBUG
+#define ASCIIBOY_MAX_LOG_LEVEL 2 // Logger::VERBOSE
+#else
+#define ASCIIBOY_MAX_LOG_LEVEL 4 // Logger::EXTREME
+#endif
+#endif
+
+// Logs a fmt format string at a Logger::LogLevel, e.g.
+// ASCIIBOY_LOG(EXTREME, "MEM: Reading value from ${:04X}.", address);
+// The arguments are only evaluated and formatted if the level is both compiled
+// in and enabled.
+#define ASCIIBOY_LOG(level, ...) \
+	do { \
+		if constexpr(Logger::level <= ASCIIBOY_MAX_LOG_LEVEL) \
+		{ \
+			if(Logger::instance().isEnabled(Logger::level)) \
+			{ \
+				Logger::instance().log(fmt::format(__VA_ARGS__), \
+									   Logger::level); \
+			} \
+		} \
+	} while(false)
+
 // Logger is a singleton that handles writing to console/logfile
 // NOTE: Creation is not thread-safe, but is called in main() before anything
 // else is started, so it should be fine for this program.
+//
+// log() only copies the message into a lock-free ring of fixed-size records.
+// A background thread timestamps, formats, and writes them out in batches.
+// Messages too long for a record are written directly, after everything
+// queued before them.
 class Logger
 {
 private:
@@ -28,8 +66,29 @@ private:
 	Logger();
 	virtual ~Logger();
 
-	// Gets a timestamp. Used in log()
-	std::string getTimestamp();
+	// One queued message. Fixed-size, so queuing never allocates.
+	static constexpr size_t RECORD_SIZE = 256;
+	struct LogRecord
+	{
+		std::chrono::system_clock::time_point time;
+		uint16_t length;
+		char text[RECORD_SIZE - sizeof(std::chrono::system_clock::time_point)
+				  - sizeof(uint16_t)];
+	};
+
+	// A ring slot. sequence says whose turn the slot is (Vyukov's bounded
+	// queue): equal to a producer's position when free, one past it when full.
+	struct alignas(64) Slot
+	{
+		std::atomic<size_t> sequence;
+		LogRecord record;
+	};
+
+	static constexpr size_t QUEUE_CAPACITY = 8192; // Power of two
+	static constexpr size_t QUEUE_MASK = QUEUE_CAPACITY - 1;
+
+	// Gets a timestamp. Used by the writer thread.
+	std::string getTimestamp(std::chrono::system_clock::time_point time);
 
 	std::string log_file_path;
 	std::ofstream LogFile;
@@ -37,6 +96,32 @@ private:
 	int log_level;
 	bool log_to_console;
 	bool log_to_file;
+	int overflow_policy;
+
+	// The ring. Producers claim positions from enqueue_pos, the writer thread
+	// is the only one moving dequeue_pos.
+	std::unique_ptr<Slot[]> queue;
+	alignas(64) std::atomic<size_t> enqueue_pos;
+	alignas(64) size_t dequeue_pos;
+	std::atomic<size_t> written_pos; // Every message before this is written
+	std::atomic<uint64_t> dropped_amount;
+
+	// Writer thread
+	std::thread writer;
+	std::atomic<bool> running;
+	std::atomic<bool> writer_sleeping;
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::mutex output_mutex; // Held while writing to the console/LogFile
+
+	// Copies a message into the ring. Returns false if it was dropped.
+	bool enqueue(const std::string& message, bool block);
+	// Formats and writes everything in the ring. Returns if anything was.
+	bool drainQueue(std::string& batch);
+	// Writes formatted text to the console and LogFile
+	void writeOutput(const std::string& text);
+	// Writer thread loop
+	void writerLoop();
 
 public:
 	// Gets the instanced Logger object
@@ -64,15 +149,40 @@ public:
 		// The MMU, CPU, and PPU use it to log every single operation they do.
 	};
 
+	// What log() does when the ring is full
+	enum OverflowPolicy
+	{
+		DROP = 0, // Drop the message and count it. ERRORS still block.
+		BLOCK,    // Wait for the writer thread to make room
+	};
+
 	// Actually useful functions //
 
+	// Sets what log() does when the ring is full
+	void setOverflowPolicy(OverflowPolicy policy);
+
+	// Sets if messages are written to the console as well as the LogFile.
+	// Turned off while the screen is drawn into the terminal.
+	void setConsoleOutput(bool enabled);
+
+	// Waits until everything logged so far has been written
+	void flush();
+
 	// Gets the current file path for the LogFile
 	std::string getLogFilePath();
 
 	// Returns if the LogFile is open
 	bool isLogFileOpen();
 
-	// Logs a message with the given level
+	// Returns if messages of a level are output. Inline, so checking it before
+	// formatting a message is cheap.
+	bool isEnabled(LogLevel level) const
+	{
+		return level <= log_level;
+	}
+
+	// Logs a message with the given level. Prefer ASCIIBOY_LOG for formatted
+	// messages, since this takes the message already formatted.
 	void log(std::string message, LogLevel level);
 
 	// Logs a message with a default level (Verbose
@@ -0,0 +1,56 @@
+/******************************************************************************
+ PROJECT: ASCII-Boy
+ PATH   : util/signalblock.hpp
+ AUTHOR : ImpendingMoon
+ EDITORS: ImpendingMoon,
+ CREATED: 17 Oct 2026
+ EDITED : 17 Oct 2026
+ ******************************************************************************/
+
+/******************************************************************************
+ Keeps exit signals off of background threads
+ ******************************************************************************/
+
+#pragma once
+
+#include <csignal>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// Blocks SIGINT and SIGTERM on the calling thread while it exists. A thread
+// inherits its creator's mask, so threads started inside its scope never
+// receive them, and exit signals always go to the main thread.
+//
+// On Windows the CRT runs signal handlers on a thread of their own, so there
+// is nothing to block.
+class ExitSignalBlock
+{
+public:
+	ExitSignalBlock()
+	{
+#ifndef _WIN32
+		sigset_t exit_signals;
+		sigemptyset(&exit_signals);
+		sigaddset(&exit_signals, SIGINT);
+		sigaddset(&exit_signals, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &exit_signals, &previous);
+#endif
+	}
+
+	~ExitSignalBlock()
+	{
+#ifndef _WIN32
+		pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+#endif
+	}
+
+	ExitSignalBlock(const ExitSignalBlock&) = delete;
+	ExitSignalBlock& operator=(const ExitSignalBlock&) = delete;
+
+private:
+#ifndef _WIN32
+	sigset_t previous;
+#endif
+};